@@ -23,11 +23,14 @@ Version 2.2.0 - November 15, 2019
  */
 
 #include "alphafive.h"
+#include <avr/boot.h>   // SPM commands, for the flash store
+#include <util/twi.h>   // TWI status codes
 
 // Stored data (including global arrays) take up roughly 20% of our 4096 bytes of SRAM.
 //
-// Note 1: While it is obviously possible to store font tables in program flash, storing it in SRAM
-//   allows characters to be redefined on the fly, in software.
+// Note 1: The font table is in program flash (PROGMEM).  Characters can still be redefined on the fly:
+//   a5editFontChar() keeps up to a5_FONTPATCHES edited glyphs in a small SRAM patch table, and glyph
+//   banks (a5setGlyphBank()) swap in whole runs of characters, e.g., the numeral styles, by pointer.
 // Note 2: Retreving things from Progmem takes time.  Yes, SRAM is a precious resource, but so is CPU time.
 // Note 3: We are using multiple video buffers to smooth off-screen drawing, and to enable
 //   real-time fades between complete, arbitrary-brightness video buffer sets.
@@ -37,16 +40,113 @@ Version 2.2.0 - November 15, 2019
 
 
 // The Video Buffer takes up 90 bytes of SRAM. (That's about 2% of our available 4096 bytes.)
-#define a5_VIDBUFLENGTH 90
-byte a5_vidBuf[a5_VIDBUFLENGTH];       // Array contains brightness of individual segments (5 * 18 segments = 90)
+byte a5_vidBuf[a5_VIDBUFLENGTH];       // Array contains brightness of individual segments (a5_CHARS * 18 segments = 90)
 
-// Off-screen buffer ("a5_OSB") takes an additional 90 bytes of SRAM. It's used for fading and compositing.
-int8_t a5_OSB[a5_VIDBUFLENGTH];
+/*
+ Off-screen buffer ("a5_OSB") takes an additional 90 bytes of SRAM. It's used for fading and compositing.
+ Three additional off-screen buffers for automatic grayscale fades.  270 bytes for these three, together.
+ 
+ With a5_PACKED_BUFFERS defined (see alphafive.h), each of these four buffers holds the 5-bit brightness
+ levels in 57 bytes instead of 90: the low four bits of each segment, two segments per byte (low nibble
+ first), followed by a plane of 12 bytes holding the fifth bit of each segment. That saves 132 bytes.
+ The video buffer itself is never packed, since the display refresh interrupt reads it constantly.
+ Always use a5getLevel() and a5setLevel() to access these buffers; whole buffers can be copied with memcpy().
+ */
+
+#ifdef a5_PACKED_BUFFERS
+
+#define a5_NIBBLEBYTES (a5_VIDBUFLENGTH / 2)  // Low four bits of each segment, followed by the fifth bits.
+typedef byte a5_level_t;
+
+static inline int8_t a5getLevel (const byte buf[], byte segment)
+{
+    byte level = buf[segment >> 1];
+    if (segment & 1)
+        level = level >> 4;
+    else
+        level &= 15;
+    if (buf[a5_NIBBLEBYTES + (segment >> 3)] & (1 << (segment & 7)))
+        level |= 16;
+    return level;
+}
+
+static inline void a5setLevel (byte buf[], byte segment, int8_t level)
+{
+    byte *nibblePtr = &buf[segment >> 1];
+    byte *highPtr = &buf[a5_NIBBLEBYTES + (segment >> 3)];
+    byte mask = 1 << (segment & 7);
+    
+    if (segment & 1)
+        *nibblePtr = (*nibblePtr & 15) | (level << 4);
+    else
+        *nibblePtr = (*nibblePtr & 240) | (level & 15);
+    
+    if (level & 16)
+        *highPtr |= mask;
+    else
+        *highPtr &= ~mask;
+}
+
+/*
+ The fade and video buffer loops work through packed buffers eight segments at a time:
+ four bytes of nibbles, and one byte of the fifth-bit plane. There are 12 groups; the last has two segments.
+ */
+#define a5_GROUPS ((a5_VIDBUFLENGTH + 7) / 8)
+
+static inline byte a5unpackGroup (const byte buf[], byte group, int8_t levels[])
+{
+    // Unpack segments (8 * group) through (8 * group + 7) into levels[]; return how many there are.
+    byte count = a5_VIDBUFLENGTH - 8 * group;
+    if (count > 8)
+        count = 8;
+    
+    const byte *nibblePtr = &buf[4 * group];
+    byte high = buf[a5_NIBBLEBYTES + group];
+    
+    for (byte k = 0; k < count; k += 2)
+    {
+        byte nibbles = *nibblePtr++;
+        levels[k] = (nibbles & 15) | ((high & 1) << 4);
+        levels[k + 1] = (nibbles >> 4) | ((high & 2) << 3);
+        high = high >> 2;
+    }
+    return count;
+}
+
+static inline void a5packGroup (byte buf[], byte group, const int8_t levels[], byte count)
+{
+    byte *nibblePtr = &buf[4 * group];
+    byte high = 0;
+    
+    for (byte k = 0; k < count; k += 2)
+    {
+        *nibblePtr++ = (levels[k] & 15) | (levels[k + 1] << 4);
+        high |= ((levels[k] >> 4) & 1) << k;
+        high |= ((levels[k + 1] >> 4) & 1) << (k + 1);
+    }
+    buf[a5_NIBBLEBYTES + group] = high;
+}
 
-// Three additional off-screen buffers for automatic grayscale fades.  271 bytes for these three, together.
-int8_t a5_LastOSB[a5_VIDBUFLENGTH];  // Cache of last OSB
-int8_t a5_FadeFrom[a5_VIDBUFLENGTH]; // Snapshot of what we're fading away from.
-int8_t a5_FadeTo[a5_VIDBUFLENGTH];   // Snapshot of what we're fading towards.
+#else
+
+typedef int8_t a5_level_t;
+
+static inline int8_t a5getLevel (const int8_t buf[], byte segment)
+{
+    return buf[segment];
+}
+
+static inline void a5setLevel (int8_t buf[], byte segment, int8_t level)
+{
+    buf[segment] = level;
+}
+
+#endif
+
+a5_level_t a5_OSB[a5_OSBLENGTH];
+a5_level_t a5_LastOSB[a5_OSBLENGTH];  // Cache of last OSB
+a5_level_t a5_FadeFrom[a5_OSBLENGTH]; // Snapshot of what we're fading away from.
+a5_level_t a5_FadeTo[a5_OSBLENGTH];   // Snapshot of what we're fading towards.
 int8_t a5_FadeStage;
 
 /*  EEPROM storage: settings variables and default values for those variables  */
@@ -56,9 +156,24 @@ byte a5_EEvalues[a5_EELength];
 // Internal state variables used by refresh interrupt
 volatile byte a5_intensityStep;
 volatile byte a5_litChar;
+#define a5_ENGINE_GRAY      0
+#define a5_ENGINE_HYBRID    1
+#define a5_ENGINE_OVERDRIVE 2
+volatile byte a5_scanEngine;     // Scan engine presently running; see a5selectEngine()
+
+// Hundredths of a second, counted by the refresh interrupt; see a5getHundredths().
+// a5_hundredthPhase counts CPU cycles since the last hundredth, in units of 10 cycles.
+#define a5_HUNDREDTH_PHASE  16000    // 10 ms at 16 MHz
+volatile unsigned long a5_hundredths;
+volatile unsigned int a5_hundredthPhase;
+
+#ifdef a5_TRACE_LATENCY
+volatile byte a5_traceLatchArmed;
+volatile unsigned long a5_traceLatchTime;
+#endif
 
 int8_t a5_brightLevel;
-byte a5_brightMode;  // 0: low brightness mode. 1: Medium. 2: High brightness mode
+byte a5_brightMode;  // 0: low brightness mode. 1: Medium. 2: High brightness mode. 3: a5_HybridScanMode. 4: a5_OverdriveMode
 
 // For tone duration:
 volatile long a5_timer1_toggle_count;
@@ -139,13 +254,110 @@ byte a5_BLUT[] = {
     8,10,11,13,15};
 
 
+/*
+ In the hybrid scan mode (a5_brightMode == a5_HybridScanMode), each video buffer entry is a full byte:
+ the low nibble sets how many of 15 in-interrupt ("sub") pulses the segment gets, and the high nibble
+ sets how many of 15 between-interrupt ("base") periods it stays lit. Since 15 sub pulses give slightly
+ less light than one base period, the byte value itself is a near-linear intensity scale, 0-255.
+ This table maps the 20 brightness levels onto it exponentially: y = 255^((x-1)/18), rounded.
+ */
+
+byte a5_HBLUT[] = {
+    0,1,1,2,3,
+    3,5,6,9,12,
+    16,22,30,40,55,
+    75,102,138,188,255};
+
+
+static inline byte *a5currentBLUT (void)
+{
+    // Brightness look-up table for the present scan mode
+    if (a5_brightMode == a5_HybridScanMode)
+        return a5_HBLUT;
+    return a5_BLUT;
+}
+
+
+/*
+ Inverse of a5_BLUT[], for a5loadOSB_Nibbles(): maps 4-bit intensities (0-15) to the
+ brightness level whose a5_BLUT[] entry is nearest (the dimmer level, in case of a tie).
+ a5_BLUT[] has no entries of 9, 12 or 14, so intensities 8 and 9, 11 and 12, and 13 and 14
+ share a level: 13 distinct levels in all.
+ */
+
+byte a5_NibbleLevel[] = {
+    0,1,5,8,
+    10,12,13,14,
+    15,15,16,17,
+    17,18,18,19};
+
+
+#ifdef a5_DITHER
+/*
+ Temporal dithering (a5_DITHER): a5_DLUT[] gives each brightness level's intensity in eighths, from the
+ y column of the a5_BLUT[] table above, rounded. a5loadVidBuf_fromOSB() stores the result in a5_ditherBuf[]
+ as a level (low nibble) plus a fraction (high nibble, 0-7), and the refresh interrupt lights the segment
+ one level brighter in that many of every eight frames. Each row starts the cycle one frame after the one
+ before it, and the frames run in bit-reversed order, so that halves and quarters alternate as fast as they can.
+ 
+ In the hybrid scan mode, a5_HDLUT[] does the same for the levels below a5_HDITHERLEVELS, from the curve of
+ a5_HBLUT[], whose low end (0,1,1,2,3,3) only has whole pulses to work with; the brighter levels already
+ have steps of at least a sixth, and are marked a5_DITHER_NONE in a5_ditherBuf[]: left as loaded.
+ */
+
+byte a5_DLUT[] = {
+    0,6,8,9,10,
+    14,16,19,22,26,
+    30,35,41,48,56,
+    65,76,88,103,120};
+
+#define a5_HDITHERLEVELS 10
+#define a5_DITHER_NONE 128
+
+byte a5_HDLUT[a5_HDITHERLEVELS] = {
+    0,8,11,15,20,
+    27,37,51,69,94};
+
+// Per frame of the cycle: (fraction below which the segment stays at its level) << 4.
+const byte a5_DitherThreshold[8] = { 16, 80, 48, 112, 32, 96, 64, 128 };
 
-// The font table takes up 70*3 = 210 bytes of SRAM.  We store the array in RAM so that it is
-// *fully editable during runtime*.
-// If you want to have full multiple font sets, store those sets in PROGMEM and load only one into RAM.
-// The last 5 characters (ascii 'a' - 'e') are extra buffer to store special characters.
+byte a5_ditherEnable = 1;
+byte a5_ditherBuf[a5_VIDBUFLENGTH];
+volatile byte a5_ditherRows;    // One bit per row (character): set if any of its segments has a fraction
+volatile byte a5_ditherPhase;   // Frame of the cycle, 0-7
 
-byte a5_FontTable[] = {
+static inline byte a5ditherThreshold (byte row)
+{
+    return a5_DitherThreshold[(a5_ditherPhase + row) & 7];
+}
+#endif
+
+static inline void a5stopDither (void)
+{
+    // The video buffer is about to be loaded directly: stop the refresh interrupt dithering it.
+#ifdef a5_DITHER
+    a5_ditherRows = 0;
+#endif
+}
+
+
+
+/*
+ Font table: three bytes (A, B, C) per character, for ASCII 32 (space) through 126 ('~'), plus
+ a few extra glyphs (a5_GLYPH_DEGREE and following), 297 bytes in all. The table lives in flash (PROGMEM);
+ a5editFontChar() doesn't write to it, but stores the new glyph in a small RAM patch table,
+ a5_FontPatch[], and marks the character in a5_FontEdited[]. Lookups check that one bit (only
+ while a5_FontEdits is nonzero), and read flash for characters that haven't been edited.
+ 
+ Segment bits:  A: 1, 2: top (left, right half)     4, 8: bottom (left, right)
+                   16, 32: middle (left, right)    64, 128: lower and upper decimal points
+                B: 1: center, lower half           2: lower-left diagonal
+                C: 1, 2: right side (upper, lower)  4, 8: left side (lower, upper)
+                   16: upper-left diagonal  32: center, upper half
+                   64: upper-right diagonal  128: lower-right diagonal
+ */
+
+const byte a5_FontTable_P[] PROGMEM = {
     0,0,0,    // [space]  ASCII 32
     0,0,3,    // ! (Yes, lame, but it's the "standard." Better Suggestions welcome.)
     0,0,40,  // "
@@ -211,13 +423,152 @@ byte a5_FontTable[] = {
     0,2,128,      // ^
     12,0,0,      // _
     0,0,16,        // `
-    0,0,0,    // [available for use as special char]  ASCII 'a'
-    0,0,0,    // [available for use as special char]  ASCII 'b'
-    0,0,0,    // [available for use as special char]  ASCII 'c'
-    0,0,0,    // [available for use as special char]  ASCII 'd'
-    0,0,0     // [available for use as special char]  ASCII 'e'
+    28,1,4,       //a
+    60,0,14,      //b
+    60,0,4,       //c
+    60,0,7,       //d
+    28,2,4,       //e
+    50,1,32,      //f
+    59,0,11,      //g
+    48,0,14,      //h
+    0,1,0,        //i
+    4,1,0,        //j
+    0,1,224,      //k
+    0,0,12,       //l
+    48,1,6,       //m
+    48,0,6,       //n
+    60,0,6,       //o
+    17,0,44,      //p
+    34,0,35,      //q
+    48,0,4,       //r
+    24,0,128,     //s
+    28,0,12,      //t
+    12,0,6,       //u
+    0,2,4,        //v
+    0,2,134,      //w
+    0,2,208,      //x
+    60,0,11,      //y
+    28,2,0,       //z
+    26,1,32,      // {
+    0,1,32,       // |
+    37,1,32,      // }
+    16,0,64,      // ~
+    17,0,40,      // degree sign     (a5_GLYPH_DEGREE, 127)
+    63,3,255,     // all segments    (a5_GLYPH_BLOCK, 128)
+    0,1,112,      // up arrow        (a5_GLYPH_UP, 129)
+    0,3,160       // down arrow      (a5_GLYPH_DOWN, 130)
+};
+
+#define a5_FONTCHARS ((int) (sizeof(a5_FontTable_P) / 3))   // Number of characters in the font table
+
+byte a5_FontEdited[(a5_FONTCHARS + 7) / 8];   // One bit per character: set if it has a patch
+byte a5_FontPatch[a5_FONTPATCHES][4];         // Edited characters: ASCII code (0: slot free), A, B, C
+byte a5_FontEdits;                            // Slots of a5_FontPatch in use
+
+
+/*
+ Glyph banks: contiguous tables of glyphs (A, B, C for each character) for a run of characters,
+ which replace those characters of the font while selected with a5setGlyphBank().  Only the
+ pointer is stored, so that selecting a bank takes constant time; the table stays where it is,
+ in flash (the numeral styles below, or a record of the flash store) or in the caller's RAM.
+ There are a5_GLYPHBANKS slots; a5_NUMBERBANK holds the numeral style of a5loadAltNumbers(),
+ and a5_USERBANK is free for anything else.  Where banks overlap, the higher slot wins, and
+ a5editFontChar() patches win over both.
+ */
+
+struct a5_GlyphBank {
+    const byte *glyphs;   // A, B, C for each character
+    byte first;           // ASCII code of the first character
+    byte count;           // Characters in the bank; 0: slot unused
+    byte inFlash;         // 1: glyphs are in program memory
+};
+
+a5_GlyphBank a5_glyphBanks[a5_GLYPHBANKS];
+byte a5_bankFirst, a5_bankSpan;   // The characters that any bank covers lie within first .. first + span - 1
+
+// Numeral styles for a5loadAltNumbers(): '0' through '9' of each, a5_NUMBERSTYLES in all.
+const byte a5_NumberBanks_P[] PROGMEM = {
+    15,0,15, 0,0,3, 63,0,5, 47,0,3, 48,0,11, 63,0,10, 63,0,14, 3,0,3, 63,0,15, 63,0,11,      // 0: Default
+    15,2,79, 0,0,3, 63,0,5, 47,0,3, 48,0,11, 63,0,10, 63,0,14, 3,0,3, 63,0,15, 63,0,11,      // 1: Default, slashed zero
+    15,0,15, 0,0,3, 63,0,5, 47,0,66, 48,0,11, 63,0,10, 63,0,14, 3,1,64, 63,0,15, 63,0,11,    // 2: Curvy 3, top-angle 7
+    15,2,79, 0,0,3, 63,0,5, 47,0,66, 48,0,11, 63,0,10, 63,0,14, 3,1,64, 63,0,15, 63,0,11,    // 3: As 2, slashed zero
+    15,0,15, 0,0,67, 63,0,5, 47,0,66, 48,0,11, 63,0,10, 63,0,14, 51,1,64, 63,0,15, 63,0,11,  // 4: "Euro-style" 1, 3, 7
+    15,2,79, 0,0,67, 63,0,5, 47,0,66, 48,0,11, 63,0,10, 63,0,14, 51,1,64, 63,0,15, 63,0,11,  // 5: As 4, slashed zero
+    15,0,15, 0,0,67, 47,2,1, 47,0,66, 48,0,11, 31,0,136, 63,0,14, 51,1,64, 63,0,15, 63,0,11, // 6: As 4, curvy 2 & 5
+    15,2,79, 0,0,67, 47,2,1, 47,0,66, 48,0,11, 31,0,136, 63,0,14, 51,1,64, 63,0,15, 63,0,11, // 7: As 6, slashed zero
+    10,1,35, 0,0,3, 42,1,1, 42,0,3, 32,0,35, 42,0,34, 42,1,34, 2,0,3, 42,1,35, 42,0,35,      // 8: Skinny A
+    10,1,35, 0,0,67, 42,1,1, 42,0,66, 32,0,35, 42,0,34, 42,1,34, 2,0,3, 42,1,35, 42,0,35     // 9: Skinny B: serif 1, curvy 3
 };
 
+const byte a5_BitMask_P[8] PROGMEM = {1,2,4,8,16,32,64,128};
+
+
+static inline void a5baseGlyph (char asciiChar, byte index, byte glyph[]) __attribute__((always_inline));
+static inline void a5baseGlyph (char asciiChar, byte index, byte glyph[])
+{
+    // The glyph of a character (index: its place in the font table) without any patch:
+    // from the highest glyph bank that holds it, or else the font table.
+    
+    const byte *fontPtr = &a5_FontTable_P[3 * index];
+    
+    if ((byte) ((byte) asciiChar - a5_bankFirst) < a5_bankSpan)
+    {   // Only characters within the banks' span need the search
+        for (byte bank = a5_GLYPHBANKS; bank-- > 0; )
+        {
+            byte offset = (byte) asciiChar - a5_glyphBanks[bank].first;
+            
+            if (offset < a5_glyphBanks[bank].count)
+            {
+                fontPtr = a5_glyphBanks[bank].glyphs + 3 * offset;
+                if (a5_glyphBanks[bank].inFlash == 0)
+                {
+                    glyph[0] = fontPtr[0];
+                    glyph[1] = fontPtr[1];
+                    glyph[2] = fontPtr[2];
+                    return;
+                }
+                break;
+            }
+        }
+    }
+    
+    glyph[0] = pgm_read_byte(fontPtr++);
+    glyph[1] = pgm_read_byte(fontPtr++);
+    glyph[2] = pgm_read_byte(fontPtr);
+}
+
+static inline void a5fontGlyph (char asciiChar, byte glyph[]) __attribute__((always_inline));
+static inline void a5fontGlyph (char asciiChar, byte glyph[])
+{
+    // Look up the three font bytes (A, B, C) for a character. Characters outside the font are blank.
+    
+    byte index = (byte) asciiChar - a5_asciiOffset;
+    
+    if (index >= a5_FONTCHARS)
+    {
+        glyph[0] = 0;
+        glyph[1] = 0;
+        glyph[2] = 0;
+        return;
+    }
+    
+    if (a5_FontEdits && (a5_FontEdited[index >> 3] & pgm_read_byte(&a5_BitMask_P[index & 7])))
+    {
+        for (byte slot = 0; slot < a5_FONTPATCHES; slot++)
+        {
+            if (a5_FontPatch[slot][0] == (byte) asciiChar)
+            {
+                glyph[0] = a5_FontPatch[slot][1];
+                glyph[1] = a5_FontPatch[slot][2];
+                glyph[2] = a5_FontPatch[slot][3];
+                return;
+            }
+        }
+    }
+    
+    a5baseGlyph(asciiChar, index, glyph);
+}
+
 
 byte a5getFontChar(char asciiChar, byte offset)
 {  // Not used in example firmware, but can be handy.
@@ -225,35 +576,117 @@ byte a5getFontChar(char asciiChar, byte offset)
 //    byte a = a5getFontChar('%',0);
 //    byte b = a5getFontChar('%',1);
 //    byte c = a5getFontChar('%',2);
-        
-    return a5_FontTable[(3 * (asciiChar - a5_asciiOffset)) + offset];
+    
+    byte glyph[3];
+    a5fontGlyph(asciiChar, glyph);
+    return glyph[offset];
+}
+
+byte a5editFontChar(char asciiChar, byte A, byte B, byte C)
+{
+    /*
+     Redefine a character of the font. Usage:  a5editFontChar ('%', 57, 3, 106);
+     
+     Up to a5_FONTPATCHES characters may differ from the built-in font at once. Setting a character
+     back to its built-in shape (or that of the glyph bank that holds it) frees its slot. Returns 1 on success, or 0 if the character is
+     outside the font, or all slots are in use (in which case the font is unchanged).
+     */
+    
+    byte index = (byte) asciiChar - a5_asciiOffset;
+    byte slot, freeSlot = a5_FONTPATCHES;
+    
+    if (index >= a5_FONTCHARS)
+        return 0;
+    
+    for (slot = 0; slot < a5_FONTPATCHES; slot++)
+    {
+        if (a5_FontPatch[slot][0] == (byte) asciiChar)
+            break;
+        if ((a5_FontPatch[slot][0] == 0) && (freeSlot == a5_FONTPATCHES))
+            freeSlot = slot;
+    }
+    
+    byte glyph[3];
+    byte mask = pgm_read_byte(&a5_BitMask_P[index & 7]);
+    
+    a5baseGlyph(asciiChar, index, glyph);
+    if ((glyph[0] == A) && (glyph[1] == B) && (glyph[2] == C))
+    {   // Back to the built-in (or glyph bank) glyph: no patch needed.
+        a5_FontEdited[index >> 3] &= ~mask;
+        if (slot < a5_FONTPATCHES)
+        {
+            a5_FontPatch[slot][0] = 0;
+            a5_FontEdits--;
+        }
+        return 1;
+    }
+    
+    if (slot == a5_FONTPATCHES)
+    {
+        if (freeSlot == a5_FONTPATCHES)
+            return 0;
+        slot = freeSlot;
+        a5_FontEdits++;
+    }
+    
+    a5_FontPatch[slot][1] = A;
+    a5_FontPatch[slot][2] = B;
+    a5_FontPatch[slot][3] = C;
+    a5_FontPatch[slot][0] = (byte) asciiChar;
+    a5_FontEdited[index >> 3] |= mask;
+    return 1;
 }
 
-void a5editFontChar(char asciiChar, byte A, byte B, byte C)
-{// Usage:  a5editFontChar ('%', 57, 3, 106);
-    if ((asciiChar >= ' ') && (asciiChar < 'f') )
-    {  
-        byte offset = (3 * (asciiChar - a5_asciiOffset));
-        a5_FontTable[offset++] = A;
-        a5_FontTable[offset++] = B;
-        a5_FontTable[offset] = C;
+void a5clearFontEdits (char first, byte count)
+{   // Undo any a5editFontChar() changes to the characters from "first" to first + count - 1.
+    
+    for (byte slot = 0; slot < a5_FONTPATCHES; slot++)
+    {
+        byte offset = a5_FontPatch[slot][0] - (byte) first;
+        
+        if ((a5_FontPatch[slot][0] != 0) && (offset < count))
+        {
+            byte index = a5_FontPatch[slot][0] - a5_asciiOffset;
+            a5_FontEdited[index >> 3] &= ~pgm_read_byte(&a5_BitMask_P[index & 7]);
+            a5_FontPatch[slot][0] = 0;
+            a5_FontEdits--;
+        }
     }
 }
 
+void a5setGlyphBank (byte slot, const byte glyphs[], char first, byte count, byte inFlash)
+{
+    /*
+     Select a glyph bank: count glyphs (three bytes each, as in the font table) for the
+     characters from "first" on, in flash (inFlash = 1) or RAM.  The table must stay in place
+     while selected.  A count of 0 empties the slot.  Usage:
+         a5setGlyphBank(a5_USERBANK, myDigits_P, '0', 10, 1);
+     */
+    
+    if (slot >= a5_GLYPHBANKS)
+        return;
+    
+    a5_glyphBanks[slot].glyphs = glyphs;
+    a5_glyphBanks[slot].first = first;
+    a5_glyphBanks[slot].count = count;
+    a5_glyphBanks[slot].inFlash = inFlash;
+    
+    // Note the span of all the banks in use, so that lookups of other characters skip the banks.
+    unsigned int low = 255, end = 0;
+    for (slot = 0; slot < a5_GLYPHBANKS; slot++)
+        if (a5_glyphBanks[slot].count)
+        {
+            if (a5_glyphBanks[slot].first < low)
+                low = a5_glyphBanks[slot].first;
+            if ((a5_glyphBanks[slot].first + a5_glyphBanks[slot].count) > end)
+                end = a5_glyphBanks[slot].first + a5_glyphBanks[slot].count;
+        }
+    a5_bankFirst = low;
+    a5_bankSpan = (end > low) ? ((end - low < 255) ? (end - low) : 255) : 0;
+}
+
 void a5loadAltNumbers (int8_t charset)
-{  // Usage:  a5loadAltNumbers(1);  // Load number characters, alt set #1
-    
-    // First, restore default number shapes.
-    a5editFontChar('0',15,0,15);   // "Square" zero, no slash
-    a5editFontChar('1',0,0,3);     // Straight 1, right side
-    a5editFontChar('2',63,0,5);    // Standard 2
-    a5editFontChar('3',47,0,3);    // Standard 3
-    a5editFontChar('4',48,0,11);   // Standard 4
-    a5editFontChar('5',63,0,10);   // Standard 5
-    a5editFontChar('6',63,0,14);   // Standard 6
-    a5editFontChar('7',3,0,3);     // Straight-side 7
-    a5editFontChar('8',63,0,15);   // Standard 8
-    a5editFontChar('9',63,0,11);   // Standard 9
+{  // Usage:  a5loadAltNumbers(1);  // Select numeral style #1 of a5_NumberBanks_P[]
     
     // Charset 0:  Default charset
     // Charset 1:  Default charset w/ Slashed Zero
@@ -265,51 +698,12 @@ void a5loadAltNumbers (int8_t charset)
     // Charset 7:  w/ "Euro-style" 1, 3, 7, curvy 2 & 5, slashed zero
     // Charset 8:  Skinny charset A
     // Charset 9:  Skinny charset B
-   
-    if ((charset & 1) && (charset <= 7))
-    {
-        a5editFontChar('0', 15,2,79);  // Slashed zero
-    }
     
-    if (charset > 1) {
-        
-        if (charset <= 3) {
-            // Alt Charset
-            a5editFontChar('3',47,0,66);   // "curvy" 3
-            a5editFontChar('7',3,1,64);    // Top-angle 7, no cross-stroke
-        }
-        else if (charset <= 5)
-        {
-            a5editFontChar('1',0,0,67);    // Serif-1
-            a5editFontChar('3',47,0,66);   // "curvy" 3
-            a5editFontChar('7',51,1,64);    // half-angle 7, w/ cross-stroke 
-        }
-        else if (charset <= 7)
-        {
-            a5editFontChar('1',0,0,67);    // Serif-1
-            a5editFontChar('2',47,2,1);    // "curvy" 2
-            a5editFontChar('3',47,0,66);   // "curvy" 3
-            a5editFontChar('5',31,0,136);   // "curvy" 5
-            a5editFontChar('7',51,1,64);    // half-angle 7, w/ cross-stroke
-        }
-        else if (charset <= 9)
-        {   // Skinny set A
-            a5editFontChar('0',10,1,35);   // "Skinny" zero, no slash
-            a5editFontChar('2',42,1,1);    // "Skinny" 2
-            a5editFontChar('3',42,0,3);    // "Skinny" 3
-            a5editFontChar('4',32,0,35);   // "Skinny" 4
-            a5editFontChar('5',42,0,34);   // "Skinny" 5
-            a5editFontChar('6',42,1,34);   // "Skinny" 6
-            a5editFontChar('7',2,0,3);     // "Skinny" 7
-            a5editFontChar('8',42,1,35);   // "Skinny" 8
-            a5editFontChar('9',42,0,35);   // "Skinny" 9
-        }
-        if (charset == 9)
-        {   // Skinny set B; two little changes to the charset 8:
-            a5editFontChar('1',0,0,67);    // Serif 1 
-            a5editFontChar('3',42,0,66);   // "curvy" 3 
-        }
-    }
+    if ((byte) charset >= a5_NUMBERSTYLES)
+        charset = 0;
+    
+    a5clearFontEdits('0', 10);    // As ever, a new style replaces any edited digits.
+    a5setGlyphBank(a5_NUMBERBANK, &a5_NumberBanks_P[30 * charset], '0', 10, 1);
 }
 
   
@@ -318,24 +712,26 @@ void a5loadAltNumbers (int8_t charset)
 
 void a5loadVidBuf_Ascii (char WordIn[], byte BrightIn)
 {
-    // Immediately update the video buffer with five ascii characters at given brightness
+    // Immediately update the video buffer with five (a5_CHARS) ascii characters at given brightness
     // Good for basic ASCII display and simple fades.
     //
     // Execution time: ~276 us total elapsed time, assuming that refresh interrupt is enabled.
     
-    byte alphaPosTemp;
+    byte glyph[3];
     byte letterByteTemp;
     byte segment = 0;
     byte i;
     byte j = 0;
     
-    byte BrightLocal = a5_BLUT[BrightIn];
+    byte BrightLocal = a5currentBLUT()[BrightIn];
+    
+    a5stopDither();
     
-    while (j < 5)
+    while (j < a5_CHARS)
     {
         
-        alphaPosTemp = 3 * (WordIn[4 - j] - a5_asciiOffset );
-        letterByteTemp = a5_FontTable[alphaPosTemp++];
+        a5fontGlyph(WordIn[a5_CHARS - 1 - j], glyph);
+        letterByteTemp = glyph[0];
         
         // It would be slightly faster-- but less compact in the code here --to unroll these loops.
         i = 1;
@@ -353,7 +749,7 @@ void a5loadVidBuf_Ascii (char WordIn[], byte BrightIn)
         }
         while (i != 0);
         
-        letterByteTemp = a5_FontTable[alphaPosTemp++];
+        letterByteTemp = glyph[1];
         if (letterByteTemp & 1)
         {
             a5_vidBuf[segment++] = BrightLocal;
@@ -372,7 +768,7 @@ void a5loadVidBuf_Ascii (char WordIn[], byte BrightIn)
             a5_vidBuf[segment++] = 0;
         }
         
-        letterByteTemp = a5_FontTable[alphaPosTemp];
+        letterByteTemp = glyph[2];
         i = 1;
         
         do {
@@ -418,28 +814,84 @@ void a5loadVidBuf_DP (char WordIn[], byte BrightIn)
     byte j = 0;
     
     char theLetter;
-    byte BrightLocal = a5_BLUT[BrightIn];
+    byte BrightLocal = a5currentBLUT()[BrightIn];
     
-    while (j < 5)
+    while (j < a5_CHARS)
     {
-        theLetter = WordIn[4 - j];
-        segment = (j * 18) + 6;
+        theLetter = WordIn[a5_CHARS - 1 - j];
+        segment = (j * a5_CHARSEGMENTS) + 6;
         
         if ((theLetter == '1') || (theLetter == '3'))
         {
             a5_vidBuf[segment] = BrightLocal;
+#ifdef a5_DITHER
+            a5_ditherBuf[segment] = (BrightLocal < 16) ? BrightLocal : a5_DITHER_NONE;  // In case this row is being dithered
+#endif
         }
         
         if ((theLetter == '2') || (theLetter == '3'))
         {
             segment++;
             a5_vidBuf[segment] = BrightLocal;
+#ifdef a5_DITHER
+            a5_ditherBuf[segment] = (BrightLocal < 16) ? BrightLocal : a5_DITHER_NONE;
+#endif
         }
         j++;
     }
 }
 
 
+#ifdef a5_DITHER
+static void a5loadVidBuf_dither (void)
+{
+    // a5loadVidBuf_fromOSB_noCache(), dithered: fill a5_ditherBuf, and the video buffer as it should be
+    // for the present frame of the cycle.
+    
+    byte rows = 0;
+    byte row = 0;
+    byte rowSegment = 0;
+    byte threshold = a5ditherThreshold(0);
+    byte hybrid = (a5_brightMode == a5_HybridScanMode);
+    
+    for (byte segment = 0; segment < a5_VIDBUFLENGTH; segment++)
+    {
+        byte osbLevel = a5getLevel(a5_OSB, segment);
+        
+        if (hybrid && (osbLevel >= a5_HDITHERLEVELS))
+        {
+            a5_ditherBuf[segment] = a5_DITHER_NONE;
+            a5_vidBuf[segment] = a5_HBLUT[osbLevel];
+        }
+        else
+        {
+            byte fine = hybrid ? a5_HDLUT[osbLevel] : a5_DLUT[osbLevel];
+            byte level = fine >> 3;
+            
+            fine = ((fine & 7) << 4) | level;
+            a5_ditherBuf[segment] = fine;
+            if (fine > 15)
+            {
+                rows |= (1 << row);
+                if (fine >= threshold)
+                    level++;
+            }
+            a5_vidBuf[segment] = level;
+        }
+        
+        if (++rowSegment == a5_CHARSEGMENTS)
+        {
+            rowSegment = 0;
+            row++;
+            threshold = a5ditherThreshold(row);
+        }
+    }
+    
+    a5_ditherRows = rows;
+}
+#endif
+
+
 void a5loadVidBuf_fromOSB_noCache (void)
 {
     // Immediately update the video buffer, loading it with the contents
@@ -447,13 +899,34 @@ void a5loadVidBuf_fromOSB_noCache (void)
     //
     // Slightly faster than a5loadVidBuf_fromOSB().
     
-    int8_t *bufPtr = &a5_OSB[0];
     byte *vPtr = &a5_vidBuf[0];
+    byte *lookup = a5currentBLUT();
+    
+#ifdef a5_DITHER
+    if (a5_ditherEnable && (a5_brightMode != 0) && (a5_brightMode != a5_OverdriveMode))
+    {
+        a5loadVidBuf_dither();
+        return;
+    }
+#endif
+    a5stopDither();
+    
+#ifdef a5_PACKED_BUFFERS
+    int8_t levels[8];
+    
+    for (byte group = 0; group < a5_GROUPS; group++)
+    {
+        byte count = a5unpackGroup(a5_OSB, group, levels);
+        for (byte k = 0; k < count; k++)
+            *vPtr++ = lookup[levels[k]];
+    }
+#else
+    int8_t *bufPtr = &a5_OSB[0];
     
     byte i = a5_VIDBUFLENGTH;
     do {
         
-        *vPtr++ = a5_BLUT[*bufPtr++];
+        *vPtr++ = lookup[*bufPtr++];
         
         // This two lines are essentially equivalent to:
         //a5vidBuf[i] = a5_BLUT[a5_OSB[i]];
@@ -462,6 +935,7 @@ void a5loadVidBuf_fromOSB_noCache (void)
         i--;
     }
     while (i > 0);
+#endif
 }
 
 
@@ -471,26 +945,131 @@ void a5loadVidBuf_fromOSB (void)
     //   of the off-screen buffer (a5_OSB).
     // Store a snapshot of the off-screen buffer (a5_OSB) in a5_LastOSB.
     
-    int8_t *bufPtr = &a5_OSB[0];
-    int8_t *OldbufPtr = &a5_LastOSB[0];
-    byte *vPtr = &a5_vidBuf[0];
+    memcpy(a5_LastOSB, a5_OSB, sizeof(a5_OSB));
+    a5loadVidBuf_fromOSB_noCache();
+}
+
+
+void a5readVidBuf (byte packedOut[])
+{
+    /*
+     Snapshot of what the display shows, for reporting: the video buffer as 4-bit intensities, two
+     segments per byte, low nibble first (a5_VIDBUFLENGTH / 2 bytes, in a5_OSB order), the inverse
+     of a5loadOSB_Nibbles() in the present brightness mode: each segment reads as the intensity whose
+     a5_NibbleLevel[] level shows nearest to it (the lower, in case of a tie). So a frame loaded with
+     a5loadOSB_Nibbles() reads back as it was sent, except that intensities which share a level
+     (9, 12 and 14) read as the one below. While the video buffer is dithered (a5_DITHER), segments
+     are read from a5_ditherBuf[], so that the snapshot of a steady display doesn't change from one
+     frame to the next.
+     */
     
-    byte i = a5_VIDBUFLENGTH;
-    do {
-        
-        *OldbufPtr++ = *bufPtr;
-        *vPtr++ = a5_BLUT[*bufPtr++];
+    byte *lookup = a5currentBLUT();
+    byte shown[16];
+    
+#ifdef a5_DITHER
+    byte dithered = (a5_ditherRows != 0);
+    byte hybrid = (a5_brightMode == a5_HybridScanMode);
+    if (dithered && !hybrid)
+        lookup = a5_DLUT;   // Compare in eighths, with a5_ditherBuf[]
+#endif
+    for (byte n = 0; n < 16; n++)
+        shown[n] = lookup[a5_NibbleLevel[n]];
+    
+    for (byte segment = 0; segment < a5_VIDBUFLENGTH; segment++)
+    {
+        byte value = a5_vidBuf[segment];
+        byte level = 0;
         
-        // These two lines are essentially equivalent to:
-        //a5_LastOSB[i] = a5_OSB[i];
-        //a5vidBuf[i] = a5_BLUT[a5_OSB[i]];
-        //i++;
+#ifdef a5_DITHER
+        if (dithered)
+        {
+            value = a5_ditherBuf[segment];
+            if (hybrid)
+            {   // Rounded to a whole a5_HBLUT[] step, which the levels below a5_HDITHERLEVELS are, rounded
+                if (value == a5_DITHER_NONE)
+                    value = a5_vidBuf[segment];
+                else
+                    value = (value & 15) + ((value >> 4) >= 4);
+            }
+            else
+                value = ((value & 15) << 3) | (value >> 4);
+        }
+#endif
+        byte nearest = value;   // Difference from shown[level]
+        for (byte n = 1; n < 16; n++)
+        {
+            byte difference = (shown[n] > value) ? (shown[n] - value) : (value - shown[n]);
+            if (difference < nearest)
+            {
+                nearest = difference;
+                level = n;
+            }
+        }
         
-        i--;
+        if (segment & 1)
+            packedOut[segment >> 1] |= level << 4;
+        else
+            packedOut[segment >> 1] = level;
     }
-    while (i > 0);
 }
 
+/*
+ Transition effects: a PROGMEM table per effect, of one byte per segment of a character (in font bit
+ order), giving the fade stage at which that segment starts to move, followed by one byte that delays
+ each character by that many stages more than the one to its left. Each segment then fades as in the
+ uniform cross-fade, just later; the whole fade takes a5_brightLevel + (largest total offset) stages.
+ 
+ Segment columns within a character, left to right:  0: left side    1: left half and left diagonals
+    2: center   3: right half and right diagonals   4: right side   5: decimal points
+ */
+
+// Wipe: segment column, then six columns per character.
+const byte a5_TransitionWipe_P[a5_CHARSEGMENTS + 1] PROGMEM = {
+    1,3,1,3,1,3,5,5,2,1,4,4,0,0,1,2,3,3,  6 };
+// Stagger: the whole character at once, four stages after the one to its left.
+const byte a5_TransitionStagger_P[a5_CHARSEGMENTS + 1] PROGMEM = {
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  4 };
+// Draw: outline clockwise from the upper left side, then the middle bars, center, diagonals and
+// decimal points, two stages apart; every character at once.
+const byte a5_TransitionDraw_P[a5_CHARSEGMENTS + 1] PROGMEM = {
+    2,4,12,10,16,18,34,32,22,30,6,8,14,0,24,20,26,28,  0 };
+
+const byte *a5_transition_P;    // Start offsets for the present effect, or NULL for the uniform cross-fade
+byte a5_transitionStep;         // Extra delay per character, left to right
+int8_t a5_transitionSpan;       // Largest start offset of any segment
+
+void a5setTransition (byte effect)
+{
+    // Select the transition used by a5BeginFadeToOSB() and a5LoadNextFadeStage(); a5_TRANSITION_FADE, etc.
+    // Takes effect at the next fade stage, even if a fade is in progress.
+    
+    const byte *table = NULL;
+    byte step = 0;
+    int8_t span = 0;
+    
+    if (effect == a5_TRANSITION_WIPE)
+        table = a5_TransitionWipe_P;
+    else if (effect == a5_TRANSITION_STAGGER)
+        table = a5_TransitionStagger_P;
+    else if (effect == a5_TRANSITION_DRAW)
+        table = a5_TransitionDraw_P;
+    
+    if (table) {
+        for (byte i = 0; i < a5_CHARSEGMENTS; i++) {
+            int8_t offset = pgm_read_byte(&table[i]);
+            if (offset > span)
+                span = offset;
+        }
+        step = pgm_read_byte(&table[a5_CHARSEGMENTS]);
+        span += step * (a5_CHARS - 1);
+    }
+    
+    a5_transition_P = table;
+    a5_transitionStep = step;
+    a5_transitionSpan = span;
+}
+
+
 void a5BeginFadeToOSB (void)
 {
     // Begin process of fading FROM the data presently shown on the LED display
@@ -498,134 +1077,162 @@ void a5BeginFadeToOSB (void)
     // The current contents of the LED display are assumed to be loaded into a5_LastOSB.
     //    (a5_LastOSB is updated each time that you call a5loadVidBuf_fromOSB.)
     
-    int8_t *OldbufPtr = &a5_LastOSB[0]; // Current display contents
-    int8_t *fromPtr = &a5_FadeFrom[0];  // Snapshot of buffer contents that we're fading away from.
-    
-    int8_t *bufPtr = &a5_OSB[0];     // Current contents of OSB
-    int8_t *toPtr = &a5_FadeTo[0];   // Snapshot of buffer contents that we're fading towards.
-    
     a5_FadeStage = 0;
     
-    byte i = a5_VIDBUFLENGTH;
-    do {
-        
-        *fromPtr++ = *OldbufPtr++;
-        *toPtr++ = *bufPtr++;
-        
-        // These two lines are essentially equivalent to:
-        //a5_FadeFrom[i] = a5_LastOSB[i];
-        //a5_FadeTo[i] = a5_OSB[i];
-        //i++;
-        
-        i--;
-    }
-    while (i > 0);
+    memcpy(a5_FadeFrom, a5_LastOSB, sizeof(a5_FadeFrom));  // Snapshot of buffer contents that we're fading away from.
+    memcpy(a5_FadeTo, a5_OSB, sizeof(a5_FadeTo));          // Snapshot of buffer contents that we're fading towards.
 }
 
 
-void a5LoadNextFadeStage (void)
+static inline int8_t a5fadeLevel (int8_t segmentBrightnessFrom, int8_t segmentBrightnessTo, int8_t stage)
 {
-    // If a fade is presently in progress, update the OSB with the next iteration.
+    // Brightness of one segment at the given fade stage.
+    
+    if (segmentBrightnessTo > segmentBrightnessFrom) {
+        int8_t temp = (segmentBrightnessFrom + stage);
+        if (segmentBrightnessTo > temp)
+            return temp;
+        return segmentBrightnessTo;
+    }
+    else // segmentBrightnessFrom > segmentBrightnessTo
+    { 
+        if (segmentBrightnessFrom > (segmentBrightnessTo + stage))
+            return segmentBrightnessFrom - stage;
+        return segmentBrightnessTo;
+    }
+}
+
+
+static inline int8_t a5segmentStage (int8_t *charStage, byte *charSegment)
+{
+    /*
+     Fade stage of the next segment, in a5_OSB order: a5_FadeStage, less that segment's start offset.
+     charStage holds a5_FadeStage less the present character's delay, and charSegment the segment
+     within the character; start them at a5_FadeStage - (a5_transitionStep * (a5_CHARS - 1)) and 0.
+     */
+    
+    if (a5_transition_P == NULL)
+        return a5_FadeStage;
+    
+    int8_t stage = *charStage - (int8_t) pgm_read_byte(&a5_transition_P[*charSegment]);
+    if (++(*charSegment) == a5_CHARSEGMENTS) {
+        *charSegment = 0;
+        *charStage += a5_transitionStep;    // a5_OSB starts with the rightmost character
+    }
+    if (stage < 0)
+        return 0;
+    return stage;
+}
+
+
+void a5LoadNextFadeStage (void)
+{
+    // If a fade is presently in progress, update the OSB with the next iteration.
     // usage:
     // a5LoadNextFadeStage();  // Calculate next fade iteration
     // a5loadVidBuf_fromOSB();  // Load next fade iteration to video display
       
     if (a5_FadeStage >= 0){
         
-        int8_t *fromPtr = &a5_FadeFrom[0];
-        int8_t *toPtr = &a5_FadeTo[0];
-        int8_t *bufPtr = &a5_OSB[0];     // Current contents of OSB
-        byte i = a5_VIDBUFLENGTH;
-        
-        if (a5_FadeStage < a5_brightLevel) {
+        if (a5_FadeStage < (a5_brightLevel + a5_transitionSpan)) {
+            
+            int8_t charStage = a5_FadeStage - (a5_transitionStep * (a5_CHARS - 1));
+            byte charSegment = 0;
+            
+#ifdef a5_PACKED_BUFFERS
+            int8_t from[8], to[8];
+            
+            for (byte group = 0; group < a5_GROUPS; group++)
+            {
+                byte count = a5unpackGroup(a5_FadeFrom, group, from);
+                a5unpackGroup(a5_FadeTo, group, to);
+                for (byte k = 0; k < count; k++)
+                    to[k] = a5fadeLevel(from[k], to[k], a5segmentStage(&charStage, &charSegment));
+                a5packGroup(a5_OSB, group, to, count);
+            }
+#else
+            int8_t *fromPtr = &a5_FadeFrom[0];
+            int8_t *toPtr = &a5_FadeTo[0];
+            int8_t *bufPtr = &a5_OSB[0];     // Current contents of OSB
+            byte i = a5_VIDBUFLENGTH;
             
             do {
-                int8_t segmentBrightnessFrom = (*fromPtr++);
-                int8_t segmentBrightnessTo = (*toPtr++);
-                
-                if (segmentBrightnessTo > segmentBrightnessFrom) {
-                    int8_t temp = (segmentBrightnessFrom + a5_FadeStage);
-                    if (segmentBrightnessTo > temp) {
-                        *bufPtr++ = temp;
-                    }
-                    else
-                    {*bufPtr++ = segmentBrightnessTo;} 
-                }
-                else // segmentBrightnessFrom > segmentBrightnessTo
-                { 
-                    if (segmentBrightnessFrom > (segmentBrightnessTo + a5_FadeStage)) {
-                        *bufPtr++ = segmentBrightnessFrom - a5_FadeStage;
-                    }
-                    else
-                    {*bufPtr++ = segmentBrightnessTo;} 
-                }
+                *bufPtr++ = a5fadeLevel(*fromPtr++, *toPtr++, a5segmentStage(&charStage, &charSegment));
                 i--;
             }
             while (i > 0);
+#endif
             
             a5_FadeStage++;
         }
         else { // i.e., if (InverseFadeStage == 0)
             // When we finish the fade, we load the original "to" buffer into OSB.
             
-            do {
-                *bufPtr++ = *toPtr++;
-                i--;
-            }
-            while (i > 0);
+            memcpy(a5_OSB, a5_FadeTo, sizeof(a5_OSB));
             a5_FadeStage = -1;
         }
     }
 }
  
 
+static inline void a5addOSB (byte segment, byte BrightIn)
+{
+    // Saturating add: a5_BLUT[] has only a5_MaxBright + 1 entries.
+    int sum = a5getLevel(a5_OSB, segment) + BrightIn;
+    if (sum > a5_MaxBright)
+        sum = a5_MaxBright;
+    a5setLevel(a5_OSB, segment, sum);
+}
+
+
 void a5loadOSB_Ascii (char WordIn[], byte BrightIn)
 {
-    // Add five ascii characters at given brightness to the Off-Screen Buffer (OSB).
+    // Add five (a5_CHARS) ascii characters at given brightness to the Off-Screen Buffer (OSB).
     // Note that this routine is strictly additive; it can be used for compositing and cross-fading.
+    // Sums saturate at a5_MaxBright.
     // Execution time: ~178 us total elapsed time, assuming that refresh interrupt is enabled.
     
-    byte alphaPosTemp;
+    byte glyph[3];
     byte letterByteTemp;
     byte segment = 0;
     byte i;
     byte j = 0;
     
-    while (j < 5)
+    while (j < a5_CHARS)
     {
-        alphaPosTemp = 3 * (WordIn[4 - j] - a5_asciiOffset );
-        letterByteTemp = a5_FontTable[alphaPosTemp++];
+        a5fontGlyph(WordIn[a5_CHARS - 1 - j], glyph);
+        letterByteTemp = glyph[0];
         
         i = 1;
         do {
             if (letterByteTemp & i)
             {
-                a5_OSB[segment] += BrightIn;
+                a5addOSB(segment, BrightIn);
             }
             segment++;
             i = i << 1;
         }
         while (i != 0);
         
-        letterByteTemp = a5_FontTable[alphaPosTemp++];
+        letterByteTemp = glyph[1];
         if (letterByteTemp & 1)
         {
-            a5_OSB[segment] += BrightIn;
+            a5addOSB(segment, BrightIn);
         }
         segment++ ;
         
         if (letterByteTemp & 2)
         {
-            a5_OSB[segment] += BrightIn;
+            a5addOSB(segment, BrightIn);
         }
         segment++ ;
         
-        letterByteTemp = a5_FontTable[alphaPosTemp];
+        letterByteTemp = glyph[2];
         i = 1;
         do {
             if (letterByteTemp & i)
             {
-                a5_OSB[segment] += BrightIn;
+                a5addOSB(segment, BrightIn);
             }
             segment++;
             i = i << 1;
@@ -651,8 +1258,8 @@ void a5loadOSB_DP (char WordIn[], byte BrightIn)
      For each character in this string, a value '1' will light the lower DP, a value '2' will light the upper DP,
      and a value '3' will light both DPs. Any other character will not cause either of the LEDs to be lit.
      
-     Note that this routine is strictly additive, so that it can be used for compositing and cross-fading.
-     BUT, remember to CLEAR the OSB before using it and remember that the contents will not be visible until you load
+     Note that this routine is strictly additive (saturating at a5_MaxBright), so that it can be used for
+     compositing and cross-fading. BUT, remember to CLEAR the OSB before using it and remember that the contents will not be visible until you load
      them into the video buffer.
      
      Execution time: ~24 us total elapsed time, assuming that refresh interrupt is enabled.
@@ -661,20 +1268,20 @@ void a5loadOSB_DP (char WordIn[], byte BrightIn)
     byte segment;
     char theLetter;
     byte j = 0;
-    while (j < 5)
+    while (j < a5_CHARS)
     {
-        theLetter = WordIn[4 - j];
-        segment = (j * 18) + 6;
+        theLetter = WordIn[a5_CHARS - 1 - j];
+        segment = (j * a5_CHARSEGMENTS) + 6;
         
         if ((theLetter == '1') || (theLetter == '3'))
         {
-            a5_OSB[segment] += BrightIn;
+            a5addOSB(segment, BrightIn);
         }
         
         if ((theLetter == '2') || (theLetter == '3'))
         {
             segment++;
-            a5_OSB[segment] += BrightIn;
+            a5addOSB(segment, BrightIn);
         }
         j++;
     }
@@ -691,14 +1298,185 @@ void a5loadOSB_Segment (byte segment, byte BrightIn)
      
      Example: a5loadOSB_Segment (45, 19);
      
-     Note that this routine is strictly additive, so that it can be used for compositing and cross-fading.
-     BUT, remember to CLEAR the OSB before using it and remember that the contents will not be visible until you load
+     Note that this routine is strictly additive (saturating at a5_MaxBright), so that it can be used for
+     compositing and cross-fading. BUT, remember to CLEAR the OSB before using it and remember that the contents will not be visible until you load
      them into the video buffer.
      
      */
     
-    a5_OSB[segment] += BrightIn;
+    a5addOSB(segment, BrightIn);
+    
+}
+
+
+void a5loadOSB_Nibbles (byte packedIn[], byte firstSegment, byte count)
+{
+    /*
+     Load a run of segment intensities into the Off-Screen Buffer (a5_OSB), replacing its contents.
+     
+     byte packedIn[]: 4-bit intensities (0-15), two segments per byte, low nibble first.
+     byte firstSegment: Segment (0-89) of the first intensity
+     byte count: Number of segments to load
+     
+     Example: a5loadOSB_Nibbles (frame, 0, 90);  // Load a complete 45-byte frame
+     
+     Unlike the other a5loadOSB_ functions, this routine is not additive: it is meant for streaming
+     segment-level video, where each frame (or run of changed segments) replaces what was there.
+     Intensities are mapped to brightness levels through a5_NibbleLevel[], so that 15 is full
+     brightness, regardless of a5_brightLevel. Segments beyond the end of the buffer are ignored.
+     
+     */
+    
+    byte packed = 0;
+    
+    if (firstSegment >= a5_VIDBUFLENGTH)
+        return;
+    if (count > (a5_VIDBUFLENGTH - firstSegment))
+        count = a5_VIDBUFLENGTH - firstSegment;
+    
+    for (byte i = 0; i < count; i++)
+    {
+        if ((i & 1) == 0)
+        {
+            packed = *packedIn++;
+            a5setLevel(a5_OSB, firstSegment + i, a5_NibbleLevel[packed & 15]);
+        }
+        else
+            a5setLevel(a5_OSB, firstSegment + i, a5_NibbleLevel[packed >> 4]);
+    }
+}
+
+
+
+/*
+ Layers for a5composeOSB(). Each layer holds a5_CHARS characters, as many decimal point characters
+ (as for a5loadOSB_DP), and a brightness; a layer with brightness 0 is hidden.
+ */
+
+char a5_LayerText[a5_LAYERS][a5_CHARS];
+char a5_LayerDP[a5_LAYERS][a5_CHARS];
+byte a5_LayerBright[a5_LAYERS];
+
+
+void a5setLayerText (byte layer, char WordIn[], byte BrightIn)
+{
+    // Set the a5_CHARS characters, and the brightness, of a layer. Takes effect at the next a5composeOSB().
+    // Example: a5setLayerText (1, "ALARM", a5_MaxBright);
+    
+    if (layer >= a5_LAYERS)
+        return;
+    for (byte j = 0; j < a5_CHARS; j++)
+        a5_LayerText[layer][j] = WordIn[j];
+    a5_LayerBright[layer] = BrightIn;
+}
+
+
+void a5setLayerDP (byte layer, char WordIn[])
+{
+    // Set the decimal points of a layer, e.g., "_123_". They are drawn at the layer's brightness.
+    
+    if (layer >= a5_LAYERS)
+        return;
+    for (byte j = 0; j < a5_CHARS; j++)
+        a5_LayerDP[layer][j] = WordIn[j];
+}
+
+
+void a5hideLayer (byte layer)
+{
+    // Blank a layer: clear its characters and decimal points, and set its brightness to zero.
     
+    if (layer >= a5_LAYERS)
+        return;
+    for (byte j = 0; j < a5_CHARS; j++)
+    {
+        a5_LayerText[layer][j] = ' ';
+        a5_LayerDP[layer][j] = ' ';
+    }
+    a5_LayerBright[layer] = 0;
+}
+
+
+static inline void a5composeSegment (byte segment, byte fontBits[], byte mask)
+{
+    // Set a segment to the total brightness of the layers that light it, saturating at a5_MaxBright.
+    int sum = 0;
+    for (byte layer = 0; layer < a5_LAYERS; layer++)
+    {
+        if (fontBits[layer] & mask)
+            sum += a5_LayerBright[layer];
+    }
+    if (sum > a5_MaxBright)
+        sum = a5_MaxBright;
+    a5setLevel(a5_OSB, segment, sum);
+}
+
+
+void a5composeOSB (void)
+{
+    /*
+     Composite all of the layers into the Off-Screen Buffer (a5_OSB), replacing its contents.
+     
+     Each segment is written once, with the saturated sum of the brightness of every layer that lights it,
+     so there is no need to clear the OSB first, and changing one layer (say, a notification overlay on top
+     of the time) costs one composite rather than a clear and redraw of every layer.
+     
+     Example:
+     a5setLayerText (0, "12:34", a5_brightLevel);
+     a5setLayerDP (1, "2____");
+     a5composeOSB ();
+     a5BeginFadeToOSB ();
+     
+     */
+    
+    byte fontA[a5_LAYERS], fontB[a5_LAYERS], fontC[a5_LAYERS];
+    byte segment = 0;
+    byte glyph[3];
+    byte i, j, layer;
+    char theLetter;
+    
+    for (j = 0; j < a5_CHARS; j++)
+    {
+        // Font bits for this character position, for each layer, with the decimal points in A bits 6 and 7.
+        for (layer = 0; layer < a5_LAYERS; layer++)
+        {
+            if (a5_LayerBright[layer] == 0)
+            {
+                fontA[layer] = 0;
+                fontB[layer] = 0;
+                fontC[layer] = 0;
+                continue;
+            }
+            
+            a5fontGlyph(a5_LayerText[layer][a5_CHARS - 1 - j], glyph);
+            fontA[layer] = glyph[0];
+            fontB[layer] = glyph[1];
+            fontC[layer] = glyph[2];
+            
+            theLetter = a5_LayerDP[layer][a5_CHARS - 1 - j];
+            if ((theLetter == '1') || (theLetter == '3'))
+                fontA[layer] |= 64;
+            if ((theLetter == '2') || (theLetter == '3'))
+                fontA[layer] |= 128;
+        }
+        
+        i = 1;
+        do {
+            a5composeSegment(segment++, fontA, i);
+            i = i << 1;
+        }
+        while (i != 0);
+        
+        a5composeSegment(segment++, fontB, 1);
+        a5composeSegment(segment++, fontB, 2);
+        
+        i = 1;
+        do {
+            a5composeSegment(segment++, fontC, i);
+            i = i << 1;
+        }
+        while (i != 0);
+    }
 }
 
 
@@ -710,6 +1488,8 @@ void a5clearVidBuf (void)
     // Note: Some sacrifices have been made for performance at the expense of readability.
     byte *Ptr = &a5_vidBuf[0];
     
+    a5stopDither();
+    
     byte i = a5_VIDBUFLENGTH;
     do {
         *Ptr++ = 0;
@@ -724,13 +1504,17 @@ void a5clearVidBuf (void)
 
 void a5clearOSB (void)
 { // Empty off-screen video buffer.
-    // Execution time: ~74 us, assuming that refresh interrupt is enabled.
-    
-    byte i = 0;
-    do {
-        a5_OSB[i++] = 0;
-    }
-    while (i < a5_VIDBUFLENGTH);
+    memset(a5_OSB, 0, sizeof(a5_OSB));
+}
+
+int8_t a5getOSB (byte segment)
+{ // Brightness level of one segment of the off-screen buffer, whether or not the buffers are packed.
+    return a5getLevel(a5_OSB, segment);
+}
+
+void a5setOSB (byte segment, int8_t level)
+{ // Set one segment of the off-screen buffer, replacing its contents. Example: a5setOSB (45, a5_MaxBright);
+    a5setLevel(a5_OSB, segment, level);
 }
 
 
@@ -746,25 +1530,129 @@ byte a5GetButtons(void)
     return (~(PINB) & a5_BUTTONMASK);
 }
 
-byte a5CheckForRTC()
-{ // Check for presence of RTC module.
-    // send request to receive data (just a byte!) starting at register 0
+static byte a5twiStep (byte control)
+{   // Start one step of a transfer, and wait for it; returns the TWI status, or 0 on timeout.
+    unsigned long start = micros();
     
-    byte status = 0;
-    Wire.beginTransmission(104); // 104 is DS3231 device address
-    Wire.write(0); // start at register 0
-    Wire.endTransmission();
-    Wire.requestFrom(104, 1); // request one byte (seconds)
+    TWCR = control | _BV(TWINT) | _BV(TWEN);
+    while (!(TWCR & _BV(TWINT)))
+        if ((micros() - start) > a5_TWI_TIMEOUT_US)
+            return 0;
+    return TW_STATUS;
+}
+
+static byte a5twiStop (byte result)
+{   // End a transfer; after a timeout, reset the bus as well.  Returns result.
+    unsigned long start = micros();
+    byte i;
     
-    int dummy;
+    if (result != a5_TWI_TIMEOUT)
+    {
+        TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+        while (TWCR & _BV(TWSTO))
+            if ((micros() - start) > a5_TWI_TIMEOUT_US)
+            {
+                result = a5_TWI_TIMEOUT;
+                break;
+            }
+    }
     
-    while(Wire.available())
+    if (result == a5_TWI_TIMEOUT)
+    {   // Let go of the bus, and clock out any device left holding SDA low partway through a
+        // byte (e.g., by a reset during a read): up to nine clocks on SCL (PC0) by hand.
+        TWCR = 0;
+        for (i = 0; (i < 9) && !(PINC & _BV(1)); i++)
+        {
+            PORTC &= ~_BV(0);
+            DDRC |= _BV(0);     // SCL low
+            delayMicroseconds(5);
+            DDRC &= ~_BV(0);
+            PORTC |= _BV(0);    // SCL released, to its pull-up
+            delayMicroseconds(5);
+        }
+    }
+    return result;
+}
+
+static byte a5twiAddress (byte address, byte reg)
+{   // START, the device address for writing, and the register to start at.
+    byte status = a5twiStep(_BV(TWSTA));
+    
+    if ((status != TW_START) && (status != TW_REP_START))
+        return a5_TWI_TIMEOUT;    // (No START: the bus is held by something else.)
+    TWDR = address << 1;
+    status = a5twiStep(0);
+    if (status == 0)
+        return a5_TWI_TIMEOUT;
+    if (status != TW_MT_SLA_ACK)
+        return a5_TWI_NACK;
+    TWDR = reg;
+    status = a5twiStep(0);
+    if (status == 0)
+        return a5_TWI_TIMEOUT;
+    if (status != TW_MT_DATA_ACK)
+        return a5_TWI_NACK;
+    return a5_TWI_OK;
+}
+
+byte a5twiRead (byte address, byte reg, byte data[], byte count)
+{
+    /*
+     Read count bytes from a device, starting at register reg.  Takes about 0.1 ms per byte;
+     returns a5_TWI_OK, a5_TWI_NACK or a5_TWI_TIMEOUT.  Usage:
+         byte seconds;
+         if (a5twiRead(a5_RTC_ADDRESS, 0, &seconds, 1) == a5_TWI_OK) ...
+     */
+    
+    byte result = a5twiAddress(address, reg);
+    byte status;
+    
+    if (result != a5_TWI_OK)
+        return a5twiStop(result);
+    
+    status = a5twiStep(_BV(TWSTA));     // Repeated START, to read
+    if (status != TW_REP_START)
+        return a5twiStop(a5_TWI_TIMEOUT);
+    TWDR = (address << 1) | TW_READ;
+    status = a5twiStep(0);
+    if (status == 0)
+        return a5twiStop(a5_TWI_TIMEOUT);
+    if (status != TW_MR_SLA_ACK)
+        return a5twiStop(a5_TWI_NACK);
+    
+    while (count--)
+    {   // ACK each byte but the last.
+        status = a5twiStep(count ? _BV(TWEA) : 0);
+        if (status == 0)
+            return a5twiStop(a5_TWI_TIMEOUT);
+        *data++ = TWDR;
+    }
+    return a5twiStop(a5_TWI_OK);
+}
+
+byte a5twiWrite (byte address, byte reg, const byte data[], byte count)
+{   // Write count bytes to a device, starting at register reg.  Returns as a5twiRead().
+    
+    byte result = a5twiAddress(address, reg);
+    byte status;
+    
+    while ((result == a5_TWI_OK) && count--)
     {
-        status = 1;
-        dummy = Wire.read(); // get seconds
+        TWDR = *data++;
+        status = a5twiStep(0);
+        if (status == 0)
+            result = a5_TWI_TIMEOUT;
+        else if (status != TW_MT_DATA_ACK)
+            result = a5_TWI_NACK;
     }
-    return status;
-} 
+    return a5twiStop(result);
+}
+
+byte a5CheckForRTC()
+{ // Check for presence of RTC module: 1 if it answers a read of its seconds register.
+    byte seconds;
+    return (a5twiRead(a5_RTC_ADDRESS, 0, &seconds, 1) == a5_TWI_OK);
+}
 
  
 void a5writeEEPROM(byte address, byte value)
@@ -772,6 +1660,11 @@ void a5writeEEPROM(byte address, byte value)
     // Disable interrupts while writing to EEPROM, to avoid
     // possible EEPROM corruption that can result from not doing so.
     
+    // Wait for any previous write to finish first, with interrupts still on: a write takes
+    // 3.3 ms, which is long enough for the refresh interrupt (and a5getHundredths) to miss.
+    
+    eeprom_busy_wait();
+    
     byte oldSREG = SREG;
     cli();
     EEPROM.write(address, value);
@@ -779,6 +1672,122 @@ void a5writeEEPROM(byte address, byte value)
 }
 
 
+// Flash store (see alphafive.h).  It starts out empty: one end marker, and whatever the rest of the
+// initializer leaves.  Page aligned, so that each of its pages can be erased and written on its own.
+const byte a5_store[a5_STORE_SIZE] PROGMEM __attribute__((aligned(a5_STORE_PAGESIZE))) = { a5_STORE_END };
+
+// Optiboot's do_spm(), just past the rjmp at the start of the bootloader: "rjmp .+2" there, then
+// "rjmp do_spm" at the entry.  Its version number is in the last word of flash: major version in
+// the high byte.  Another bootloader may have anything at those places, so the store stays off
+// unless both are found, and the sketch has asked for it (a5_FLASH_STORE).
+typedef void (*a5_spm_t)(uint16_t address, uint8_t command, uint16_t data);
+#define a5_BOOT_START (FLASHEND + 1UL - a5_BOOTLOADER_SIZE)
+#define a5_SPM_ENTRY ((a5_BOOT_START + 2) >> 1)
+#if (a5_BOOTLOADER_SIZE % SPM_PAGESIZE) != 0
+#error "a5_BOOTLOADER_SIZE must be a whole number of flash pages"
+#endif
+#if FLASHEND > 65535
+#define a5_readBootWord(address) pgm_read_word_far(address)
+#else
+#define a5_readBootWord(address) pgm_read_word(address)
+#endif
+
+byte a5storeReady (void)
+{
+#ifdef a5_FLASH_STORE
+    byte major = pgm_read_byte(FLASHEND);
+    if ((major < 8) || (major == 0xFF))
+        return 0;
+    return ((a5_readBootWord(a5_BOOT_START) == 0xC001) &&            // rjmp .+2
+            ((a5_readBootWord(a5_BOOT_START + 2) & 0xF000) == 0xC000));    // rjmp do_spm
+#else
+    return 0;
+#endif
+}
+
+static void a5spm (unsigned int address, byte command, unsigned int data)
+{   // SPM needs a timed sequence, and the interrupt vectors can't be read while a page of the
+    // application section is erased or written (about 4 ms each), so interrupts wait.
+    byte oldSREG = SREG;
+    cli();
+    ((a5_spm_t) a5_SPM_ENTRY)(address, command, data);
+    SREG = oldSREG;
+}
+
+void a5storeClearPage (void)
+{   // Empty the page buffer, before loading a page with a5storeLoadWord().
+    if (a5storeReady())
+        a5spm(0, __BOOT_RWW_ENABLE, 0);
+}
+
+void a5storeLoadWord (byte offset, unsigned int data)
+{   // Load one word (offset even, 0 to a5_STORE_PAGESIZE - 2) into the page buffer.  Each word
+    // may be loaded once per page.  An EEPROM write empties the buffer; finish the page first.
+    if (a5storeReady())
+        a5spm(offset, __BOOT_PAGE_FILL, data);
+}
+
+byte a5storeWritePage (byte page)
+{   // Erase store page "page" and write the page buffer to it.  Returns 1 if written.
+    // The display is blank meanwhile, for about 8 ms, with interrupts off: millis() and
+    // a5getHundredths() lose that time, less the one Timer0 or Timer2 overflow that waits for
+    // interrupts to come back on, so the clock falls about 7 ms behind per page written.
+    unsigned int address = (uintptr_t) a5_store + (page * a5_STORE_PAGESIZE);
+
+    if ((page >= a5_STORE_PAGES) || !a5storeReady())
+        return 0;
+
+    eeprom_busy_wait();    // SPM is ignored during an EEPROM write
+    
+    byte oldSREG = SREG;
+    cli();
+    PORTA |= 95;           // Turn off LED driver and row: it would otherwise stay lit, at full brightness
+    a5spm(address, __BOOT_PAGE_ERASE, 0);
+    a5spm(address, __BOOT_PAGE_WRITE, 0);
+    SREG = oldSREG;
+    return 1;
+}
+
+const byte *a5storeFind (byte type, byte index)
+{   // The record of the given type, "index" records of that type into the store; or 0 if
+    // there isn't one.  Its length is at record + 1, and its data begin at record + 2.
+    const byte *record = a5_store;
+    const byte *end = a5_store + a5_STORE_SIZE;
+    byte recordType;
+
+    while ((record + 2) <= end)
+    {
+        recordType = pgm_read_byte(record);
+        if (recordType == a5_STORE_END)
+            break;
+        if ((record + 2 + pgm_read_byte(record + 1)) > end)
+            break;    // Runs off the end: not a record
+        if ((recordType == type) && (index-- == 0))
+            return record;
+        record += 2 + pgm_read_byte(record + 1);
+    }
+    return 0;
+}
+
+
+unsigned long a5getHundredths (unsigned int *sinceUs)
+{
+    // Hundredths of a second since a5Init(), from the display refresh timer (Timer2) rather than
+    // millis(), so that a display can be redrawn on each one as it begins.  If sinceUs is not NULL,
+    // it receives the time since the present hundredth began, in microseconds.
+    
+    byte oldSREG = SREG;
+    cli();
+    unsigned long count = a5_hundredths;
+    unsigned int phase = a5_hundredthPhase;
+    SREG = oldSREG;
+    
+    if (sinceUs)
+        *sinceUs = ((unsigned long) phase * 5) >> 3;
+    return count;
+}
+
+
 // a5tone: Adapted from Arduino Tone library.
 // A special case, for our available speaker pin, and using hardware PWM. :)
 // frequency (in hertz) and duration (in milliseconds).
@@ -879,6 +1888,9 @@ void a5Init (void)
     SPCR = _BV(SPE) | _BV(MSTR);    // Initialize SPI, fast!
     SPSR |= 1;                      // enable double-speed mode!
     
+    TWSR = 0;                       // I2C (for the optional RTC): prescaler 1,
+    TWBR = ((F_CPU / 100000UL) - 16) / 2;   // 100 kHz
+    
     a5nightLight(0);            // Nightlight off
     a5clearVidBuf();            // Empty video buffer
     a5clearOSB();               // Empty off-screen buffer, too.
@@ -887,14 +1899,7 @@ void a5Init (void)
     Serial.begin(19200);   // Initialize serial port.  19200 baud default matches Alpha5 library examples.
     Serial1.begin(19200);  // Initialize serial port.  19200 baud default matches Alpha5 library examples.
     
-#ifndef HybridScanMode
     a5_intensityStep = 1;  // Needs to start at 1, not (default initialization of) 0.
-#endif
-    
-#ifdef HybridScanMode
-    SubIntensity = 1;   // used only in HybridScanMode
-    BaseIntensity = 0;  // used only in HybridScanMode
-#endif
     
     a5_brightMode = 0;  // Initialize brightness mode variable
     a5_brightLevel = 1; // Initialize main brightness variable
@@ -907,49 +1912,82 @@ void a5Init (void)
     
     TCCR2B = (_BV(CS20)); // System clock w/o prescaler.
     // so overflow happens at 16 MHz/2*256 = 31.250 kHz
+    // (a5selectEngine() changes this to System clock / 8, for the overdrive engine.)
+    
+    a5_scanEngine = a5_ENGINE_GRAY;
+    
+    TIMSK2 = (1<<TOIE2);	// Begin interrupt on timer overflow compare match
+    
+}
+
 
-  //  TCCR2B = (_BV(CS21)); // System clock / 8, for overdrive mode
+/*
+ Display refresh: scan engines.
+ 
+ The Timer2 overflow interrupt lights one row (character) at a time. How it does so -- the "scan engine" --
+ is chosen at run time, at the start of each frame, by a5selectEngine():
+ 
+ a5_ENGINE_GRAY       16-level grayscale, a5_brightMode 0 (extra dim), 1 (low) or 2 (high brightness).
+ a5_ENGINE_HYBRID     256-level grayscale, a5_brightMode 3 (a5_HybridScanMode).
+ a5_ENGINE_OVERDRIVE  No grayscale, slightly brighter: a5_brightMode 4 (a5_OverdriveMode).
+ */
 
+static void a5selectEngine (void)
+{
+    // Called at the end of each frame, from the refresh interrupt: pick the engine for the next one.
     
-    TIMSK2 = (1<<TOIE2);	// Begin interrupt on timer overflow compare match
+    byte engine = a5_ENGINE_GRAY;
+    
+    if (a5_brightMode == a5_HybridScanMode)
+        engine = a5_ENGINE_HYBRID;
+    else if (a5_brightMode == a5_OverdriveMode)
+        engine = a5_ENGINE_OVERDRIVE;
+    
+    if (engine == a5_scanEngine)
+        return;
     
+    if (engine == a5_ENGINE_OVERDRIVE)
+        TCCR2B = (_BV(CS21));  // System clock / 8: overflow at 3.906 kHz
+    else
+        TCCR2B = (_BV(CS20));  // System clock w/o prescaler: overflow at 31.250 kHz
+    
+    a5_scanEngine = engine;
+    a5_intensityStep = 1;
 }
 
 
-ISR(TIMER2_OVF_vect)
+static inline void a5nextRow (byte Intensity, byte lastStep)
+{
+    //  Iterate across intensity steps on the "inner" loop, and across characters more slowly.
+    a5_intensityStep++;
+    if (Intensity > lastStep)
+    {
+        a5_intensityStep = 1;
+        a5_litChar++;
+        
+        if (a5_litChar >= a5_CHARS)
+        {
+            a5_litChar = 0;
+            a5selectEngine();
+        }
+    }
+}
+
+
+static inline byte a5shiftRow (byte Mask, byte Threshold) __attribute__((always_inline));
+static inline byte a5shiftRow (byte Mask, byte Threshold)
 {
     /*
-     Automatic refresh routine for 5-character alphanumeric LED display with 16 levels of grayscale,
-     in either the high or low brightness mode.
-     
-     there are 15 passes through this interrupt for each row per frame.
-     (15 * 5) = 75 times per frame.
+     Turn off the display, and send the presently lit character's segments to the shift registers:
+     each segment is on if (video buffer value & Mask) >= Threshold.
+     Returns the value to write to PORTA to enable the LED row, once the data are latched.
      
-     There are two basic brightness modes: low and high.  Only one may be active at a time.
-     In the low brightness mode, the LEDs are on *only* during the interrupt.
-     In the high brightness mode, the LEDs are on between the interrupts.
-     
-     There are 15 passes through this interrupt, so for *either high or low brightness*:
-     if an LED is off for every step, the perceived brightness is 0/15
-     if an LED is on for every step, the perceived brightness is 15/15
-     giving a total of 16 brightness levels: 0 (unlit) plus 15 levels of nonzero brightness.
-     
-     The brightness of the two registers is tuned such that 15 brightness on the low register
-     is *slightly under* 1 brightness on the high register.
-     
-     This interrupt executes 31250 times per second, every 32 us.
-     
-     Execution time: Typically 16-17 us; about 50% of CPU time.
-     This routine has had some degree of optimization; it uses local copies of
-     global variables and indirect array addressing to speed execution.
-     Sacrifices have been made for performance at the expense of readability.
+     Always inlined, so that a constant Mask of 255 costs nothing.
      */
     
-    byte segment = a5_litChar * 18;
+    byte segment = a5_litChar * a5_CHARSEGMENTS;
     byte *pointer = &a5_vidBuf[segment];
     
-    byte Intensity = a5_intensityStep;  // Using a local variable actually saves a *huge* amount of time.
-    
     byte bufferTemp = 0;
     byte bufferTemp2 = 0;
     byte bufferTemp3 = 0;
@@ -959,235 +1997,271 @@ ISR(TIMER2_OVF_vect)
     
     PORTA |= 95;   // Turn off LED driver and row (if previously in bright mode)
     
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp  = 1;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp |= 2;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp |= 4;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp |= 8;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp |= 16;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp |= 32;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp |= 64;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp |= 128;
     
     
     SPDR = bufferTemp;    // Initiate SPI transmission of 1st byte
     
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp2  = 1;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp2 |= 2;
     
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp3  = 1;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp3 |= 2;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp3 |= 4;
     
     
     
     SPDR = bufferTemp2;    // Initiate SPI transmission of 2nd byte
     
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp3 |= 8;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp3 |= 16;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp3 |= 32;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp3 |= 64;
-    if ( *pointer++ >= Intensity )
+    if ( (*pointer++ & Mask) >= Threshold )
         bufferTemp3 |= 128;
     
     
     
     bufferTemp = SPSR;  // CLEAR SPIF FLAG
     SPDR = bufferTemp3;    // Initiate SPI transmission of 3rd byte
-    PAbackup &= 191;  // Prepare to enable LED driver (PA6 goes low).
     
-    //  Iterate across intensity steps on the "inner" loop, and across characters more slowly.
+    return (PAbackup & 191);  // Prepare to enable LED driver (PA6 goes low).
+}
+
+
+static inline void a5latchRow (byte PAbackup)
+{
+    loop_until_bit_is_set(SPSR, SPIF) ;  //Wait for transmission of 3rd byte to complete
     
-    if (a5_brightMode == 0)
+    PORTC |= 4;       // Latch shift registers
+    PORTC &= 251;     //  End latch
+    
+    PORTA = PAbackup; //  Enable LED row (character)
+    
+#ifdef a5_TRACE_LATENCY
+    if (a5_traceLatchArmed)
     {
-        a5_intensityStep++;
-        if (Intensity > 56)  // Extra-dim mode
-        {
-            a5_intensityStep = 1;
-            a5_litChar++;
-            
-            if (a5_litChar > 4)
-                a5_litChar = 0;
-        }
-        
-        loop_until_bit_is_set(SPSR, SPIF) ;  //Wait for transmission of 3rd byte to complete
-        
-        PORTC |= 4;       // Latch shift registers
-        PORTC &= 251;     //  End latch
-        
-        PORTA = PAbackup; //  Enable LED row (character)
+        a5_traceLatchTime = micros();
+        a5_traceLatchArmed = 0;
+    }
+#endif
+}
+
+
+static inline void a5pulseRow (void)
+{
+    asm("nop;");
+    asm("nop;");
+    asm("nop;");
+    asm("nop;");
+    PORTA |= 95; // Turn off LED driver and row
+}
+
+
+#ifdef a5_DITHER
+static inline void a5ditherRow (byte half)
+{
+    /*
+     Temporal dithering, from the first two passes of each row in brightness modes 1-3: reload one half
+     (1: its first nine segments, 2: the other nine) of the previous row's video buffer from a5_ditherBuf[],
+     for that row's next frame. Split in two, so that no one pass of the interrupt runs long.
+     */
+    
+    byte row = a5_litChar;
+    if (row == 0)
+        row = a5_CHARS;
+    row--;
+    
+    if (a5_ditherRows & (1 << row))
+    {
+        byte threshold = a5ditherThreshold(row);
+        byte segment = row * a5_CHARSEGMENTS;
+        if (half == 2)
+            segment += (a5_CHARSEGMENTS / 2);
         
-        asm("nop;");
-        asm("nop;");
-        asm("nop;");
-        asm("nop;");
-        PORTA |= 95; // Turn off LED driver and row
+        byte *finePtr = &a5_ditherBuf[segment];
+        byte *vPtr = &a5_vidBuf[segment];
+        byte i = (a5_CHARSEGMENTS / 2);
+        do {
+            byte fine = *finePtr++;
+            if (fine != a5_DITHER_NONE)
+            {
+                byte level = fine & 15;
+                if (fine >= threshold)
+                    level++;
+                *vPtr = level;
+            }
+            vPtr++;
+            i--;
+        }
+        while (i != 0);
+    }
+    
+    if ((half == 2) && (row == (a5_CHARS - 1)))
+        a5_ditherPhase = (a5_ditherPhase + 1) & 7;
+}
+#endif
+
+
+static inline void a5scanGray (void)
+{
+    /*
+     Refresh for 5-character alphanumeric LED display with 16 levels of grayscale,
+     in either the high or low brightness mode.
+     
+     there are 15 passes through this interrupt for each row per frame.
+     (15 * 5) = 75 times per frame.
+     
+     There are two basic brightness modes: low and high.  Only one may be active at a time.
+     In the low brightness mode, the LEDs are on *only* during the interrupt.
+     In the high brightness mode, the LEDs are on between the interrupts.
+     
+     There are 15 passes through this interrupt, so for *either high or low brightness*:
+     if an LED is off for every step, the perceived brightness is 0/15
+     if an LED is on for every step, the perceived brightness is 15/15
+     giving a total of 16 brightness levels: 0 (unlit) plus 15 levels of nonzero brightness.
+     
+     The brightness of the two registers is tuned such that 15 brightness on the low register
+     is *slightly under* 1 brightness on the high register.
+     
+     (The extra-dim mode, a5_brightMode 0, makes 57 passes per row, of which at most 15 are lit.)
+     */
+    
+    byte Intensity = a5_intensityStep;  // Using a local variable actually saves a *huge* amount of time.
+    byte PAbackup = a5shiftRow(255, Intensity);
+    
+    if (a5_brightMode == 0)
+    {
+        a5nextRow(Intensity, 56);  // Extra-dim mode
+        a5latchRow(PAbackup);
+        a5pulseRow();
     }
     else if (a5_brightMode == 1)
-        
     {
-        a5_intensityStep++;
-        if (Intensity > 14)
-        {
-            a5_intensityStep = 1;
-            a5_litChar++;
-            
-            if (a5_litChar > 4)
-                a5_litChar = 0;
-        }
-        
-        loop_until_bit_is_set(SPSR, SPIF) ;  //Wait for transmission of 3rd byte to complete
-        
-        PORTC |= 4;       // Latch shift registers
-        PORTC &= 251;     //  End latch
-        
-        PORTA = PAbackup; //  Enable LED row (character)
-        
-        asm("nop;");
-        asm("nop;");
-        asm("nop;");
-        asm("nop;");
-        PORTA |= 95; // Turn off LED driver and row
+        a5nextRow(Intensity, 14);
+        a5latchRow(PAbackup);
+        a5pulseRow();
     }
     else
     {
-        a5_intensityStep++;
-        if (Intensity > 14) //14
-        {
-            a5_intensityStep = 1;
-            a5_litChar++;
-            
-            if (a5_litChar > 4)
-                a5_litChar = 0;
-        }
-        
-        loop_until_bit_is_set(SPSR, SPIF) ;  //Wait for transmission of 3rd byte to complete
-        
-        PORTC |= 4;       // Latch shift registers
-        PORTC &= 251;     //  End latch
-        
-        PORTA = PAbackup; //  Enable LED row (character)
-        
+        a5nextRow(Intensity, 14);
+        a5latchRow(PAbackup);
     }
     
+#ifdef a5_DITHER
+    if ((Intensity <= 2) && a5_brightMode)
+        a5ditherRow(Intensity);     // Once the row is lit
+#endif
+}
+
+
+static inline void a5scanHybrid (void)
+{
+    /*
+     The hybrid mode (a5_HybridScanMode) uses both registers, for a continuous range from very dim to
+     fairly bright, without switching modes: 30 passes per row, 15 low-brightness (in-interrupt) passes
+     compared against the low nibble of each video buffer byte, then 15 high-brightness passes
+     compared against the high nibble. Since each row then takes twice as long, the refresh rate is
+     halved (208 Hz), and so is the maximum brightness, compared with the high brightness mode.
+     */
     
+    byte Intensity = a5_intensityStep;
+    byte PAbackup;
     
-    
+    if (Intensity > 15)
+    {   // High-brightness pass: compare high nibbles
+        PAbackup = a5shiftRow(240, (Intensity - 15) << 4);
+        a5nextRow(Intensity, 29);
+        a5latchRow(PAbackup);
+    }
+    else
+    {   // Low-brightness pass: compare low nibbles, pulse only
+        PAbackup = a5shiftRow(15, Intensity);
+        a5nextRow(Intensity, 29);
+        a5latchRow(PAbackup);
+        a5pulseRow();
+#ifdef a5_DITHER
+        if (Intensity <= 2)
+            a5ditherRow(Intensity);
+#endif
+    }
 }
 
 
-//ISR(TIMER2_OVF_vect)  /* OVERDRIVE */
-//{
-//    /*
-//     Automatic refresh routine for 5-character alphanumeric LED display w/o grayscale.
-//     Slightly brighter, but less elegant.
-//     */
-//    
-//    byte segment = a5_litChar * 18;
-//    byte *pointer = &a5_vidBuf[segment];
-//    
-//    byte Intensity = a5_intensityStep;  // Using a local variable actually saves a *huge* amount of time.
-//    
-//    byte bufferTemp = 0;
-//    byte bufferTemp2 = 0;
-//    byte bufferTemp3 = 0;
-//    byte PAbackup = PORTA | 95;
-//    
-//    PAbackup &= ~(1 << a5_litChar); // All pins allowed high except row driver.
-//    
-//    if( Intensity == 1)
-//    PORTA |= 95;   // Turn off LED driver and row (if previously in bright mode)
-//    
-//    if ( *pointer++)
-//        bufferTemp  = 1;
-//    if ( *pointer++)
-//        bufferTemp |= 2;
-//    if ( *pointer++)
-//        bufferTemp |= 4;
-//    if ( *pointer++)
-//        bufferTemp |= 8;
-//    if ( *pointer++)
-//        bufferTemp |= 16;
-//    if ( *pointer++)
-//        bufferTemp |= 32;
-//    if ( *pointer++)
-//        bufferTemp |= 64;
-//    if ( *pointer++ )
-//        bufferTemp |= 128;
-//    
-//   if( Intensity == 1)
-//    SPDR = bufferTemp;    // Initiate SPI transmission of 1st byte
-//    
-//    if ( *pointer++)
-//        bufferTemp2  = 1;
-//    if ( *pointer++)
-//        bufferTemp2 |= 2;
-//    
-//    if ( *pointer++)
-//        bufferTemp3  = 1;
-//    if ( *pointer++)
-//        bufferTemp3 |= 2;
-//    if ( *pointer++)
-//        bufferTemp3 |= 4;
-//    
-//    
-//  if( Intensity == 1)
-//    SPDR = bufferTemp2;    // Initiate SPI transmission of 2nd byte
-//    
-//    if ( *pointer++)
-//        bufferTemp3 |= 8;
-//    if ( *pointer++)
-//        bufferTemp3 |= 16;
-//    if ( *pointer++)
-//        bufferTemp3 |= 32;
-//    if ( *pointer++)
-//        bufferTemp3 |= 64;
-//    if ( *pointer++)
-//        bufferTemp3 |= 128;
-//    
-//    bufferTemp = SPSR;  // CLEAR SPIF FLAG
-//    if( Intensity == 1)
-//    SPDR = bufferTemp3;    // Initiate SPI transmission of 3rd byte
-//    PAbackup &= 191;  // Prepare to enable LED driver (PA6 goes low).
-//    
-//    //  Iterate across intensity steps on the "inner" loop, and across characters more slowly.
-//    {
-//        a5_intensityStep++;
-//        if (Intensity > 2) //14
-//        {
-//            a5_intensityStep = 1;
-//            a5_litChar++;
-//            
-//            if (a5_litChar > 4)
-//                a5_litChar = 0;
-//        }
-//        
-//        if( Intensity == 1)
-//        {
-//        loop_until_bit_is_set(SPSR, SPIF) ;  //Wait for transmission of 3rd byte to complete
-//        
-//        PORTC |= 4;       // Latch shift registers
-//        PORTC &= 251;     //  End latch
-//        
-//        PORTA = PAbackup; //  Enable LED row (character)
-//        }
-//    } 
-//}
+static inline void a5scanOverdrive (void)
+{
+    /*
+     Refresh w/o grayscale: any segment with a nonzero level is lit, for the whole time that its row is.
+     Slightly brighter, but less elegant. Three passes per row, with Timer2 at 1/8 rate;
+     the shift registers are loaded on the first.
+     */
+    
+    byte Intensity = a5_intensityStep;
+    
+    if (Intensity == 1)
+    {
+        byte PAbackup = a5shiftRow(255, 1);
+        a5nextRow(Intensity, 2);
+        a5latchRow(PAbackup);
+    }
+    else
+        a5nextRow(Intensity, 2);
+}
 
 
+ISR(TIMER2_OVF_vect)
+{
+    /*
+     Automatic refresh routine for 5-character alphanumeric LED display: dispatch to the present scan engine.
+     
+     With the grayscale engines, this interrupt executes 31250 times per second, every 32 us.
+     
+     Execution time: Typically 16-17 us; about 50% of CPU time.
+     This routine has had some degree of optimization; it uses local copies of
+     global variables and indirect array addressing to speed execution.
+     Sacrifices have been made for performance at the expense of readability.
+     */
+    
+    byte engine = a5_scanEngine;
+    
+    if (engine == a5_ENGINE_GRAY)
+        a5scanGray();
+    else if (engine == a5_ENGINE_HYBRID)
+        a5scanHybrid();
+    else
+        a5scanOverdrive();
+    
+    // Count hundredths.  In phase-correct PWM, Timer2 overflows every 510 counts:
+    // 510 cycles with no prescaler, 4080 at 1/8 rate (the engine that just ran sets the rate).
+    unsigned int phase = a5_hundredthPhase + ((engine == a5_ENGINE_OVERDRIVE) ? 408 : 51);
+    if (phase >= a5_HUNDREDTH_PHASE)
+    {
+        phase -= a5_HUNDREDTH_PHASE;
+        a5_hundredths++;
+    }
+    a5_hundredthPhase = phase;
+}
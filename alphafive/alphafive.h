@@ -26,7 +26,6 @@
 #define alphafive_h
 
 #include "Arduino.h"
-#include <Wire.h>       // For optional RTC module
 #include <EEPROM.h>     // For saving settings
 
 
@@ -38,6 +37,89 @@
 
 #define a5_MaxBright 19                 // 20 levels, 0-19
 
+/*
+ Display size. The buffers, render loops and refresh interrupt are all sized from these at compile time.
+ a5_CHARS may be 1 to 5 on the Alpha Clock Five board, which has one PORTA row driver pin per character.
+ Text and decimal point strings passed to the library are a5_CHARS characters long.
+ a5_CHARSEGMENTS is set by the font format (A, B, C: 8 + 2 + 8 bits) and the three shift registers;
+ segment n of a character is bit n of those 18 bits, and of the data shifted out for it.
+ */
+#ifndef a5_CHARS
+#define a5_CHARS 5
+#endif
+#define a5_CHARSEGMENTS 18
+#define a5_VIDBUFLENGTH (a5_CHARS * a5_CHARSEGMENTS)
+
+#if (a5_CHARS < 1) || (a5_CHARS > 5)
+#error "a5_CHARS must be 1 to 5"
+#endif
+
+#define a5_HybridScanMode 3             // a5_brightMode value: continuous dim-to-bright range, 0-255 video buffer
+#define a5_OverdriveMode 4              // a5_brightMode value: no grayscale, slightly brighter than mode 2
+
+#define a5_LAYERS 3                     // Layers composited by a5composeOSB()
+#define a5_FONTPATCHES 12               // Font characters that a5editFontChar() can change at once
+#define a5_GLYPHBANKS 2                 // Glyph bank slots, for a5setGlyphBank()
+#define a5_NUMBERBANK 0                 // Slot of the numeral style, set by a5loadAltNumbers()
+#define a5_USERBANK 1
+#define a5_NUMBERSTYLES 10              // Built-in numeral styles
+
+#define a5_GLYPH_DEGREE  127            // Extra font characters, beyond ASCII '~'
+#define a5_GLYPH_BLOCK   128
+#define a5_GLYPH_UP      129
+#define a5_GLYPH_DOWN    130
+
+#define a5_TRANSITION_FADE     0        // a5setTransition() effects. Uniform cross-fade (default)
+#define a5_TRANSITION_WIPE     1        // Wipe, left to right
+#define a5_TRANSITION_STAGGER  2        // Each character fades in turn, left to right
+#define a5_TRANSITION_DRAW     3        // Segments fade in drawing order, around each character
+#define a5_TRANSITIONS         4
+
+/*
+ Flash store: a5_STORE_PAGES pages of program memory, set aside (and page aligned) to be rewritten
+ at run time, a page at a time, through the bootloader's do_spm entry (Optiboot 8 and later, as
+ installed by MightyCore).  Writing is off unless a5_FLASH_STORE is defined (below), since a jump
+ to that entry in any other bootloader leaves the clock unusable until it is reflashed; even then,
+ a5storeReady() is 0 unless Optiboot's version and the jumps at the start of its a5_BOOTLOADER_SIZE
+ bytes are found.  Content is read with pgm_read_byte(), as fast as the built-in tables, and uses
+ no SRAM.  Uploading new firmware replaces the store with an empty one.
+
+ The store holds records, one after another: [type] [length] [length bytes of data].
+ A type of a5_STORE_END (erased flash) ends the list.
+ */
+#ifndef a5_STORE_PAGES
+#define a5_STORE_PAGES 16               // 4 kB
+#endif
+#define a5_STORE_PAGESIZE SPM_PAGESIZE  // 256 bytes on the ATmega644
+
+// Uncomment only with Optiboot 8 or later installed as the bootloader, to let the store be written.
+//#define a5_FLASH_STORE
+
+#ifndef a5_BOOTLOADER_SIZE              // Optiboot's size, as set by its BOOTSZ fuses
+#if FLASHEND > 65534
+#define a5_BOOTLOADER_SIZE (4 * SPM_PAGESIZE)   // 1 kB
+#else
+#define a5_BOOTLOADER_SIZE (2 * SPM_PAGESIZE)   // 512 bytes
+#endif
+#endif
+#define a5_STORE_SIZE (a5_STORE_PAGES * a5_STORE_PAGESIZE)
+
+#define a5_STORE_END       0xFF
+#define a5_STORE_MESSAGE   'M'          // Text, to scroll across the display
+#define a5_STORE_SEQUENCE  'S'          // Words: [5 characters] [tenths of a second to show them], repeated
+#define a5_STORE_GLYPHS    'G'          // Glyph bank: [ASCII code of the first character] [A, B, C], repeated
+
+/*
+ I2C (TWI), for the optional RTC module, with time limits: each step of a transfer waits at most
+ a5_TWI_TIMEOUT_US for the bus, so that a stuck line (SDA held low, missing pull-ups) gives an
+ error rather than a hang.  The bus runs at 100 kHz; a5Init() sets it up.
+ */
+#define a5_TWI_OK          0
+#define a5_TWI_NACK        1            // No device answered at that address
+#define a5_TWI_TIMEOUT     2            // The bus didn't respond in time; it has been reset
+#define a5_TWI_TIMEOUT_US  2000
+#define a5_RTC_ADDRESS     104          // DS3231 (Chronodot) or DS1307
+
 // Hardware location shortcuts
 #define a5_BUTTONMASK   15              // Locations of physical pushbuttons, PB0, PB1, PB2, PB3
 #define a5_alarmSetBtn  1				// Snooze/Set alarm button
@@ -54,9 +136,41 @@
 #define a5_TimeSetMinusBtns 10
 #define a5_AlarmSetPlusBtns  5
 #define a5_AlarmSetMinusBtns 9
+
+// Uncomment to store the off-screen and fade buffers packed, 5 bits per segment (saves 132 bytes of SRAM).
+// a5_OSB is then not directly accessible; use a5getOSB() and a5setOSB(), which work either way.
+//#define a5_PACKED_BUFFERS
+
+#ifdef a5_PACKED_BUFFERS
+#define a5_OSBLENGTH ((a5_VIDBUFLENGTH / 2) + ((a5_VIDBUFLENGTH + 7) / 8))  // Bytes in each off-screen buffer: 57
+#else
+#define a5_OSBLENGTH a5_VIDBUFLENGTH
 extern int8_t a5_OSB[];
+#endif
 extern int8_t a5_FadeStage;
 
+// Uncomment for temporal dithering: in brightness modes 1, 2 and a5_HybridScanMode, a5loadVidBuf_fromOSB() then
+// shows each level at its exact place on the fade curve, by alternating a segment between two adjacent hardware
+// intensities over a cycle of eight frames (52 Hz; 26 Hz in the hybrid mode). Levels 1-7, which otherwise share
+// intensities 1 and 2 (in the hybrid mode, levels 1-5, with 1-3 pulses), become distinct.
+// Costs 90 bytes of SRAM, and about 9 us in the first two of each row's fifteen (or thirty) passes of the
+// refresh interrupt.  Not in the extra-dim mode (0), nor a5_OverdriveMode.
+//#define a5_DITHER
+
+#ifdef a5_DITHER
+extern byte a5_ditherEnable;    // 1 (default): dither a5_OSB levels; 0: round them, as without a5_DITHER
+#endif
+
+// Uncomment to time the display refresh for the AlphaClock sketch's serial-to-photon latency trace
+// (Q serial command): set a5_traceLatchArmed to 1 after loading the video buffer, and the refresh
+// interrupt stores micros() in a5_traceLatchTime at its next row latch, then clears it.
+//#define a5_TRACE_LATENCY
+
+#ifdef a5_TRACE_LATENCY
+extern volatile byte a5_traceLatchArmed;
+extern volatile unsigned long a5_traceLatchTime;
+#endif
+
 
 // Starting offset of our ASCII array:
 #define a5_asciiOffset 32
@@ -64,27 +178,47 @@ extern int8_t a5_FadeStage;
 #define a5_integerOffset 48
 
 extern int8_t a5_brightLevel;
-extern byte a5_brightMode;  // 0: low brightness mode. 1: Medium. 2: High brightness mode
+extern byte a5_brightMode;  // 0: low brightness mode. 1: Medium. 2: High brightness mode. 3: a5_HybridScanMode. 4: a5_OverdriveMode
 extern const char a5_monthShortNames_P[];
+extern const byte a5_store[];
 
 byte a5getFontChar(char asciiChar, byte offset);
-void a5editFontChar(char asciiChar, byte A, byte B, byte C);
+byte a5editFontChar(char asciiChar, byte A, byte B, byte C);
+void a5clearFontEdits (char first, byte count);
+void a5setGlyphBank (byte slot, const byte glyphs[], char first, byte count, byte inFlash);
 void a5loadAltNumbers (int8_t charset);
 void a5loadVidBuf_Ascii (char WordIn[], byte BrightIn);
 void a5loadVidBuf_DP (char WordIn[], byte BrightIn);
 void a5loadVidBuf_fromOSB_noCache (void);
 void a5loadVidBuf_fromOSB (void);
+void a5readVidBuf (byte packedOut[]);
 void a5BeginFadeToOSB (void);
 void a5LoadNextFadeStage (void);
+void a5setTransition (byte effect);
 void a5loadOSB_Ascii (char WordIn[], byte BrightIn);
 void a5loadOSB_DP (char WordIn[], byte BrightIn);
 void a5loadOSB_Segment (byte segment, byte BrightIn);
+void a5loadOSB_Nibbles (byte packedIn[], byte firstSegment, byte count);
+void a5setLayerText (byte layer, char WordIn[], byte BrightIn);
+void a5setLayerDP (byte layer, char WordIn[]);
+void a5hideLayer (byte layer);
+void a5composeOSB (void);
 void a5clearVidBuf (void);
 void a5clearOSB (void);
+int8_t a5getOSB (byte segment);
+void a5setOSB (byte segment, int8_t level);
 void a5nightLight(byte Brightness);
 byte a5GetButtons(void);
+byte a5twiRead (byte address, byte reg, byte data[], byte count);
+byte a5twiWrite (byte address, byte reg, const byte data[], byte count);
 byte a5CheckForRTC();
 void a5writeEEPROM(byte address, byte value);
+byte a5storeReady (void);
+void a5storeClearPage (void);
+void a5storeLoadWord (byte offset, unsigned int data);
+byte a5storeWritePage (byte page);
+const byte *a5storeFind (byte type, byte index);
+unsigned long a5getHundredths (unsigned int *sinceUs);
 void a5tone(unsigned int frequency, unsigned long duration);
 void a5noTone (void);
 void a5Init (void);
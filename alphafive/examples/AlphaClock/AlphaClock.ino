@@ -40,10 +40,9 @@ Pinout: Sanguino pinout
 Download and install the Time library:
 https://github.com/PaulStoffregen/Time
 
-Download and install the DS1307 library:
-https://github.com/PaulStoffregen/DS1307RTC
-
-(The above two can be added to your regular Arduino libraries folder.)
+(It can be added to your regular Arduino libraries folder.  The DS1307RTC library,
+needed by earlier versions, is no longer used: the RTC is read with time limits, by
+the alphafive library.)
 
 
 For additional requirements, please see:
@@ -97,29 +96,42 @@ For additional requirements, please see:
 
 
 #include <Time.h>       // The Arduino Time library, https://github.com/PaulStoffregen/Time
-#include <Wire.h>       // For optional RTC module
-#include <DS1307RTC.h>  // For optional RTC module. https://github.com/PaulStoffregen/DS1307RTC
 #include <EEPROM.h>     // For saving settings 
+#include <util/crc16.h> // For checking flash store uploads
 
 // "Factory" default configuration can be configured here:
+// Firmware version, as reported to the D serial command
+#define a5VersionMajor 2
+#define a5VersionMinor 2
+#define a5VersionPatch 0
+
 #define a5brightLevelDefault 9 
 #define a5HourMode24Default 0
 #define a5AlarmEnabledDefault 0
 #define a5AlarmHrDefault 7  
 #define a5AlarmMinDefault 30
+#define a5AlarmDaysDefault 127     // Every day
 #define a5NightLightTypeDefault 0
 #define a5AlarmToneDefault 2
-#define a5NumberCharSetDefault 2;
-#define a5DisplayModeDefault 0;
+#define a5NumberCharSetDefault 2
+#define a5DisplayModeDefault 0
 
 // Clock mode variables
 
-byte HourMode24;
+int8_t HourMode24;
 byte AlarmEnabled; // If the "ALARM" function is currently turned on or off. 
 byte AlarmTimeHr;
 byte AlarmTimeMin;
 int8_t AlarmTone;
 
+// Alarm 0 is the one shown and set with the buttons; the others are set over serial (L<n>).
+// AlarmEnabled turns all of them on or off together.
+#define a5_ALARMS 4
+#define a5_EE_MORE_ALARMS 10   // EEPROM address of alarm 1.  Alarm 0 uses addresses 2-4 and 9.
+byte AlarmDays[a5_ALARMS];    // Days on which each alarm sounds: bit 0 Sunday ... bit 6 Saturday; 0 = never
+byte AlarmMoreHr[a5_ALARMS - 1];   // Times of alarms 1 and up
+byte AlarmMoreMin[a5_ALARMS - 1];
+
 int8_t NightLightType;  
 byte NightLightSign;
 unsigned int NightLightStep; 
@@ -129,19 +141,23 @@ unsigned int NightLightStep;
 // Configuration menu:
 byte menuItem;   //Current position within options menu
 int8_t optionValue; 
-#define MenuItemsMax 10
 
-#define AMPM24HRMenuItem 0
-#define NightLightMenuItem 1
-#define AlarmToneMenuItem 2
-#define SoundTestMenuItem 3
-#define numberCharSetMenuItem 4
-#define DisplayStyleMenuItem 5
-#define SetYearMenuItem 6
-#define SetMonthMenuItem 7
-#define SetDayMenuItem 8
-#define SetSecondsMenuItem 9 
-#define AltModeMenuItem 10 
+// One entry of MenuItems[], the configuration menu table (in flash).
+typedef struct {
+  int8_t *setting;                 // Setting stepped by + and -, 0 to maxValue, wrapping around; or NULL
+  byte maxValue;
+  const char *labels;              // PROGMEM: five characters for each value (one label only, with MenuOneLabel)
+  void (*onChange)(void);          // Called after + or - changes the setting, or NULL
+  byte (*show)(byte forceUpdate);  // Items without a setting: handle + and -, and draw. Returns 1 if it drew text.
+  byte titleSequence;              // DisplayWordSequence() shown on arriving at the item; or 0, for:
+  const char *title;               // PROGMEM: five characters, then five DPs; or NULL for no title
+  byte eeAddress;                  // EEPROM address of the setting, or MenuNoEEPROM
+  byte defaultValue;               // Used if the value in EEPROM is out of range
+  byte flags;
+} MenuItem_t;
+
+#define MenuNoEEPROM 255
+#define MenuOneLabel 1             // flags: the same label for every value
 
 
 
@@ -160,7 +176,19 @@ int8_t numberCharSet;
 
 // Other global variables:
 byte UseRTC;
-unsigned long NextClockUpdate, NextAlarmCheck;
+
+// Optional RTC module: probed from loop(), once the display is up, so that a missing or stuck
+// one can't hold up the first frame.  See ProbeRTC().
+#define RTCProbeTries 3
+#define RTCProbeInterval 100       // ms between tries
+byte rtcProbeTries;                // Tries left; 0 once the probe is over
+byte rtcState;                     // 0 while probing; then 'R' (in use), 'N' (no answer),
+                                   //   'B' (bus fault) or 'S' (answered, but not set)
+unsigned long rtcProbeAt;
+byte timeSynced;                   // 1 once the time has been set over serial (ST or T)
+time_t rtcHandOver;                // If nonzero, the RTC is set once this second is over; see ProbeRTC()
+unsigned int bootFrameMs;          // From start-up (after the bootloader) to the first frame; 0 until then
+unsigned long NextClockUpdate;
 unsigned long milliTemp;
 unsigned int FLWoffset; // Counter variable for FLW (Five Letter Word) display mode
 
@@ -173,6 +201,102 @@ byte wordSequence;
 byte wordSequenceStep;
 byte modeShowText;
 
+// Layers for a5composeOSB():
+#define TimeLayer       0   // Time, date, or word, with its own separators
+#define IndicatorLayer  1   // Alarm-enabled indicator (upper left DP)
+                            // Layer 2 is free, e.g., for notifications drawn over the time.
+
+// Segment Video Variables (V<n> serial commands):
+byte modeShowVideo;
+
+// Variable-length messages (V<n>, F<n> L and C<n> U) whose data have not all arrived:
+char framePendingType;     // V<n> frame type, 'L' or 'U'; or 0 if none
+char framePendingUnit;
+byte framePendingLength;   // Data bytes that follow the header
+#define FramePendingTimeout 500    // ms; a message whose data stop short for this long is abandoned
+unsigned long framePendingTime;    // When its header arrived
+unsigned int serialDiscard;        // Data bytes of a rejected message still to be dropped
+
+// Received bytes, as a burst: from when loop() first finds bytes waiting, after finding none.
+// See SerialMessageArrival().
+#define SerialByteUs 521           // One byte (10 bits) at 19200 baud
+byte serialBurst;                  // 1 while bytes have been waiting since the burst began
+unsigned long serialBurstStart;    // When the first byte of the burst arrived (estimated)
+byte serialBurstMessages;          // Headers parsed since
+
+// Flash store uploads (F<n> serial commands); see processStoreLoad().
+#define StoreLoadTimeout 2000      // ms; a page left unfinished for this long is abandoned
+unsigned int storeLoaded;          // Bytes of the flash page buffer loaded so far
+unsigned int storeCRC;             // CRC of those bytes
+byte storeLoadError;               // A load was out of order; the page must be started again
+byte storeLoadOffset, storeLoadLength;
+unsigned long storeLoadTime;
+
+// Stored message or sequence being shown; see DisplayStoredStep().
+#define StoredSequence 255         // Its wordSequence number
+#define StoredScrollTime 250       // ms per character, for messages
+const byte *storedShow;
+unsigned int storedShowStep;
+
+// User glyph bank (C<n> serial commands); see processBankUpload().
+#define UserBankChars 18           // Most glyphs in an upload: one 56-byte frame
+byte userBank[3 * UserBankChars];
+char userBankSource;               // 0: none; 'U': uploaded to userBank[]; 'G': from the flash store
+byte userBankIndex;                // The store record, for 'G'
+byte userBankFirst, userBankCount;
+byte bankUploadFirst, bankUploadCount;   // Of the upload whose data are arriving
+
+// Stopwatch and countdown (WATCH menu item, or W<n> serial commands):
+#define a5_WATCH_MAX 599999UL  // 99:59.99, in hundredths
+byte modeShowWatch;        // 0, or 'S' (stopwatch) or 'C' (countdown)
+byte watchRunning;
+byte watchRedraw;
+unsigned long watchBase;      // While running: the a5getHundredths() count at which the watch read 0:00.00
+unsigned long watchElapsed;   // While stopped: hundredths counted so far
+unsigned long watchLength;    // Countdown: hundredths to count down from
+unsigned long watchTick;      // a5getHundredths() count last shown
+unsigned int watchWorstUs;    // Longest frame: from the start of a hundredth until it is in the video buffer
+unsigned int watchFrames, watchMissed;    // Frames drawn, and hundredths never shown while running
+
+// Sub-second time sync (T<n> serial commands):
+byte timeSyncPending;
+time_t timeSyncSecond;       // The time to set...
+unsigned long timeSyncAt;    // ...when micros() reaches this value
+
+// Daisy-chain discovery (D serial command):
+#define a5_DISCOVERY_IDLE     0
+#define a5_DISCOVERY_WAITING  1   // For the first byte of the next unit's report
+#define a5_DISCOVERY_HEARD    2   // Relaying the next unit's report
+byte discoveryState;
+byte discoveryIndex, discoverySequence, discoveryRelayed;
+unsigned long discoverySent, discoveryHopTime;
+
+#ifdef a5_TRACE_LATENCY
+// Serial-to-photon latency trace (Q serial command); see TraceReceived().
+#define TraceLength 16
+#define TraceStages 4      // Parsed, rendered, fade finished, first latch
+byte traceCommand[TraceLength];
+unsigned int traceTime[TraceLength][TraceStages];
+byte traceNewest, traceCount;
+byte traceNextStage = TraceStages;   // The stage that the newest entry waits for, or TraceStages if none
+unsigned long traceStart;
+unsigned int traceOutputWorst, tracePassWorst;   // Longest serial output and loop() pass, 16 us units
+unsigned long traceOutputStart, tracePassStart;
+#endif
+
+// Telemetry: text status lines, queued and then handed to the serial transmit buffer only
+// as it has room, so that loop() doesn't wait on the UART for them; see TelemetryDrain().
+// Replies that don't fit in the transmit buffer wait their turn in serialOut; see SerialReply().
+#define TelemetryLines 8
+#define TelemetryTextLength 56
+const char *telemetryLine[TelemetryLines];   // Queued lines, in program memory; 0 for the time
+byte telemetryHead, telemetryCount;
+char telemetryText[TelemetryTextLength];     // The line being sent
+byte telemetrySent, telemetryLength;
+byte telemetryDropped;                       // Lines dropped for want of room
+#define SerialOutLength 64                   // Room for the longest reply, R<n> F (58 bytes)
+byte serialOut[SerialOutLength];             // Reply bytes waiting for the transmit buffer
+byte serialOutHead, serialOutCount;
 
 byte RedrawNow, RedrawNow_NoFade;
 
@@ -194,22 +318,55 @@ byte holdDebounce;
 // Brightness steps for manual brightness adjustment
 byte Brightness;
 #define BrightnessMax 11
+// Settings 1 and 2 use the extra-dim mode (0), whose one-pulse floor is about half that of the hybrid scan
+// mode (57 passes per row, not 30; refreshed at 110 Hz).  Settings 3-9 use the hybrid mode (208 Hz), which
+// covers that range without changing modes; 10 and 11, the high brightness mode (416 Hz), since the
+// hybrid mode peaks at half of it.  Each step is about twice as bright as the last, to setting 9,
+// then about 1.4 times.
 byte MBlevel[] = {
-  0, 1, 5,10,15,19,15,19, 5,10,15,19}; 
+  0, 1, 5, 3, 6, 9,11,14,16,19,17,19}; 
 byte MBmode[]  = {
-  0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 2, 2};
+  0, 0, 0, a5_HybridScanMode, 
+  a5_HybridScanMode, a5_HybridScanMode, a5_HybridScanMode, a5_HybridScanMode, 
+  a5_HybridScanMode, a5_HybridScanMode, 2, 2};
 
-// For fade and update management: 
-byte SecLast; 
+// For fade and update management:
+byte SecLast;
 byte MinNowOnesLast;
 byte MinAlarmOnesLast;
 
 
+// Broken-down time cache:
+// hour(), minute(), second() and friends each convert the time_t from now(), which is slow.
+// Instead, we keep one broken-down copy of the time, and advance it once per second
+// by UpdateClockTime().  All display and alarm code reads from TimeNow.
+// The BCD fields hold two decimal digits: tens in the high nibble, ones in the low nibble.
+
+typedef struct {
+  byte Second;        // 0-59
+  byte Minute;        // 0-59
+  byte Hour;          // 0-23
+  byte Day;           // 1-31
+  byte Month;         // 1-12
+  byte Wday;          // 1-7, Sunday is day 1 (as in the Time library)
+  unsigned int Year;  // e.g., 2019
+
+  byte SecondBCD;
+  byte MinuteBCD;
+  byte HourBCD;       // 24-hour clock, 00-23
+  byte Hour12BCD;     // 12-hour clock, 01-12
+  byte DayBCD;
+  unsigned int YearBCD;  // Four BCD digits
+} ClockTime_t;
+
+ClockTime_t TimeNow;
+time_t TimeNowStamp;    // The time_t value that TimeNow describes
+
+
 //Alarm variables
-byte AlarmTimeSnoozeMin;
-byte AlarmTimeSnoozeHr;
+time_t NextAlarmAt;   // When the next alarm (or the end of a snooze) is due; 0 if none is.
+time_t SnoozeUntil;
 byte snoozed;
-byte alarmPrimed;
 byte alarmNow;
 
 byte modeShowAlarmTime;
@@ -227,6 +384,7 @@ void incrementAlarm(void)
       AlarmTimeHr = 0; 
   } 
   UpdateEE = 1;
+  ScheduleAlarms();
 }
 
 void decrementAlarm(void)
@@ -243,6 +401,58 @@ void decrementAlarm(void)
       AlarmTimeHr = 23;
   }
   UpdateEE = 1;
+  ScheduleAlarms();
+}
+
+byte AlarmHour (byte n)
+{
+  return (n == 0) ? AlarmTimeHr : AlarmMoreHr[n - 1];
+}
+
+byte AlarmMinute (byte n)
+{
+  return (n == 0) ? AlarmTimeMin : AlarmMoreMin[n - 1];
+}
+
+time_t AlarmNextFire (byte n, time_t after)
+{ // The first time, later than "after", at which alarm n is set to sound; 0 if it never is.
+  unsigned long day = after / SECS_PER_DAY;
+  byte weekday = (day + 4) % 7;     // 1 Jan 1970 was a Thursday.  Sunday is 0.
+  time_t fire = (day * SECS_PER_DAY) + (AlarmHour(n) * SECS_PER_HOUR) + (AlarmMinute(n) * SECS_PER_MIN);
+
+  if (AlarmDays[n] == 0)
+    return 0;
+
+  for (byte i = 0; i < 8; i++)    // Today, through the same day next week
+  {
+    if ((fire > after) && (AlarmDays[n] & (1 << weekday)))
+      return fire;
+    fire += SECS_PER_DAY;
+    if (++weekday > 6)
+      weekday = 0;
+  }
+  return 0;
+}
+
+void ScheduleAlarms (void)
+{ // Work out NextAlarmAt, the next time that loop() should sound the alarm.
+  // Call whenever an alarm, AlarmEnabled, or the snooze changes, when the alarm sounds,
+  // and when the clock is set.  loop() then only needs to compare it against the time.
+  time_t fire;
+
+  NextAlarmAt = 0;
+  if (AlarmEnabled == 0)
+    return;
+
+  if (snoozed)
+    NextAlarmAt = SnoozeUntil;
+
+  for (byte n = 0; n < a5_ALARMS; n++)
+  {
+    fire = AlarmNextFire(n, TimeNowStamp);
+    if (fire && ((NextAlarmAt == 0) || (fire < NextAlarmAt)))
+      NextAlarmAt = fire;
+  }
 }
 
 void TurnOffAlarm(void)
@@ -252,12 +462,320 @@ void TurnOffAlarm(void)
     snoozed = 0;
     alarmNow = 0;
     a5noTone();
+    ScheduleAlarms();
 
     if (modeShowMenu == 0) 
       DisplayWordSequence(2); // Display: "ALARM OFF", EXCEPT if we are in the menus.
   }
 }  
 
+/*
+ Configuration menu: one MenuItems[] entry per item, in menu order.  Items with a setting are run by
+ UpdateMenu() itself; the others (actions, and settings packed into DisplayMode bits) have a show()
+ function.  The O<n> serial command reads and sets the same items.
+ */
+
+byte MenuSoundTest (byte forceUpdate)
+{ 
+  DisplayWord (" +/- ", 500);   
+  if (optionValue != 0)
+  { 
+    if (alarmNow == 0)
+      alarmNow = 1;
+    else        
+      TurnOffAlarm();
+    optionValue = 0;
+  }
+  return 1;
+}
+
+byte MenuDisplayStyle (byte forceUpdate)
+{  
+  byte temp = (DisplayMode & 3U);
+
+  if (optionValue != 0){ 
+    if (optionValue == 1) 
+      temp = (temp + 1) & 3U;  
+    else if (temp == 0) 
+      temp = 3; 
+    else
+      temp--;
+
+    DisplayMode = (DisplayMode & 12U) | (temp);
+    optionValue = 0;
+    forceUpdate = 1;
+  }   
+  TimeDisplay(DisplayMode & 3, forceUpdate); // Show clock time, in appropriate style
+  return 0;
+}
+
+byte MenuAltMode (byte forceUpdate)
+{  // Alternate with seconds or date:
+  // if (TimeDisplay & 4): Alternate date with time
+  // if (TimeDisplay & 8): Alternate date with seconds
+  // if (TimeDisplay & 16): Alternate date with words
+
+  if (optionValue != 0)
+  {
+    byte temp = 1;
+    if ( DisplayMode & 4)
+      temp = 2;
+    if ( DisplayMode & 8)
+      temp = 3;
+    if ( DisplayMode & 16)
+      temp = 4;    
+
+    temp += optionValue;
+
+    if (temp == 0) 
+      temp = 4; // Wrap around (low side)
+    else if (temp == 5)
+      temp = 0;  // wrap around (high side) 
+
+    DisplayMode &= 3U;
+
+    if (temp > 1)
+      DisplayMode |= (1 << temp);
+    // if temp is 0 or 1, display time only.
+
+    DisplayModePhaseCount = 0;  
+    optionValue = 0; 
+  }
+
+  if (DisplayMode & 4U)
+    DisplayWord ("DATE ", 500);
+  else if (DisplayMode & 8U){
+    DisplayWord ("SECS ", 500);
+    DisplayWordDP("___1_"); 
+  }
+  else if (DisplayMode & 16U){
+    DisplayWord ("WORDS", 500);
+  }     
+  else
+    DisplayWord (" NONE", 500);
+  return 1;
+}
+
+byte MenuWatch (byte forceUpdate)
+{
+  if (optionValue != 0)
+  {  // + or -: show the stopwatch, stopped at zero.  (+ then starts it.)
+    optionValue = 0;
+    modeShowMenu = 0;
+    StartWatch('S', 0, 0);
+    return 0;
+  }
+  DisplayWord ("WATCH", 500);
+  return 1;
+}
+
+byte MenuSetYear (byte forceUpdate)
+{  
+  if (optionValue != 0){
+    AdjDayMonthYear(0,0,optionValue); // Day, Month, Year
+    optionValue = 0;
+    forceUpdate = 1; 
+  }    
+  TimeDisplay(35, forceUpdate); // Show clock time, in appropriate style
+  return 0;
+}
+
+byte MenuSetMonth (byte forceUpdate)
+{  
+  if (optionValue != 0){  
+    AdjDayMonthYear(0,optionValue,0); // Day, Month, Year
+    optionValue = 0;
+    forceUpdate = 1;
+  }   
+  TimeDisplay(33, forceUpdate); // Show clock time, in appropriate style
+  return 0;
+} 
+
+byte MenuSetDay (byte forceUpdate)
+{  
+  if (optionValue != 0){ 
+    AdjDayMonthYear(optionValue,0,0); // Day, Month, Year
+    optionValue = 0;
+    forceUpdate = 1;
+  }   
+  TimeDisplay(33, forceUpdate); // Show clock time, in appropriate style
+  return 0;
+}   
+
+byte MenuSetSeconds (byte forceUpdate)
+{  
+  if (optionValue != 0){ 
+    adjustTime(optionValue); // Adjust by +/- 1 second
+    UpdateClockTime();
+    if (UseRTC)  
+      RTCSet(now()); 
+    optionValue = 0;
+    forceUpdate = 1;
+  }   
+  TimeDisplay(32, forceUpdate); // Show clock time, seconds
+  return 0;
+}    
+
+void MenuNightLightChanged (void)
+{
+  if  (NightLightType == 4) 
+  {
+    NightLightStep = 0;
+    NightLightSign = 1;  
+  }
+  updateNightLight();
+}
+
+void MenuNumbersChanged (void)
+{
+  a5loadAltNumbers(numberCharSet);
+}
+
+const char MenuHourLabels[] PROGMEM = "AM/PM24 HR";
+const char MenuNightLightLabels[] PROGMEM = " NONE LOW  MED  HIGHSLEEP";
+const char MenuToneLabels[] PROGMEM = "X LOW LOW  MED  HIGHSIREN TINK";
+const char MenuNumbersLabel[] PROGMEM = "01237";   // Sample font display
+const char MenuYearTitle[] PROGMEM = "YEAR ___12";
+const char MenuMonthTitle[] PROGMEM = "MONTH_____";
+const char MenuDayTitle[] PROGMEM = "DAY  __12_";
+const char MenuSecondsTitle[] PROGMEM = "SECS ___12";
+const char MenuWatchTitle[] PROGMEM = "WATCH_____";
+
+const MenuItem_t MenuItems[] PROGMEM = {
+  // setting          max  labels                onChange                show               seq title              EEPROM        default                  flags
+  { &HourMode24,      1,   MenuHourLabels,       NULL,                   NULL,              0,  NULL,              1,            a5HourMode24Default,     0 },
+  { &NightLightType,  4,   MenuNightLightLabels, MenuNightLightChanged,  NULL,              4,  NULL,              6,            a5NightLightTypeDefault, 0 },
+  { &AlarmTone,       5,   MenuToneLabels,       NULL,                   NULL,              6,  NULL,              5,            a5AlarmToneDefault,      0 },
+  { NULL,             0,   NULL,                 NULL,                   MenuSoundTest,     3,  NULL,              MenuNoEEPROM, 0,                       0 },
+  { &numberCharSet,   9,   MenuNumbersLabel,     MenuNumbersChanged,     NULL,              7,  NULL,              7,            a5NumberCharSetDefault,  MenuOneLabel },
+  { NULL,             0,   NULL,                 NULL,                   MenuDisplayStyle,  8,  NULL,              MenuNoEEPROM, 0,                       0 },
+  { NULL,             0,   NULL,                 NULL,                   MenuSetYear,       0,  MenuYearTitle,     MenuNoEEPROM, 0,                       0 },
+  { NULL,             0,   NULL,                 NULL,                   MenuSetMonth,      0,  MenuMonthTitle,    MenuNoEEPROM, 0,                       0 },
+  { NULL,             0,   NULL,                 NULL,                   MenuSetDay,        0,  MenuDayTitle,      MenuNoEEPROM, 0,                       0 },
+  { NULL,             0,   NULL,                 NULL,                   MenuSetSeconds,    0,  MenuSecondsTitle,  MenuNoEEPROM, 0,                       0 },
+  { NULL,             0,   NULL,                 NULL,                   MenuAltMode,       9,  NULL,              MenuNoEEPROM, 0,                       0 },
+  { NULL,             0,   NULL,                 NULL,                   MenuWatch,         0,  MenuWatchTitle,    MenuNoEEPROM, 0,                       0 },
+};
+
+#define MenuItemsMax ((byte) (sizeof(MenuItems) / sizeof(MenuItem_t)) - 1)
+
+
+void MenuLabel (byte n, char label[])
+{ // The five-character label for the present value of menu item n, which must have a setting.
+  MenuItem_t item;
+  memcpy_P(&item, &MenuItems[n], sizeof(item));
+
+  const char *text = item.labels;
+  if ((item.flags & MenuOneLabel) == 0)
+    text += 5 * (*item.setting);
+  memcpy_P(label, text, 5);
+}
+
+byte MenuSetValue (byte n, byte value)
+{ // Set menu item n's setting, as if by + and -.  Returns 1 if the item has a setting, and value is in range.
+  MenuItem_t item;
+  memcpy_P(&item, &MenuItems[n], sizeof(item));
+
+  if ((item.setting == NULL) || (value > item.maxValue))
+    return 0;
+  *item.setting = value;
+  if (item.onChange)
+    item.onChange();
+  return 1;
+}
+
+void MenuReadEEPROM (void)
+{ // Load each menu setting that has an EEPROM address, checking it against the item's range.
+  MenuItem_t item;
+
+  for (byte n = 0; n <= MenuItemsMax; n++)
+  {
+    memcpy_P(&item, &MenuItems[n], sizeof(item));
+    if ((item.setting == NULL) || (item.eeAddress == MenuNoEEPROM))
+      continue;
+    byte value = EEPROM.read(item.eeAddress);
+    *item.setting = (value > item.maxValue) ? item.defaultValue : value;
+  }
+}
+
+byte MenuWriteEEPROM (void)
+{ // Write any menu settings that differ from those in EEPROM; returns 1 if any were written.
+  MenuItem_t item;
+  byte written = 0;
+
+  for (byte n = 0; n <= MenuItemsMax; n++)
+  {
+    memcpy_P(&item, &MenuItems[n], sizeof(item));
+    if ((item.setting == NULL) || (item.eeAddress == MenuNoEEPROM))
+      continue;
+    if (EEPROM.read(item.eeAddress) != (byte) *item.setting)
+    {
+      a5writeEEPROM(item.eeAddress, *item.setting);
+      written = 1;
+    }
+  }
+  return written;
+}
+
+
+void DisplayMenuOptionName(void){
+  // Display title of menu name after switching to new menu utem.
+  MenuItem_t item;
+  char title[10];
+
+  memcpy_P(&item, &MenuItems[menuItem], sizeof(item));
+
+  if (item.titleSequence)
+    DisplayWordSequence(item.titleSequence);
+  else if (item.title)
+  {
+    memcpy_P(title, item.title, 10);
+    DisplayWord (title, 800);
+    DisplayWordDP(&title[5]);
+  }
+}
+
+
+void UpdateMenu (byte forceUpdate)
+{ // Menu mode, from UpdateDisplay(): apply + or - to the present item, and draw it.
+  MenuItem_t item;
+  char label[5];
+  byte ExtendTextDisplay;
+
+  memcpy_P(&item, &MenuItems[menuItem], sizeof(item));
+  DisplayWordDP("_____");
+
+  if (item.setting)
+  {
+    if (optionValue != 0)
+    {
+      int8_t value = *item.setting + optionValue;
+      if (value < 0)
+        value = item.maxValue;
+      if (value > (int8_t) item.maxValue)
+        value = 0;
+      *item.setting = value;
+      optionValue = 0;
+      if (item.onChange)
+        item.onChange();
+    }
+    MenuLabel(menuItem, label);
+    DisplayWord (label, 500);
+    ExtendTextDisplay = 1;
+  }
+  else
+    ExtendTextDisplay = item.show(forceUpdate);
+
+  if(forceUpdate && ExtendTextDisplay)
+  {  
+    a5clearOSB();    
+    a5loadOSB_Ascii(wordCache,a5_brightLevel);
+    a5loadOSB_DP(dpCache,a5_brightLevel);
+    a5BeginFadeToOSB();   
+  }
+}
+
+
 void checkButtons(void )
 { 
   buttonMonitor |= a5GetButtons(); 
@@ -265,6 +783,14 @@ void checkButtons(void )
   if (milliTemp  >=  NextButtonCheck)  // Typically, go through this every 20 ms.
   {
     NextButtonCheck = milliTemp + ButtonCheckInterval;
+
+    if (modeShowWatch)
+    { // The buttons run the watch, instead of the clock.
+      WatchButtons();
+      buttonStateLast = buttonMonitor;
+      buttonMonitor = 0;
+      return;
+    }
     /*
      #define a5alarmSetBtn  1				// Snooze/Set alarm button
      #define a5timeSetBtn   2				// Set time button
@@ -277,6 +803,9 @@ void checkButtons(void )
       if (VCRmode)
         EndVCRmode();  // Turn off VCR-blink mode, if it was still on.
 
+      if (modeShowVideo)
+        EndVideoMode();  // Any button returns from segment video to the clock.
+
 
       // Check to see if any of the buttons has JUST been depressed: 
 
@@ -299,15 +828,9 @@ void checkButtons(void )
             a5editFontChar ('a', 54, 1, 37);    // Define special character
             DisplayWord ("SNaZE", 1500);  
 
-            AlarmTimeSnoozeMin = minute() + 9;
-            AlarmTimeSnoozeHr = hour();
-
-            if  ( AlarmTimeSnoozeMin > 59){
-              AlarmTimeSnoozeMin -= 60;
-              AlarmTimeSnoozeHr += 1;
-            }
-            if (AlarmTimeSnoozeHr > 23)
-              AlarmTimeSnoozeHr -= 24; 
+            // Sound again at the start of the ninth minute from now
+            SnoozeUntil = TimeNowStamp - TimeNow.Second + (9 * SECS_PER_MIN);
+            ScheduleAlarms();
           }
 
         } 
@@ -392,14 +915,14 @@ void checkButtons(void )
           RedrawNow = 1; 
           TimeChanged = 2;  // One-time press: detected
           if (UseRTC)  
-            RTC.set(now()); 
+            RTCSet(now()); 
         }    
         else if ( milliTemp >= (Btn3_Plus_StartTime + 400))
         {
           adjustTime(60); // Add one minute 
           RedrawNow_NoFade = 1; 
           if (UseRTC)  
-            RTC.set(now());      
+            RTCSet(now());      
         }
 
       // Check to see if both time-set button and minus button are both currently depressed:
@@ -410,7 +933,7 @@ void checkButtons(void )
           RedrawNow = 1; 
           TimeChanged = 2;
           if (UseRTC)  
-            RTC.set(now()); 
+            RTCSet(now()); 
         }      
         else if ( milliTemp > (Btn4_Minus_StartTime + 400 ))
         {
@@ -418,7 +941,7 @@ void checkButtons(void )
           RedrawNow_NoFade = 1; 
           //          TimeChanged = 1;    
           if (UseRTC)  
-            RTC.set(now());      
+            RTCSet(now());      
         }
 
       /////////////////////////////  Time-Of-Alarm Adjustments  /////////////////////////////  
@@ -447,6 +970,7 @@ void checkButtons(void )
           RedrawNow = 1; 
           TimeChanged = 2;  // One-time press: detected
           snoozed = 0;  //  Recalculating alarm time *turns snooze off.*
+          ScheduleAlarms();
         }       
         else if ( milliTemp >= (Btn3_Plus_StartTime + 400))
         {
@@ -463,6 +987,7 @@ void checkButtons(void )
           RedrawNow = 1; 
           TimeChanged = 2; // One-time press: detected
           snoozed = 0;  //  Recalculating alarm time *turns snooze off.*
+          ScheduleAlarms();
         }      
         else if ( milliTemp >  (Btn4_Minus_StartTime + 400))
         {
@@ -544,11 +1069,12 @@ void checkButtons(void )
             {
               AlarmEnabled = 1; 
             } 
+            ScheduleAlarms();
           }
           else
           {
             if (UseRTC)  
-              RTC.set(now()); 
+              RTCSet(now()); 
           }
         }
 
@@ -630,49 +1156,6 @@ void checkButtons(void )
 }
 
 
-void DisplayMenuOptionName(void){
-  // Display title of menu name after switching to new menu utem.
-
-  switch (menuItem) {
-  case NightLightMenuItem:
-    DisplayWordSequence(4);  // Night Light
-    break;
-  case AlarmToneMenuItem:
-    DisplayWordSequence(6);  // Alarm Tone
-    break; 
-  case SoundTestMenuItem:
-    DisplayWordSequence(3); // Sound-test menu item, 3.  Display "TEST" "SOUND" "USE+-"
-    break;
-  case numberCharSetMenuItem:
-    DisplayWordSequence(7); // Font Style
-    break;
-  case DisplayStyleMenuItem:
-    DisplayWordSequence(8); // Clock Style
-    break;
-  case SetYearMenuItem:
-    DisplayWord ("YEAR ", 800); 
-    DisplayWordDP("___12");
-    break;
-  case SetMonthMenuItem:
-    DisplayWord ("MONTH", 800);   
-    break;      
-  case SetDayMenuItem:
-    DisplayWord ("DAY  ", 800);  
-    DisplayWordDP("__12_");
-    break;       
-  case SetSecondsMenuItem:
-    DisplayWord ("SECS ", 800);  
-    DisplayWordDP("___12");
-    break;   
-  case AltModeMenuItem:  
-    DisplayWordSequence(9); // "TIME AND..."
-    //    DisplayWord ("ALTW/", 2000);  
-    //   DisplayWordDP("__11_");
-    break; 
-  default:  // do nothing!
-    break;
-  }
-}
 
 
 
@@ -909,6 +1392,10 @@ void DisplayWordSequence (byte sequence)
 
 
 
+  case StoredSequence:
+    DisplayStoredStep();
+    break;
+
   default: 
     // Turn off word sequences. (Catches case 0.)
     wordSequence = 0;
@@ -922,6 +1409,7 @@ void DisplayWord (char WordIn[], unsigned int duration)
 { // Usage: DisplayWord ("ALARM", 500); 
 
   modeShowText = 1;  
+  modeShowVideo = 0;
   wordCache[0] = WordIn[0];
   wordCache[1] = WordIn[1];
   wordCache[2] = WordIn[2];
@@ -945,10 +1433,75 @@ void DisplayWordDP (char WordIn[])
   dpCache[4] = WordIn[4];
 }
 
+void ShowStored (byte type, byte index)
+{ // Show a message or word sequence from the flash store (see a5storeFind()), if there is one.
+  const byte *record = a5storeFind(type, index);
+
+  if ((record == 0) || ((type != a5_STORE_MESSAGE) && (type != a5_STORE_SEQUENCE)))
+    return;
+  if (modeShowWatch)
+    EndWatchMode();
+  modeShowVideo = 0;
+  EndVCRmode();
+
+  storedShow = record;
+  storedShowStep = 0;
+  DisplayWordSequence(StoredSequence);
+}
+
+void DisplayStoredStep (void)
+{ // Called by DisplayWordSequence(), as each word of a stored message or sequence is due.
+  byte length = pgm_read_byte(storedShow + 1);
+  const byte *data = storedShow + 2;
+  unsigned int position = storedShowStep++;
+  char word[5];
+  int n;
+  byte i;
+
+  if (pgm_read_byte(storedShow) == a5_STORE_SEQUENCE)
+  { // [5 characters] [tenths of a second], repeated
+    position *= 6;
+    if ((position + 6) > length)
+    {
+      wordSequence = 0;
+      return;
+    }
+    for (i = 0; i < 5; i++)
+      word[i] = pgm_read_byte(data + position + i);
+    DisplayWord(word, 100 * pgm_read_byte(data + position + 5));
+    return;
+  }
+
+  // A message scrolls in from the right, a character at a time, until its last character has gone.
+  if (position > (length + 4U))
+  {
+    wordSequence = 0;
+    return;
+  }
+  for (i = 0; i < 5; i++)
+  {
+    n = position + i - 4;
+    word[i] = ((n >= 0) && (n < length)) ? pgm_read_byte(data + n) : ' ';
+  }
+  DisplayWord(word, StoredScrollTime);
+}
+
 
 
 
 
+void EndVideoMode(){ 
+  modeShowVideo = 0;
+  RedrawNow_NoFade = 1;
+}
+
+void EndWatchMode(){ 
+  modeShowWatch = 0;
+  watchRunning = 0;
+  RedrawNow_NoFade = 1;
+}
+
+
 void  EndVCRmode(){ 
   if (VCRmode){
     a5_brightLevel = MBlevel[Brightness];  
@@ -961,43 +1514,137 @@ void  EndVCRmode(){
 
 
 
+/*
+ Optional RTC module (DS3231 Chronodot, or DS1307), over the alphafive library's time-limited
+ I2C.  setup() starts the clock at 2013, and shows the first frame, without waiting for it;
+ ProbeRTC() then reads it from loop(), up to RTCProbeTries times.  If it answers, the clock
+ takes its time and resyncs to it every five minutes (the Time library's default); if not, the
+ clock runs on its own, flashing until the time is set.  A resync that fails (e.g., the module
+ comes loose) leaves the clock running too.
+
+ If the time has been set over serial (ST or T) before the probe answers, that time wins: the
+ RTC is set to it at the clock's next second (RTCHandOver()), and only then becomes the source.
+ */
+
+time_t RTCGet (void)
+{ // The RTC's time, or 0 if it doesn't answer, or was never set.  (For setSyncProvider().)
+  byte data[7];
+  tmElements_t tm;
+
+  if (a5twiRead(a5_RTC_ADDRESS, 0, data, 7) != a5_TWI_OK)
+    return 0;
+  if (data[0] & 0x80)
+    return 0;   // DS1307 clock halt bit: stopped since its battery was fitted
+
+  tm.Second = FromBCD(data[0] & 0x7f);
+  tm.Minute = FromBCD(data[1] & 0x7f);
+  tm.Hour = FromBCD(data[2] & 0x3f);
+  tm.Wday = data[3] & 7;
+  tm.Day = FromBCD(data[4] & 0x3f);
+  tm.Month = FromBCD(data[5] & 0x1f);
+  tm.Year = y2kYearToTm(FromBCD(data[6]));
+  return makeTime(tm);
+}
+
+void RTCSet (time_t t)
+{
+  byte data[7];
+  tmElements_t tm;
+
+  breakTime(t, tm);
+  data[0] = ToBCD(tm.Second);   // Clearing the DS1307 clock halt bit
+  data[1] = ToBCD(tm.Minute);
+  data[2] = ToBCD(tm.Hour);     // 24-hour mode
+  data[3] = tm.Wday;
+  data[4] = ToBCD(tm.Day);
+  data[5] = ToBCD(tm.Month);
+  data[6] = ToBCD(tmYearToY2k(tm.Year));
+  a5twiWrite(a5_RTC_ADDRESS, 0, data, 7);
+}
+
+void RTCHandOver (void)
+{ // Called from loop() once the second rtcHandOver is over, so that the RTC's second starts with the clock's.
+  rtcHandOver = 0;
+  RTCSet(now());
+  setSyncProvider(RTCGet);
+  UpdateClockTime();
+}
+
+void ProbeRTC (void)
+{ // Called from loop() while rtcProbeTries is nonzero, once each RTCProbeInterval.
+  byte seconds;
+  byte status = a5twiRead(a5_RTC_ADDRESS, 0, &seconds, 1);
+  time_t rtcTime = (status == a5_TWI_OK) ? RTCGet() : 0;
+
+  rtcProbeAt = milliTemp + RTCProbeInterval;
+  rtcProbeTries--;
+
+  if ((status == a5_TWI_OK) && timeSynced)
+  { // Synced already: the RTC takes the clock's time, rather than the other way around
+    rtcProbeTries = 0;
+    rtcState = 'R';
+    UseRTC = 1;
+    rtcHandOver = now();
+    TelemetryPrint(PSTR("RTC detected; setting it to the time received."));
+    return;
+  }
+  if (rtcTime)
+  {
+    rtcProbeTries = 0;
+    rtcState = 'R';
+    UseRTC = 1;
+    setSyncProvider(RTCGet);   // Sets the time from the RTC now, too
+    UpdateClockTime();
+    TelemetryPrint(PSTR("System time: Set by RTC.  Rock on!"));
+    TelemetryPrintTime();
+    EndVCRmode();
+    return;
+  }
+  if (rtcProbeTries)
+    return;
+
+  if (status == a5_TWI_OK)
+  {
+    rtcState = 'S';
+    TelemetryPrint(PSTR("RTC detected, *but* I can't seem to sync to it. ;("));
+  }
+  else if (status == a5_TWI_TIMEOUT)
+  {
+    rtcState = 'B';
+    TelemetryPrint(PSTR("The RTC bus isn't responding; running without it."));
+  }
+  else
+  {
+    rtcState = 'N';
+    TelemetryPrint(PSTR("RTC not detected. I don't know what time it is.  :("));
+  }
+  TelemetryPrint(PSTR("Setting the date to 2013. I didn't exist in 1970."));
+  TelemetryPrintTime();
+}
+
+
 void setup() {     
 
   a5Init();  // Required hardware init for Alpha Clock Five library functions
 
   VCRmode = 1;
 
-  Serial.println("\nHello, World.");
-  Serial.println("Alpha Clock Five here, reporting for duty!");   
+  TelemetryPrint(PSTR("\nHello, World."));
+  TelemetryPrint(PSTR("Alpha Clock Five here, reporting for duty!"));
 
   EEReadSettings(); // Read settings stored in EEPROM
 
   if (Brightness == 0)
     Brightness = 1;       // If display is fully dark at reset, turn it up to minimum brightness.
 
-  UseRTC = a5CheckForRTC();
-  if (UseRTC)   
-  {
-    setSyncProvider(RTC.get);   // Function to get the time from the RTC (e.g., Chronodot)
-    if(timeStatus()!= timeSet) { 
-      Serial.println("RTC detected, *but* I can't seem to sync to it. ;("); 
-      UseRTC = 0;
-    }
-    else {
-      Serial.println("System time: Set by RTC.  Rock on!");  
-      EndVCRmode();
-    }
-  }
-  else
-    Serial.println("RTC not detected. I don't know what time it is.  :(");  
-
-  if ( UseRTC == 0)
-  {
-    Serial.println("Setting the date to 2013. I didn't exist in 1970.");   
-    setTime(0,0,0,1, 1, 2013);
-  }
+  // Run from 2013 until the RTC, if there is one, answers; see ProbeRTC().
+  UseRTC = 0;
+  rtcState = 0;
+  rtcProbeTries = RTCProbeTries;
+  rtcProbeAt = millis();
+  setTime(0,0,0,1, 1, 2013);
 
-  SerialPrintTime(); 
+  SetClockTime(now());
   NextClockUpdate = millis() + 1;
 
   buttonMonitor = 0;  
@@ -1011,12 +1658,10 @@ void setup() {
 
   // Alarm Setup:
   snoozed = 0;
-  alarmPrimed = 0;
   alarmNow = 0; 
   SoundSequence = 0; 
 
   NextButtonCheck = NextClockUpdate;
-  NextAlarmCheck =  NextClockUpdate;
 
   UpdateEE = 0;
   LastButtonPress = NextClockUpdate;
@@ -1042,6 +1687,8 @@ void setup() {
     AlarmEnabled = a5AlarmEnabledDefault; 
     AlarmTimeHr = a5AlarmHrDefault; 
     AlarmTimeMin = a5AlarmMinDefault; 
+    for (byte i = 0; i < a5_ALARMS; i++)
+      AlarmDays[i] = (i == 0) ? a5AlarmDaysDefault : 0;
     AlarmTone = a5AlarmToneDefault; 
     NightLightType = a5NightLightTypeDefault;   
     numberCharSet = a5NumberCharSetDefault; 
@@ -1066,12 +1713,21 @@ void setup() {
   DisplayModePhase = 0;
   DisplayModePhaseCount = 0;
 
+  ScheduleAlarms();
 }
 
 void loop() {
 
+  TracePassStart();
+
+  if (modeShowWatch)  // First, so that each hundredth is drawn as soon as possible
+    UpdateWatch();
+
   milliTemp = millis();
+  if (timeSyncPending && ((long) (micros() - timeSyncAt) >= 0))
+    ApplyTimeSync();
   checkButtons();
+  UpdateClockTime();
 
   if (UpdateBrightness)
   {
@@ -1097,7 +1753,7 @@ void loop() {
   if (VCRmode) 
   {
     if (modeShowText == 0){
-      byte temp = second() & 1; 
+      byte temp = TimeNow.Second & 1; 
       if((temp) && (VCRmode == 1))
       {
         a5_brightLevel = 0;  
@@ -1121,8 +1777,13 @@ void loop() {
     UpdateDisplay (1);   // Force redraw
     if (RedrawNow_NoFade)   // Explicitly do not fade.  Takes priority over redraw with fade.
       a5_FadeStage = -1;
-    a5LoadNextFadeStage(); 
-    a5loadVidBuf_fromOSB(); 
+    if ((modeShowVideo == 0) && (modeShowWatch == 0)) {  // Video frames are loaded when they are complete; see ShowVideoFrame().
+      a5LoadNextFadeStage(); 
+      a5loadVidBuf_fromOSB(); 
+      TraceRendered();
+    }
+    if (bootFrameMs == 0)
+      bootFrameMs = millis() | 1;   // (Never 0, once set)
 
     RedrawNow = 0;
     RedrawNow_NoFade = 0;
@@ -1131,14 +1792,17 @@ void loop() {
   {  
     NextClockUpdate = milliTemp + 10; // Reset auto-redraw timer.
     UpdateDisplay (0); // Argument 0: Only update if display data has changed.
-    a5LoadNextFadeStage();
-    a5loadVidBuf_fromOSB(); 
+    if ((modeShowVideo == 0) && (modeShowWatch == 0)) {
+      a5LoadNextFadeStage();
+      a5loadVidBuf_fromOSB(); 
+      TraceFaded();
+    }
 
     if (NightLightType >= 4)  // Only in pulse mode do we need to regularly update
       updateNightLight();
 
-    if (UpdateEE)   // Don't need to check this more than 100 times/second.
-      EESaveSettings();
+    if (UpdateEE && (modeShowWatch == 0) && StoreLoadIdle())   // Don't need to check this more than 100 times/second.
+      EESaveSettings();                       // (Not while the watch is shown: EEPROM writes take 3.3 ms each.)
 
 
 
@@ -1146,49 +1810,43 @@ void loop() {
 
   }
 
-  // Check for alarm:
-  if  (milliTemp >= NextAlarmCheck)
+  // Check for alarm.  NextAlarmAt is worked out ahead of time, by ScheduleAlarms().
+  if (NextAlarmAt && (TimeNowStamp >= NextAlarmAt))
   {
-    NextAlarmCheck = milliTemp +  500;  // Check again in 1/2 second. 
-
-    if (AlarmEnabled)  {
-      byte hourTemp = hour();
-      byte minTemp = minute();
-
-      if ((AlarmTimeHr == hourTemp ) && (AlarmTimeMin == minTemp ))
-      {
-        if (alarmPrimed){ 
-          alarmPrimed = 0;
-          alarmNow = 1;
-          snoozed = 0; 
-          SoundSequence = 0; 
-        }
-      }
-      else{
-        alarmPrimed = 1;  
-        // Prevent alarm from going off twice in the same minute, after being turned off and back on.
-      }
-
-      if (snoozed)
-        if  ((AlarmTimeSnoozeHr == hourTemp ) && (AlarmTimeSnoozeMin == minTemp ))
-        {
-          alarmNow = 1;
-          snoozed = 0; 
-          SoundSequence = 0; 
-        }
-    }
+    if (modeShowWatch)
+      EndWatchMode();
+    alarmNow = 1;
+    snoozed = 0; 
+    SoundSequence = 0; 
+    ScheduleAlarms();
   }
 
 
   if (alarmNow)
     ManageAlarm();
 
+  if (rtcProbeTries && bootFrameMs && ((long) (milliTemp - rtcProbeAt) >= 0))
+    ProbeRTC();
+  if (rtcHandOver && (now() != rtcHandOver))
+    RTCHandOver();
+
 
 
+  ExpireSerialMessage();
   if(Serial.available() ) 
   { 
+    SerialBurstMark();
+    TraceReceived();
     processSerialMessage();
   } 
+  else
+    serialBurst = 0;
+
+  TraceLatched();
+  TraceOutputStart();
+  TelemetryDrain();
+  RelayUpstream();
+  TraceOutputDone();
 
 
 }
@@ -1218,64 +1876,1683 @@ void SerialSendDataDaisyChain (char DataIn[])
 
   *toPtr++ = *fromPtr++;
   *toPtr++ = *fromPtr++;
-  *toPtr = *fromPtr; 
+  *toPtr = *fromPtr;
 
-  Serial1.write(outputBuffer);
+  // Write by length, not as a string: a binary relay count of zero would otherwise end the message.
+  Serial1.write((const uint8_t *) outputBuffer, a5_COMM_MSG_LEN);
 }
 
 
-void processSerialMessage() {
+/*
+ Segment video: V<n> messages are longer than the others, and variable in length.
+ 
+ Key frame:    [0xFF] ['V'] [unit] ['K'] [45 bytes]
+ Delta frame:  [0xFF] ['V'] [unit] ['D'] [length] [length bytes of runs]
+ 
+ Frame data are 4-bit segment intensities, two per byte, low nibble first, in a5_OSB order.
+ Each run of a delta frame is [first segment] [segment count] [(count + 1) / 2 bytes];
+ a run with a count of zero is padding. A run longer than the message or the frame (90
+ segments) is malformed: it and the rest of the message are ignored. Frames are shown as
+ soon as they are loaded, without fading. Every message is at least 13 bytes long (like the others), and no longer than 61
+ (length <= 56), so that it fits in the 64-byte receive buffer.
+ A message of another type, or longer, is dropped, data and all (for an unknown type, the rest of
+ 13 bytes), so that 0xFF bytes in its data can't be taken for headers; so are F<n> L and C<n> U
+ messages that are rejected.  Data that stop short are dropped after FramePendingTimeout.
+ */
 
-  char c,c2;
-  byte i, temp, temp2;
-  int8_t paramNo, valueNo;
-  char OutputCache[13]; 
+#define a5_VIDEO_KEY_LEN  45
 
+void ShowVideoFrame (void)
+{
+  modeShowText = 0;
+  a5_FadeStage = -1;
+  a5loadVidBuf_fromOSB();
+  TraceRendered();
+}
 
+void processVideoFrame (void)
+{ // Called once all of the data of a V<n> message are in the serial buffer.
+  byte packed[a5_VIDEO_KEY_LEN];
+  byte remaining = framePendingLength; 
+  byte first, count, length, i;
+  char type = framePendingType;
 
-  // if time sync available from serial port, update time and return true
-  while(Serial.available() >=  a5_COMM_MSG_LEN ){  // time message consists of a header and ten ascii digits
+  framePendingType = 0;
 
-    if( Serial.read() == a5_COMM_HEADER) { 
+  if ((framePendingUnit != '0') && (framePendingUnit != 0)) 
+  {  // Daisy chaining, as with Ax: Pass the frame on, with the relay count decremented.
+    if (framePendingUnit <= '9')
+    {
+      Serial1.write(a5_COMM_HEADER);
+      Serial1.write('V');
+      Serial1.write(framePendingUnit - 1);
+      Serial1.write(type);
+      if (type != 'K')
+        Serial1.write(remaining);
+    }
+    while (remaining--) {
+      byte data = Serial.read();
+      if (framePendingUnit <= '9')
+        Serial1.write(data);
+    }
+    return;
+  }
 
-      c = Serial.read() ; 
-      c2 = Serial.read();
+  if (modeShowVideo == 0)
+  {  // Entering video mode: start from a blank frame.
+    modeShowVideo = 1;
+    modeShowWatch = 0;
+    a5clearOSB();
+    EndVCRmode();
+  }
 
-      if( c == 'S' )
-      {
-        if (c2 == 'T')
-        {  // COMMAND: ST, SET TIME     
-          time_t pctime = 0;
-          for( i=0; i < 10; i++){   
-            c = Serial.read();          
-            if( c >= '0' && c <= '9'){   
-              pctime = (10 * pctime) + (c - '0') ; // convert digits to a number    
-            }
-          }   
-          setTime(pctime);   // Sync Arduino clock to the time received on the serial port
-          DisplayWord ("SYNCD", 900);
-          DisplayWordDP("____2"); 
-          Serial.println("PC Time Sync Signal Received.");
-          SerialPrintTime(); 
-          if (UseRTC)  
-            RTC.set(now());
-          EndVCRmode(); 
-        } 
-      }
-      else if( c == 'B' )
-      {
-        if ((c2 == '0') || (c2 == 0)) // B0, with either ASCII or Binary 0.
-        { // COMMAND: B0, Set Parameters 
+  if (type == 'K')
+  {
+    for (first = 0; first < a5_VIDEO_KEY_LEN; first++)
+      packed[first] = Serial.read();
+    a5loadOSB_Nibbles(packed, 0, 2 * a5_VIDEO_KEY_LEN);
+    ShowVideoFrame();
+    return;
+  }
 
-          c = Serial.read();   // B0 command: Which setting to adjust
-          c2 = Serial.read();  // Read first char of additional data
+  while (remaining >= 2)
+  {
+    first = Serial.read();
+    count = Serial.read();
+    remaining -= 2;
+
+    length = (count + 1) >> 1;
+    if ((length > remaining) || (length > a5_VIDEO_KEY_LEN))   // Malformed run: longer than the message, or the frame
+      break;
+    for (i = 0; i < length; i++)
+      packed[i] = Serial.read();
+    remaining -= length;
+
+    if (count)
+      a5loadOSB_Nibbles(packed, first, count);
+  }
 
-          if (c == '2')
-          {
-            // edit font character  
-            // c2 : Idicates which ASCII character location to edit 
-            // Read in 8 more ASCII chars:
-            // [___][_][___] <- "A", "B", "C" values, ASCII text
+  while (remaining--)   // Discard anything left over
+    Serial.read();
+
+  ShowVideoFrame();
+}
+
+
+/*
+ Flash store (F<n>).  A page of the store (see a5_STORE_PAGES in alphafive.h) is sent in pieces,
+ which are loaded straight into the flash page buffer as they arrive, and then written at once:
+   [0xFF] ['F'] [unit] ['L'] [offset] [length] [data: length bytes]   Load, in order from offset 0
+   [0xFF] ['F'] [unit] ['W'] [page] [CRC: 2 bytes] [7 bytes]          Write the loaded page
+   [0xFF] ['F'] [unit] ['?'] [page] [8 bytes]                         Report only
+   [0xFF] ['F'] [unit] ['S'] [type] [index] [7 bytes]                 Show a stored message or sequence
+ Offsets and lengths are even, and lengths at most 56.  Data shorter than 7 bytes are padded to 7,
+ so that every message is 13 to 62 bytes long.  A load at offset 0 starts a new page.  The CRC is
+ of the whole page: CRC-16/CCITT, as avr-libc's _crc_ccitt_update(), starting from 0xFFFF.
+ W and ? reply, upstream through the chain, with
+   [0xFF] ['f'] ['0'] [W or ?] [page] [status] [bytes loaded: 2] [CRC of the page in flash: 2]
+   [pages] [page size: 2]
+ status: 0 ok; 1 no store (built without a5_FLASH_STORE, or the bootloader isn't Optiboot 8+);
+ 2 no such page; 3 the page was loaded out of order, is incomplete, or doesn't match its CRC, and
+ was not written; or it was written, but doesn't read back with that CRC.
+ Multi-byte fields are least significant byte first.  Each write blanks the display for about 8 ms,
+ and sets the clock back by about 7 ms (see a5storeWritePage()); with an RTC, the next resync makes up for it.
+ EEPROM writes empty the page buffer, so settings aren't saved while a page is being loaded, not
+ even those set over serial (P<n>, L<n>): SaveSettingsSoon() leaves them to EESaveSettings().
+ */
+
+byte StoreLoadIdle (void)
+{ 
+  if (storeLoaded && ((milliTemp - storeLoadTime) > StoreLoadTimeout))
+    storeLoaded = 0;   // Abandoned
+  return (storeLoaded == 0);
+}
+
+void SaveSettingsSoon (void)
+{ // Save settings changed over serial: now, unless a page is being loaded (see above) or the watch is
+  // shown (each EEPROM write takes 3.3 ms); then, once that is over, as loop() does for UpdateEE.
+  if (StoreLoadIdle() && (modeShowWatch == 0))
+  {
+    EEWriteSettings();
+    UpdateEE = 0;
+  }
+  else
+    UpdateEE = 1;
+}
+
+void processStoreLoad (void)
+{ // Called once all of the data of an F<n> L message are in the serial buffer.
+  byte remaining = framePendingLength;
+  byte i, low, high;
+
+  framePendingType = 0;
+
+  if ((framePendingUnit != '0') && (framePendingUnit != 0)) 
+  {  // Daisy chaining, as with V<n>.
+    if (framePendingUnit <= '9')
+    {
+      Serial1.write(a5_COMM_HEADER);
+      Serial1.write('F');
+      Serial1.write(framePendingUnit - 1);
+      Serial1.write('L');
+      Serial1.write(storeLoadOffset);
+      Serial1.write(storeLoadLength);
+    }
+    while (remaining--) {
+      byte data = Serial.read();
+      if (framePendingUnit <= '9')
+        Serial1.write(data);
+    }
+    return;
+  }
+
+  if (storeLoadOffset == 0)
+  {
+    a5storeClearPage();
+    storeLoaded = 0;
+    storeCRC = 0xFFFF;
+    storeLoadError = 0;
+  }
+  if ((storeLoadOffset != storeLoaded) || ((storeLoadOffset + storeLoadLength) > a5_STORE_PAGESIZE))
+    storeLoadError = 1;
+  storeLoadTime = milliTemp;
+
+  for (i = 0; i < storeLoadLength; i += 2)
+  {
+    low = Serial.read();
+    high = Serial.read();
+    if (storeLoadError == 0)
+    {
+      a5storeLoadWord(storeLoaded, low | (high << 8));
+      storeCRC = _crc_ccitt_update(storeCRC, low);
+      storeCRC = _crc_ccitt_update(storeCRC, high);
+      storeLoaded += 2;
+    }
+  }
+
+  remaining -= storeLoadLength;
+  while (remaining--)   // Padding
+    Serial.read();
+}
+
+void processStoreMessage (char op, char unit)
+{ // Called with the header, 'F', unit and op read, for all but L.  Reads the other nine bytes.
+  char data[12];
+  byte message[a5_COMM_MSG_LEN];
+  byte page, status;
+  unsigned int loaded = storeLoaded;
+  unsigned int crc = 0xFFFF;
+  unsigned int i;
+
+  for (i = 3; i < 12; i++)
+    data[i] = Serial.read();
+
+  if ((unit != '0') && (unit != 0))
+  { // Daisy chaining, as with Ax.  The reply comes back upstream; see RelayUpstream().
+    if (unit <= '9')
+    {
+      data[0] = 'F';
+      data[1] = unit - 1;
+      data[2] = op;
+      SerialSendDataDaisyChain(data);
+    }
+    return;
+  }
+
+  if (op == 'S')
+  {
+    ShowStored(data[3], data[4]);
+    return;
+  }
+  if ((op != 'W') && (op != '?'))
+    return;
+
+  page = data[3];
+  if (a5storeReady() == 0)
+    status = 1;
+  else if (page >= a5_STORE_PAGES)
+    status = 2;
+  else
+    status = 0;
+
+  if ((op == 'W') && (status == 0))
+  {
+    if (storeLoadError || (storeLoaded != a5_STORE_PAGESIZE) || 
+        (storeCRC != (unsigned int) ((byte) data[4] | ((byte) data[5] << 8))))
+      status = 3;
+    else
+    {
+      a5storeWritePage(page);
+      if (userBankSource == 'G')
+        SelectStoredBank(userBankIndex);   // The record may have moved, or changed
+    }
+    storeLoaded = 0;
+  }
+
+  if (page < a5_STORE_PAGES)
+    for (i = 0; i < a5_STORE_PAGESIZE; i++)
+      crc = _crc_ccitt_update(crc, pgm_read_byte(a5_store + (page * a5_STORE_PAGESIZE) + i));
+
+  if ((op == 'W') && (status == 0) && (crc != storeCRC))
+    status = 3;   // Written, but not as loaded (e.g., the page buffer was emptied part way)
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'f';
+  message[2] = '0';
+  message[3] = op;
+  message[4] = page;
+  message[5] = status;
+  message[6] = loaded;
+  message[7] = loaded >> 8;
+  message[8] = crc;
+  message[9] = crc >> 8;
+  message[10] = a5_STORE_PAGES;
+  message[11] = (byte) a5_STORE_PAGESIZE;
+  message[12] = a5_STORE_PAGESIZE >> 8;
+  SerialReply(message, a5_COMM_MSG_LEN);
+}
+
+
+/*
+ Glyph banks (C<n>).  A bank of up to UserBankChars glyphs (A, B, C for each, as B02) for a run of
+ characters, which replaces them in the font until changed; see a5setGlyphBank().
+   [0xFF] ['C'] [unit] ['U'] [first] [count] [glyphs: 3 x count bytes]   Upload the bank, and use it
+   [0xFF] ['C'] [unit] ['G'] [index] [8 bytes]     Use a bank from the flash store (see F<n>)
+   [0xFF] ['C'] [unit] ['?'] [9 bytes]             Report only
+ first is the ASCII code of the first character.  Glyph data shorter than 7 bytes are padded to 7,
+ as with F<n> L.  A count of 0 (or a missing store record) returns to the font and numeral style.
+ Edits of those characters with B02 are undone.  The bank is not saved; it lasts until reset.
+ Each replies, upstream through the chain, with
+   [0xFF] ['c'] ['0'] [U, G or ?] [source: 0, 'U' or 'G'] [index] [first] [count] [5 bytes: 0]
+ */
+
+void SelectStoredBank (byte index)
+{
+  const byte *record = a5storeFind(a5_STORE_GLYPHS, index);
+  byte length;
+
+  userBankSource = 0;
+  userBankCount = 0;
+  a5setGlyphBank(a5_USERBANK, NULL, 0, 0, 0);
+  RedrawNow = 1;
+
+  if (record == 0)
+    return;
+  length = pgm_read_byte(record + 1);
+  if (length < 4)
+    return;
+
+  userBankSource = 'G';
+  userBankIndex = index;
+  userBankFirst = pgm_read_byte(record + 2);
+  userBankCount = (length - 1) / 3;
+  a5clearFontEdits(userBankFirst, userBankCount);
+  a5setGlyphBank(a5_USERBANK, record + 3, userBankFirst, userBankCount, 1);
+}
+
+void SendBankReply (char op)
+{
+  byte message[a5_COMM_MSG_LEN];
+  byte i;
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'c';
+  message[2] = '0';
+  message[3] = op;
+  message[4] = userBankSource;
+  message[5] = userBankIndex;
+  message[6] = userBankFirst;
+  message[7] = userBankCount;
+  for (i = 8; i < a5_COMM_MSG_LEN; i++)
+    message[i] = 0;
+  SerialReply(message, a5_COMM_MSG_LEN);
+}
+
+void processBankUpload (void)
+{ // Called once all of the data of a C<n> U message are in the serial buffer.
+  byte remaining = framePendingLength;
+  byte i;
+
+  framePendingType = 0;
+
+  if ((framePendingUnit != '0') && (framePendingUnit != 0)) 
+  {  // Daisy chaining, as with V<n>.
+    if (framePendingUnit <= '9')
+    {
+      Serial1.write(a5_COMM_HEADER);
+      Serial1.write('C');
+      Serial1.write(framePendingUnit - 1);
+      Serial1.write('U');
+      Serial1.write(bankUploadFirst);
+      Serial1.write(bankUploadCount);
+    }
+    while (remaining--) {
+      byte data = Serial.read();
+      if (framePendingUnit <= '9')
+        Serial1.write(data);
+    }
+    return;
+  }
+
+  for (i = 0; i < remaining; i++)
+  {
+    byte data = Serial.read();
+    if (i < sizeof(userBank))
+      userBank[i] = data;
+  }
+
+  userBankSource = bankUploadCount ? 'U' : 0;
+  userBankFirst = bankUploadFirst;
+  userBankCount = bankUploadCount;
+  a5clearFontEdits(userBankFirst, userBankCount);
+  a5setGlyphBank(a5_USERBANK, userBank, userBankFirst, userBankCount, 0);
+  RedrawNow = 1;
+  SendBankReply('U');
+}
+
+void processBankMessage (char op, char unit)
+{ // Called with the header, 'C', unit and op read, for all but U.  Reads the other nine bytes.
+  char data[12];
+  byte i;
+
+  for (i = 3; i < 12; i++)
+    data[i] = Serial.read();
+
+  if ((unit != '0') && (unit != 0))
+  { // Daisy chaining, as with Ax.  The reply comes back upstream; see RelayUpstream().
+    if (unit <= '9')
+    {
+      data[0] = 'C';
+      data[1] = unit - 1;
+      data[2] = op;
+      SerialSendDataDaisyChain(data);
+    }
+    return;
+  }
+
+  if (op == 'G')
+    SelectStoredBank(data[3]);
+  else if (op != '?')
+    return;
+  SendBankReply(op);
+}
+
+
+/*
+ Stopwatch and countdown.  The watch is redrawn as each hundredth of a second begins, as counted
+ by the display refresh interrupt (a5getHundredths()), and is loaded straight into the video
+ buffer, without fading.  UpdateWatch() runs first in loop(), and while the watch is shown,
+ loop() handles one serial message per pass and leaves settings unsaved, so that no pass keeps a
+ frame waiting for long.  Each frame is timed from the start of its hundredth until it is in the
+ video buffer; W<n> reports the longest, and any hundredths that were never shown.
+
+ Up to 9:59.99, the watch shows minutes, seconds and hundredths; from 10:00.0 to 99:59.9,
+ minutes, seconds and tenths.  A countdown that reaches zero returns to the clock and sounds the
+ alarm, which is turned off (or snoozed) as usual.
+ */
+
+void StartWatch (byte type, unsigned long length, byte running)
+{
+  modeShowWatch = type;
+  watchLength = length;
+  watchElapsed = 0;
+  watchRunning = running;
+  watchTick = a5getHundredths(NULL);
+  watchBase = watchTick;
+  watchRedraw = 1;
+  watchWorstUs = 0;
+  watchFrames = 0;
+  watchMissed = 0;
+
+  modeShowText = 0;
+  modeShowAlarmTime = 0;
+  modeShowVideo = 0;
+  a5_FadeStage = -1;
+  EndVCRmode();
+}
+
+unsigned long WatchReading (unsigned long tick)
+{ // Hundredths shown: counted up, or (for a countdown) left to go.
+  unsigned long elapsed = watchRunning ? (tick - watchBase) : watchElapsed;
+
+  if (modeShowWatch == 'C')
+    return (elapsed < watchLength) ? (watchLength - elapsed) : 0;
+  return (elapsed < a5_WATCH_MAX) ? elapsed : a5_WATCH_MAX;
+}
+
+void WatchStartStop (void)
+{
+  unsigned long tick = a5getHundredths(NULL);
+
+  if (watchRunning)
+  {
+    watchElapsed = tick - watchBase;
+    watchRunning = 0;
+  }
+  else
+  {
+    watchBase = tick - watchElapsed;
+    watchRunning = 1;
+  }
+  watchRedraw = 1;
+}
+
+void WatchReset (void)
+{
+  watchRunning = 0;
+  watchElapsed = 0;
+  watchRedraw = 1;
+}
+
+void WatchButtons (void)
+{ // + starts and stops the watch, - resets it, and either Set button returns to the clock.
+  byte pressed = buttonMonitor & ~buttonStateLast;
+  byte released = buttonStateLast & ~buttonMonitor;
+
+  if (pressed & a5_plusBtn)
+    WatchStartStop();
+  if (pressed & a5_minusBtn)
+    WatchReset();
+  if (released & (a5_alarmSetBtn | a5_timeSetBtn))
+    EndWatchMode();
+}
+
+void UpdateWatch (void)
+{ // Called first thing in each pass through loop(), while the watch is shown.
+  unsigned int sinceUs;
+  unsigned long tick = a5getHundredths(&sinceUs);
+  unsigned long startUs = micros();
+
+  if (watchRedraw == 0)
+  {
+    if (tick == watchTick)
+      return;
+    if (watchRunning == 0)
+    {  // Nothing new to show
+      watchTick = tick;
+      return;
+    }
+    if ((tick - watchTick) > 1)
+    {
+      unsigned long missed = watchMissed + (tick - watchTick - 1);
+      watchMissed = (missed > 65535) ? 65535 : missed;
+    }
+  }
+  watchTick = tick;
+  watchRedraw = 0;
+
+  unsigned long reading = WatchReading(tick);
+
+  if (watchRunning && (modeShowWatch == 'C') && (reading == 0))
+  {  // Time's up
+    EndWatchMode();
+    alarmNow = 1;
+    snoozed = 0;
+    SoundSequence = 0;
+    return;
+  }
+  if (watchRunning && (reading == a5_WATCH_MAX))
+  {  // Stopwatch: stop at the end of its range
+    watchElapsed = a5_WATCH_MAX;
+    watchRunning = 0;
+  }
+
+  unsigned int minutes = reading / 6000;
+  unsigned int rest = reading - (minutes * 6000UL);   // Hundredths since the minute began
+  byte seconds = rest / 100;
+  byte hundredths = rest - (seconds * 100);
+  byte secondsTens = U8DIVBY10(seconds);
+  byte hundredthsTens = U8DIVBY10(hundredths);
+  char WordIn[] = "     ";
+
+  if (minutes < 10)
+  {  // M:SS.hh
+    WordIn[0] = minutes + a5_integerOffset;
+    WordIn[1] = secondsTens + a5_integerOffset;
+    WordIn[2] = (seconds - 10 * secondsTens) + a5_integerOffset;
+    WordIn[3] = hundredthsTens + a5_integerOffset;
+    WordIn[4] = (hundredths - 10 * hundredthsTens) + a5_integerOffset;
+    ComposeTimeLayers(WordIn, "121__");
+  }
+  else
+  {  // MM:SS.h
+    byte minutesTens = U8DIVBY10(minutes);
+    WordIn[0] = minutesTens + a5_integerOffset;
+    WordIn[1] = (minutes - 10 * minutesTens) + a5_integerOffset;
+    WordIn[2] = secondsTens + a5_integerOffset;
+    WordIn[3] = (seconds - 10 * secondsTens) + a5_integerOffset;
+    WordIn[4] = hundredthsTens + a5_integerOffset;
+    ComposeTimeLayers(WordIn, "_121_");
+  }
+  a5loadVidBuf_fromOSB();
+
+  unsigned long frameUs = sinceUs + (micros() - startUs);
+  if (frameUs > watchWorstUs)
+    watchWorstUs = (frameUs > 65535) ? 65535 : frameUs;
+  if (watchFrames < 65535)
+    watchFrames++;
+}
+
+
+/*
+ Watch: W<n> messages are binary, least significant byte first.
+
+ [0xFF] ['W'] [unit] [action] [hundredths: 4 bytes] [5 bytes, ignored]
+   Actions:  'S'  Show the stopwatch, and start it from zero
+             'C'  Show a countdown from "hundredths" (1 to 599999), and start it
+             'G'  Go: start (or resume) the watch      'H'  Hold: stop the watch
+             'R'  Reset: stop, at zero or the start of the countdown
+             'X'  Return to the clock                  '?'  Report only
+ The unit replies with
+ [0xFF] ['w'] ['0'] [mode] [reading: 3 bytes] [longest frame, us: 2 bytes] [frames: 2 bytes]
+   [missed hundredths: 2 bytes]
+   where mode is 0 for the clock, 'S' or 'C' for a running stopwatch or countdown, or 's' or 'c'
+   for a stopped one, and the reading is in hundredths.  The counts start over with 'S' or 'C'.
+ Addressed and relayed as with G<n>.
+ */
+
+void SerialSendWatch (void)
+{
+  byte outputBuffer[a5_COMM_MSG_LEN];
+  unsigned long reading = modeShowWatch ? WatchReading(a5getHundredths(NULL)) : 0;
+
+  outputBuffer[0] = a5_COMM_HEADER;
+  outputBuffer[1] = 'w';
+  outputBuffer[2] = '0';
+  outputBuffer[3] = modeShowWatch;
+  if (modeShowWatch && (watchRunning == 0))
+    outputBuffer[3] += 'a' - 'A';
+  outputBuffer[4] = reading;
+  outputBuffer[5] = reading >> 8;
+  outputBuffer[6] = reading >> 16;
+  outputBuffer[7] = watchWorstUs;
+  outputBuffer[8] = watchWorstUs >> 8;
+  outputBuffer[9] = watchFrames;
+  outputBuffer[10] = watchFrames >> 8;
+  outputBuffer[11] = watchMissed;
+  outputBuffer[12] = watchMissed >> 8;
+
+  SerialReply(outputBuffer, a5_COMM_MSG_LEN);
+}
+
+void processWatchMessage (char unit)
+{
+  byte message[a5_COMM_MSG_LEN];
+  byte i;
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'W';
+  message[2] = unit;
+  for (i = 3; i < a5_COMM_MSG_LEN; i++)
+    message[i] = Serial.read();
+
+  if ((unit != '0') && (unit != 0))
+  { // Daisy chaining, as with Ax.  The reply comes back upstream; see RelayUpstream().
+    if (unit <= '9')
+    {
+      message[2] = unit - 1;
+      Serial1.write(message, a5_COMM_MSG_LEN);
+    }
+    return;
+  }
+
+  unsigned long length = message[4] | ((unsigned int) message[5] << 8) | ((unsigned long) message[6] << 16) | ((unsigned long) message[7] << 24);
+  byte action = message[3];
+
+  if (action == 'S')
+    StartWatch('S', 0, 1);
+  else if ((action == 'C') && (length > 0) && (length <= a5_WATCH_MAX))
+    StartWatch('C', length, 1);
+  else if (modeShowWatch)
+  {
+    if (((action == 'G') && (watchRunning == 0)) || ((action == 'H') && watchRunning))
+      WatchStartStop();
+    else if (action == 'R')
+      WatchReset();
+    else if (action == 'X')
+      EndWatchMode();
+  }
+  SerialSendWatch();
+}
+
+
+/*
+ Settings snapshot: the values stored in EEPROM, in EEPROM order, as raw binary values
+ (e.g., AlarmTimeHr is 0-23, not 100-123). Used by the G<n> and P<n> serial commands.
+ */
+
+#define a5_SETTINGS_LEN  9
+
+const byte SettingsMax[a5_SETTINGS_LEN] PROGMEM = {
+  BrightnessMax, 1, 1, 23, 59, 5, 4, 9, 31 };   // Same limits as EEReadSettings()
+
+void SettingsSnapshot (byte settings[])
+{
+  settings[0] = Brightness;
+  settings[1] = HourMode24;
+  settings[2] = AlarmEnabled;
+  settings[3] = AlarmTimeHr;
+  settings[4] = AlarmTimeMin;
+  settings[5] = AlarmTone;
+  settings[6] = NightLightType;
+  settings[7] = numberCharSet;
+  settings[8] = DisplayMode;
+}
+
+byte SettingsChecksum (byte settings[])
+{ // Seven bits, so that a reply never contains a second header byte.
+  byte sum = 0;
+  for (byte i = 0; i < a5_SETTINGS_LEN; i++)
+    sum += settings[i];
+  return (sum & 127);
+}
+
+byte SettingsRestore (byte settings[], byte checksum)
+{ 
+  // Apply a complete settings snapshot, and save it to EEPROM-- all of it, or (if the checksum
+  // or any value is out of range) none of it.  Returns 1 if the settings were applied.
+
+  byte i;
+
+  if (checksum != SettingsChecksum(settings))
+    return 0;
+  for (i = 0; i < a5_SETTINGS_LEN; i++)
+    if (settings[i] > pgm_read_byte(&SettingsMax[i]))
+      return 0;
+
+  Brightness = settings[0];
+  HourMode24 = settings[1];
+  AlarmEnabled = settings[2];
+  AlarmTimeHr = settings[3];
+  AlarmTimeMin = settings[4];
+  AlarmTone = settings[5];
+  NightLightType = settings[6];
+  numberCharSet = settings[7];
+  DisplayMode = settings[8];
+
+  SaveSettingsSoon();
+
+  a5loadAltNumbers(numberCharSet);
+  updateNightLight();
+  DisplayModePhase = 0;
+  DisplayModePhaseCount = 0;
+  ScheduleAlarms();
+  UpdateBrightness = 1;
+  RedrawNow = 1;
+  return 1;
+}
+
+void SerialSendSettings (char type)
+{ // Reply to G<n> or P<n>: [0xFF] [type] ['0'] [9 settings] [checksum]
+  byte outputBuffer[a5_COMM_MSG_LEN];
+
+  outputBuffer[0] = a5_COMM_HEADER;
+  outputBuffer[1] = type;
+  outputBuffer[2] = '0';
+  SettingsSnapshot(&outputBuffer[3]);
+  outputBuffer[3 + a5_SETTINGS_LEN] = SettingsChecksum(&outputBuffer[3]);
+
+  SerialReply(outputBuffer, a5_COMM_MSG_LEN);
+}
+
+
+/*
+ Alarms: L<n> messages are binary.
+
+ Read:   [0xFF] ['L'] [unit] ['?'] [alarm] [8 bytes, ignored]
+ Write:  [0xFF] ['L'] [unit] ['='] [alarm] [days] [hour] [minute] [5 bytes, ignored]
+   Days: bit 0 for Sunday, through bit 6 for Saturday; 0 for an alarm that never sounds.
+   A write is saved to EEPROM at once, or (if any value is out of range) ignored.
+ Both reply [0xFF] ['l'] ['0'] [alarm] [number of alarms] [days] [hour] [minute]
+   [time_t: 4 bytes, least significant first] [0], where the time is when the alarm will
+   next sound (whether or not AlarmEnabled is on), or 0 if it never will.
+ Addressed and relayed as with G<n>.  Alarm 0 is the one set with the buttons.
+ */
+
+void SerialSendAlarm (byte n)
+{
+  byte outputBuffer[a5_COMM_MSG_LEN];
+  time_t fire = 0;
+
+  outputBuffer[0] = a5_COMM_HEADER;
+  outputBuffer[1] = 'l';
+  outputBuffer[2] = '0';
+  outputBuffer[3] = n;
+  outputBuffer[4] = a5_ALARMS;
+  outputBuffer[5] = 0;
+  outputBuffer[6] = 0;
+  outputBuffer[7] = 0;
+  if (n < a5_ALARMS)
+  {
+    outputBuffer[5] = AlarmDays[n];
+    outputBuffer[6] = AlarmHour(n);
+    outputBuffer[7] = AlarmMinute(n);
+    fire = AlarmNextFire(n, TimeNowStamp);
+  }
+  outputBuffer[8] = fire;
+  outputBuffer[9] = fire >> 8;
+  outputBuffer[10] = fire >> 16;
+  outputBuffer[11] = fire >> 24;
+  outputBuffer[12] = 0;
+
+  SerialReply(outputBuffer, a5_COMM_MSG_LEN);
+}
+
+void processAlarmMessage (char unit)
+{
+  byte message[a5_COMM_MSG_LEN];
+  byte i;
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'L';
+  message[2] = unit;
+  for (i = 3; i < a5_COMM_MSG_LEN; i++)
+    message[i] = Serial.read();
+
+  if ((unit != '0') && (unit != 0))
+  { // Daisy chaining, as with Ax.  The reply comes back upstream; see RelayUpstream().
+    if (unit <= '9')
+    {
+      message[2] = unit - 1;
+      Serial1.write(message, a5_COMM_MSG_LEN);
+    }
+    return;
+  }
+
+  byte n = message[4];
+
+  if ((message[3] == '=') && (n < a5_ALARMS) && (message[5] <= 127) && (message[6] <= 23) && (message[7] <= 59))
+  {
+    AlarmDays[n] = message[5];
+    if (n == 0)
+    {
+      AlarmTimeHr = message[6];
+      AlarmTimeMin = message[7];
+    }
+    else
+    {
+      AlarmMoreHr[n - 1] = message[6];
+      AlarmMoreMin[n - 1] = message[7];
+    }
+    SaveSettingsSoon();
+    ScheduleAlarms();
+    RedrawNow = 1;
+  }
+  SerialSendAlarm(n);
+}
+
+
+/*
+ Menu settings: O<n> messages are binary, and use the configuration menu's own table (MenuItems[]).
+
+ Read:   [0xFF] ['O'] [unit] ['?'] [item] [8 bytes, ignored]
+ Write:  [0xFF] ['O'] [unit] ['='] [item] [value] [7 bytes, ignored]
+   As if set with + and - in the menu; saved to EEPROM a few seconds later, as from the buttons.
+   Ignored unless the item has a setting and the value is in range.
+ Both reply [0xFF] ['o'] ['0'] [item] [number of items] [value] [maximum] [label: 5 ASCII] [0]
+   The maximum is 0 for items that can't be set this way (e.g., SET YEAR); the label is then
+   the item's title, if it has a one-word title, or blank.
+ Addressed and relayed as with G<n>.
+ */
+
+void SerialSendMenuItem (byte n)
+{
+  byte outputBuffer[a5_COMM_MSG_LEN];
+  MenuItem_t item;
+  byte i;
+
+  outputBuffer[0] = a5_COMM_HEADER;
+  outputBuffer[1] = 'o';
+  outputBuffer[2] = '0';
+  outputBuffer[3] = n;
+  outputBuffer[4] = MenuItemsMax + 1;
+  outputBuffer[5] = 0;
+  outputBuffer[6] = 0;
+  for (i = 7; i < 12; i++)
+    outputBuffer[i] = ' ';
+  outputBuffer[12] = 0;
+
+  if (n <= MenuItemsMax)
+  {
+    memcpy_P(&item, &MenuItems[n], sizeof(item));
+    if (item.setting)
+    {
+      outputBuffer[5] = *item.setting;
+      outputBuffer[6] = item.maxValue;
+      MenuLabel(n, (char *) &outputBuffer[7]);
+    }
+    else if (item.title)
+      memcpy_P(&outputBuffer[7], item.title, 5);
+  }
+
+  SerialReply(outputBuffer, a5_COMM_MSG_LEN);
+}
+
+void processMenuMessage (char unit)
+{
+  byte message[a5_COMM_MSG_LEN];
+  byte i;
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'O';
+  message[2] = unit;
+  for (i = 3; i < a5_COMM_MSG_LEN; i++)
+    message[i] = Serial.read();
+
+  if ((unit != '0') && (unit != 0))
+  { // Daisy chaining, as with Ax.  The reply comes back upstream; see RelayUpstream().
+    if (unit <= '9')
+    {
+      message[2] = unit - 1;
+      Serial1.write(message, a5_COMM_MSG_LEN);
+    }
+    return;
+  }
+
+  byte n = message[4];
+
+  if ((message[3] == '=') && (n <= MenuItemsMax) && MenuSetValue(n, message[5]))
+  {
+    UpdateEE = 1;
+    LastButtonPress = milliTemp;   // Start EESaveSettings()'s four-second wait
+    RedrawNow = 1;
+  }
+  SerialSendMenuItem(n);
+}
+
+
+/*
+ Sub-second time sync: T<n> messages are binary, least significant byte first.
+
+ Echo:  [0xFF] ['T'] [unit] ['E'] [sequence] [8 bytes, ignored]
+   Addressed and relayed as with A<n>; the unit replies at once with
+   [0xFF] ['t'] ['0'] ['E'] [sequence] [the same 8 bytes], so that the host can measure
+   the round trip to it.
+
+ Sync:  [0xFF] ['T'] [hops] ['S'] [sequence] [time_t: 4 bytes] [microseconds: 3 bytes] [1 byte, ignored]
+   The time (local, as for ST) as of the arrival of the message.  Every unit in the chain
+   acts on it: the clock is set at its next second rollover, rather than at once, so that
+   the rollover lands where the sender's does.  The unit acks upstream with
+   [0xFF] ['t'] [hops] ['S'] [sequence] [the time and microseconds it received], and passes
+   the message on with "hops" counted up and the time moved on by the time it held the
+   message, plus the time the message takes on the wire to the next unit.
+   The arrival is the one of SerialMessageArrival(), so that a late pass of loop() isn't
+   counted as time on the wire.
+ */
+
+#define a5_SYNC_WIRE_US  6771   // One 13-byte message at 19200 baud
+
+void ApplyTimeSync (void)
+{ // Called from loop(), once the pending second has begun.
+  timeSyncPending = 0;
+  timeSynced = 1;
+  setTime(timeSyncSecond);
+  UpdateClockTime();
+  if (UseRTC)
+    RTCSet(now());   // Starts the RTC's second here too, which keeps the phase through its periodic resync.
+}
+
+void SerialPutTime (byte message[], time_t seconds, unsigned long us)
+{
+  message[5] = seconds;
+  message[6] = seconds >> 8;
+  message[7] = seconds >> 16;
+  message[8] = seconds >> 24;
+  message[9] = us;
+  message[10] = us >> 8;
+  message[11] = us >> 16;
+}
+
+void processTimeSync (char unit)
+{ // Called with the header, 'T', and unit read; reads the other ten bytes.
+  unsigned long arrival = SerialMessageArrival();
+  byte message[a5_COMM_MSG_LEN];
+  byte i;
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'T';
+  message[2] = unit;
+  for (i = 3; i < a5_COMM_MSG_LEN; i++)
+    message[i] = Serial.read();
+
+  if (message[3] == 'E')
+  { 
+    if ((unit == '0') || (unit == 0))
+    {
+      message[1] = 't';
+      message[2] = '0';
+      SerialReply(message, a5_COMM_MSG_LEN);
+    }
+    else if (unit <= '9')
+    { // Daisy chaining, as with Ax.  The reply comes back upstream; see loop().
+      message[2] = unit - 1;
+      Serial1.write(message, a5_COMM_MSG_LEN);
+    }
+    return;
+  }
+
+  if (message[3] != 'S')
+    return;
+
+  time_t seconds = message[5] | ((time_t) message[6] << 8) | ((time_t) message[7] << 16) | ((time_t) message[8] << 24);
+  unsigned long us = message[9] | ((unsigned int) message[10] << 8) | ((unsigned long) message[11] << 16);
+  if (us > 999999)
+    return;
+
+  timeSyncSecond = seconds + 1;
+  timeSyncAt = arrival + (1000000 - us);
+  timeSyncPending = 1;
+
+  message[1] = 't';
+  SerialReply(message, a5_COMM_MSG_LEN);
+
+  us += (micros() - arrival) + a5_SYNC_WIRE_US;
+  while (us > 999999) {
+    us -= 1000000;
+    seconds++;
+  }
+  message[1] = 'T';
+  message[2] = unit + 1;
+  SerialPutTime(message, seconds, us);
+  Serial1.write(message, a5_COMM_MSG_LEN);
+
+  DisplayWord ("SYNCD", 900);
+  DisplayWordDP("____2"); 
+  EndVCRmode(); 
+}
+
+
+/*
+ Daisy-chain discovery: D is passed down the whole chain, and every unit reports back upstream.
+
+ Request:  [0xFF] ['D'] [index] ['?'] [sequence] [8 bytes, ignored]
+   "index" is binary, 0 from the host; each unit passes the request on with index + 1.
+
+ Each unit then sends two reports, [0xFF] ['d'] [index] [type] [sequence] [8 bytes]:
+   'U': [version major] [minor] [patch] [microseconds: 2 bytes] [boot ms: 2 bytes] [RTC]
+        Sent at once.  The time is how long this unit took to pass the request on.  Boot
+        ms is the time from start-up to the first frame; RTC is rtcState (see ProbeRTC()).
+   'H': [microseconds: 3 bytes] [5 bytes, ignored]
+        The time from passing the request on to the first byte of the next unit's 'U'
+        report: one round trip over the hop below this unit.  0 if no unit answered
+        within a5_DISCOVERY_TIMEOUT, i.e., this is the last unit in the chain.
+ Binary values are least significant byte first.  The host knows that it has heard from
+ the whole chain once a unit reports a hop time of 0.
+ */
+
+#define a5_DISCOVERY_TIMEOUT  100000   // microseconds
+
+void SerialSendDiscoveryHop (unsigned long hopTime)
+{
+  byte message[a5_COMM_MSG_LEN];
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'd';
+  message[2] = discoveryIndex;
+  message[3] = 'H';
+  message[4] = discoverySequence;
+  message[5] = hopTime;
+  message[6] = hopTime >> 8;
+  message[7] = hopTime >> 16;
+  for (byte i = 8; i < a5_COMM_MSG_LEN; i++)
+    message[i] = 0;
+
+  SerialReply(message, a5_COMM_MSG_LEN);
+  discoveryState = a5_DISCOVERY_IDLE;
+}
+
+void RelayUpstream (void)
+{ // Pass replies from further down the daisy chain back upstream, timing the hop for discovery.
+  while (Serial1.available())
+  {
+    if (discoveryState == a5_DISCOVERY_WAITING)
+    {
+      discoveryHopTime = micros() - discoverySent;
+      discoveryState = a5_DISCOVERY_HEARD;
+      discoveryRelayed = 0;
+    }
+    byte data = Serial1.read();
+    SerialReply(&data, 1);
+    if ((discoveryState == a5_DISCOVERY_HEARD) && (++discoveryRelayed == a5_COMM_MSG_LEN))
+      SerialSendDiscoveryHop(discoveryHopTime);   // Between messages, once the next unit's report is through
+  }
+
+  if ((discoveryState == a5_DISCOVERY_WAITING) && ((micros() - discoverySent) > a5_DISCOVERY_TIMEOUT))
+    SerialSendDiscoveryHop(0);   // Nothing further down the chain
+}
+
+
+/*
+ Telemetry: the text that the clock prints over serial (the startup banner, and the time
+ after ST).  At 19200 baud each byte takes half a millisecond to send, and the serial
+ transmit buffer holds only 64 bytes; printing straight to it would stall loop() (and with
+ it, fades and buttons) for as long as the buffer stays full.  Instead, lines are queued
+ here, and TelemetryDrain() hands them on, once per pass of loop(), only as far as the
+ transmit buffer has room; the UART interrupt sends them from there.
+
+ If the queue is full, a new line is dropped rather than waited for.  The time is formatted
+ as its line is sent, so a request for it right after another one, still waiting, is merged.
+
+ Binary replies (and bytes relayed from down the chain) go through SerialReply(): straight
+ to the transmit buffer if it has room and nothing is waiting, or else into serialOut, which
+ TelemetryDrain() empties after the rest of a half-sent line and before starting the next,
+ so that a reply never lands in the middle of a line.  Only when more than SerialOutLength
+ bytes are waiting -- e.g., the Q<n> trace dump, 13 bytes per entry -- does a reply wait
+ for the UART.
+ */
+
+void TelemetryPrint (const char *text)
+{ // Queue one line: a string in program memory, e.g., PSTR("..."), or 0 for the time.
+  if (telemetryCount >= TelemetryLines)
+  {
+    if (telemetryDropped < 255)
+      telemetryDropped++;
+    return;
+  }
+  telemetryLine[(telemetryHead + telemetryCount) % TelemetryLines] = text;
+  telemetryCount++;
+}
+
+void TelemetryPrintTime (void)
+{
+  if (telemetryCount && (telemetryLine[(telemetryHead + telemetryCount - 1) % TelemetryLines] == 0))
+    return;   // The last line queued is the time already
+  TelemetryPrint(0);
+}
+
+char *TelemetryNumber (char *text, unsigned int value, byte digits)
+{ // Write value in decimal, with at least the given number of digits; returns the end.
+  char reversed[5];
+  byte i = 0;
+
+  do {
+    reversed[i++] = '0' + (value % 10);
+    value /= 10;
+  } 
+  while (value || (i < digits));
+
+  while (i)
+    *text++ = reversed[--i];
+  return text;
+}
+
+char *TelemetryName (char *text, const char *name)
+{
+  while (*name)
+    *text++ = *name++;
+  return text;
+}
+
+byte TelemetryFormatTime (void)
+{ // As "9:05:07 Tuesday 19 Oct 2019"; returns the length.
+  char *text = telemetryText;
+
+  UpdateClockTime();
+  text = TelemetryNumber(text, TimeNow.Hour, 1);
+  *text++ = ':';
+  text = TelemetryNumber(text, TimeNow.Minute, 2);
+  *text++ = ':';
+  text = TelemetryNumber(text, TimeNow.Second, 2);
+  *text++ = ' ';
+  text = TelemetryName(text, dayStr(TimeNow.Wday));
+  *text++ = ' ';
+  text = TelemetryNumber(text, TimeNow.Day, 1);
+  *text++ = ' ';
+  text = TelemetryName(text, monthShortStr(TimeNow.Month));
+  *text++ = ' ';
+  text = TelemetryNumber(text, TimeNow.Year, 1);
+  return text - telemetryText;
+}
+
+byte TelemetrySendLine (int room)
+{ // Hand on up to room bytes of the line being sent; returns how many.
+  byte count = telemetryLength - telemetrySent;
+
+  if (count > room)
+    count = room;
+  Serial.write((const uint8_t *) &telemetryText[telemetrySent], count);
+  telemetrySent += count;
+  return count;
+}
+
+void TelemetryDrain (void)
+{ // Never waits: hands on no more than the transmit buffer has room for.
+  int room = Serial.availableForWrite();
+  const char *line;
+  byte count;
+
+  while (room > 0)
+  {
+    if (telemetrySent != telemetryLength)
+      room -= TelemetrySendLine(room);   // Finish the line being sent, first
+    else if (serialOutCount)
+    { // Then replies
+      count = SerialOutLength - serialOutHead;   // As far as the end of serialOut
+      if (count > serialOutCount)
+        count = serialOutCount;
+      if (count > room)
+        count = room;
+      Serial.write(&serialOut[serialOutHead], count);
+      serialOutHead = (serialOutHead + count) % SerialOutLength;
+      serialOutCount -= count;
+      room -= count;
+    }
+    else
+    { // Then the next line
+      if (telemetryCount == 0)
+        return;
+      line = telemetryLine[telemetryHead];
+      telemetryHead = (telemetryHead + 1) % TelemetryLines;
+      telemetryCount--;
+
+      if (line)
+      {
+        telemetryLength = strlen_P(line);
+        if (telemetryLength > (TelemetryTextLength - 2))
+          telemetryLength = TelemetryTextLength - 2;
+        memcpy_P(telemetryText, line, telemetryLength);
+      }
+      else
+        telemetryLength = TelemetryFormatTime();
+      telemetryText[telemetryLength++] = '\r';
+      telemetryText[telemetryLength++] = '\n';
+      telemetrySent = 0;
+    }
+  }
+}
+
+void SerialReply (const byte *data, byte length)
+{ // Send length bytes upstream, after anything already waiting.  Waits for the UART only if
+  // serialOut is full.
+  if ((serialOutCount == 0) && (telemetrySent == telemetryLength) && 
+      (Serial.availableForWrite() >= length))
+  {
+    Serial.write(data, length);
+    return;
+  }
+
+  while (length--)
+  {
+    if (serialOutCount == SerialOutLength)
+    { // Full: make room the slow way
+      TelemetrySendLine(TelemetryTextLength);
+      Serial.write(serialOut[serialOutHead]);
+      serialOutHead = (serialOutHead + 1) % SerialOutLength;
+      serialOutCount--;
+    }
+    serialOut[(serialOutHead + serialOutCount) % SerialOutLength] = *data++;
+    serialOutCount++;
+  }
+}
+
+void processDiscovery (byte index)
+{ // Called with the header, 'D', and index read; reads the other ten bytes.
+  unsigned long arrival = SerialMessageArrival();
+  byte message[a5_COMM_MSG_LEN];
+  byte i;
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'D';
+  message[2] = index + 1;
+  for (i = 3; i < a5_COMM_MSG_LEN; i++)
+    message[i] = Serial.read();
+
+  if (message[3] != '?')
+    return;
+
+  Serial1.write(message, a5_COMM_MSG_LEN);
+  discoverySent = micros();
+  discoveryState = a5_DISCOVERY_WAITING;
+  discoveryIndex = index;
+  discoverySequence = message[4];
+
+  unsigned int residence = discoverySent - arrival;
+
+  message[1] = 'd';
+  message[2] = index;
+  message[3] = 'U';
+  message[5] = a5VersionMajor;
+  message[6] = a5VersionMinor;
+  message[7] = a5VersionPatch;
+  message[8] = residence;
+  message[9] = residence >> 8;
+  message[10] = bootFrameMs;
+  message[11] = bootFrameMs >> 8;
+  message[12] = rtcState;
+  SerialReply(message, a5_COMM_MSG_LEN);
+}
+
+
+/*
+ Serial-to-photon latency trace, with a5_TRACE_LATENCY defined in alphafive.h.
+
+ Each command that arrives is timed through the stages of its path to the display:
+   received   The loop finds bytes waiting in the serial receive buffer
+   parsed     processSerialMessage() reads its header and command
+   rendered   The redraw that it asked for (or its video frame) is loaded into the video buffer
+   faded      The last stage of the fade, if any, is loaded
+   latched    The refresh interrupt first latches a row of that frame
+ A stage that isn't reached (e.g., a command that doesn't change the display, or one overtaken
+ by the next command) is recorded as 0xFFFF.  The newest TraceLength commands are kept.
+
+ Q<n> dumps the trace, oldest first, one message per command, then clears it:
+   [0xFF] ['q'] [count] [index] [command] [4 stage times: 2 bytes each, least significant first]
+ Times are from "received", in units of 16 us.  With no commands traced, one message is sent,
+ with a count of 0.  A last message gives the worst stalls of loop() since the previous dump:
+   [0xFF] ['q'] [count] [0xFF] [0] [serial output] [whole pass] [lines dropped] [3 zeros]
+ the longest time that one pass spent handing serial output on (see TelemetryDrain()), and the
+ longest pass, each 2 bytes in units of 16 us; and the telemetry lines dropped, ever (1 byte).
+ (Without a5_TRACE_LATENCY, Q is ignored.)
+ */
+
+#ifdef a5_TRACE_LATENCY
+void TraceStage (byte stage)
+{ 
+  unsigned long elapsed = (micros() - traceStart) >> 4;
+  traceTime[traceNewest][stage] = (elapsed < 0xFFFF) ? elapsed : 0xFFFE;
+  traceNextStage = stage + 1;
+}
+#endif
+
+void TraceReceived (void)
+{ 
+#ifdef a5_TRACE_LATENCY
+  if ((traceNextStage == 0) || framePendingType)
+    return;   // Still waiting for the rest of the message
+  traceStart = micros();
+  traceNewest = (traceNewest + 1) % TraceLength;
+  if (traceCount < TraceLength)
+    traceCount++;
+  traceCommand[traceNewest] = 0;
+  for (byte i = 0; i < TraceStages; i++)
+    traceTime[traceNewest][i] = 0xFFFF;
+  traceNextStage = 0;
+  a5_traceLatchArmed = 0;
+#endif
+}
+
+void TraceParsed (char command)
+{ 
+#ifdef a5_TRACE_LATENCY
+  if (traceNextStage != 0)
+    return;
+  traceCommand[traceNewest] = command;
+  TraceStage(0);
+#endif
+}
+
+void TraceFaded (void)
+{ // After each load of the video buffer during a fade.
+#ifdef a5_TRACE_LATENCY
+  if ((traceNextStage != 2) || (a5_FadeStage >= 0))
+    return;
+  TraceStage(2);
+  a5_traceLatchArmed = 1;
+#endif
+}
+
+void TraceRendered (void)
+{ 
+#ifdef a5_TRACE_LATENCY
+  if (traceNextStage != 1)
+    return;
+  TraceStage(1);
+  TraceFaded();
+#endif
+}
+
+void TraceLatched (void)
+{ 
+#ifdef a5_TRACE_LATENCY
+  if ((traceNextStage != 3) || a5_traceLatchArmed)
+    return;
+  unsigned long elapsed = (a5_traceLatchTime - traceStart) >> 4;
+  traceTime[traceNewest][3] = (elapsed < 0xFFFF) ? elapsed : 0xFFFE;
+  traceNextStage = TraceStages;
+#endif
+}
+
+void TracePassStart (void)
+{ 
+#ifdef a5_TRACE_LATENCY
+  tracePassStart = micros();
+#endif
+}
+
+void TraceOutputStart (void)
+{ 
+#ifdef a5_TRACE_LATENCY
+  traceOutputStart = micros();
+#endif
+}
+
+void TraceOutputDone (void)
+{ // At the end of each pass of loop().
+#ifdef a5_TRACE_LATENCY
+  unsigned long end = micros();
+  unsigned long elapsed = (end - traceOutputStart) >> 4;
+  if (elapsed > traceOutputWorst)
+    traceOutputWorst = (elapsed < 0xFFFF) ? elapsed : 0xFFFF;
+  elapsed = (end - tracePassStart) >> 4;
+  if (elapsed > tracePassWorst)
+    tracePassWorst = (elapsed < 0xFFFF) ? elapsed : 0xFFFF;
+#endif
+}
+
+void SerialSendTrace (void)
+{ 
+#ifdef a5_TRACE_LATENCY
+  byte message[a5_COMM_MSG_LEN];
+  byte entry = (traceNewest + 1 + TraceLength - traceCount) % TraceLength;
+  byte i = 0;
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'q';
+  message[2] = traceCount;
+
+  do {
+    message[3] = i;
+    message[4] = (i < traceCount) ? traceCommand[entry] : 0;
+    for (byte j = 0; j < TraceStages; j++)
+    {
+      message[5 + 2 * j] = (i < traceCount) ? traceTime[entry][j] : 0xFF;
+      message[6 + 2 * j] = (i < traceCount) ? (traceTime[entry][j] >> 8) : 0xFF;
+    }
+    SerialReply(message, a5_COMM_MSG_LEN);
+    entry = (entry + 1) % TraceLength;
+    i++;
+  }
+  while (i < traceCount);
+
+  message[3] = 0xFF;
+  message[4] = 0;
+  message[5] = traceOutputWorst;
+  message[6] = traceOutputWorst >> 8;
+  message[7] = tracePassWorst;
+  message[8] = tracePassWorst >> 8;
+  message[9] = telemetryDropped;
+  message[10] = message[11] = message[12] = 0;
+  SerialReply(message, a5_COMM_MSG_LEN);
+
+  traceCount = 0;
+  traceNextStage = TraceStages;
+  traceOutputWorst = 0;
+  tracePassWorst = 0;
+  tracePassStart = micros();   // Not counting the time spent writing this dump
+#endif
+}
+
+
+/*
+ Screen readback: R<n>, for monitoring what a unit is showing from afar.
+ 
+ Request:  [0xFF] ['R'] [unit] [op] [9 bytes, ignored]
+   op 'C': summary only; 'F': summary and frame.  Addressed and relayed as with G<n>.
+ 
+ The unit replies, upstream through the chain, with
+ [0xFF] ['r'] ['0'] [op] [mode] [DisplayMode] [Brightness] [a5_brightMode] [a5_brightLevel]
+   [lit segments] [fading] [CRC: 2 bytes]
+   where mode is what the display belongs to: 'C' clock, 'D' date, 'L' alarm time, 'M' menu,
+   'A' text, 'T' LED test, 'V' segment video or 'W' watch; fading is 1 while a fade is in
+   progress.  The CRC is of the frame, as for the flash store (CRC-16/CCITT, from 0xFFFF),
+   so that a host can tell whether the display has changed without fetching it.
+ With op 'F', the summary is followed by the frame: a5_VIDEO_KEY_LEN bytes, as sent in a
+ V<n> key frame (4-bit intensities, two segments per byte, low nibble first, in a5_OSB
+ order), read back from the video buffer by a5readVidBuf(): a frame sent with V<n> reads
+ back as sent, except that intensities 9, 12 and 14, which look like 8, 11 and 13, read as those.
+ */
+
+char ScreenMode (void)
+{
+  if (modeShowVideo)
+    return 'V';
+  if (modeShowWatch)
+    return 'W';
+  if (modeShowText)
+    return 'A';
+  if (modeLEDTest)
+    return 'T';
+  if (modeShowMenu)
+    return 'M';
+  if (modeShowDateViaButtons)
+    return 'D';
+  if (modeShowAlarmTime)
+    return 'L';
+  return 'C';
+}
+
+void SerialSendScreen (char op)
+{
+  byte message[a5_COMM_MSG_LEN];
+  byte frame[a5_VIDEO_KEY_LEN];
+  unsigned int crc = 0xFFFF;
+  byte lit = 0;
+  byte i;
+
+  a5readVidBuf(frame);
+  for (i = 0; i < a5_VIDEO_KEY_LEN; i++)
+  {
+    crc = _crc_ccitt_update(crc, frame[i]);
+    if (frame[i] & 15)
+      lit++;
+    if (frame[i] & 240)
+      lit++;
+  }
+
+  message[0] = a5_COMM_HEADER;
+  message[1] = 'r';
+  message[2] = '0';
+  message[3] = op;
+  message[4] = ScreenMode();
+  message[5] = DisplayMode;
+  message[6] = Brightness;
+  message[7] = a5_brightMode;
+  message[8] = a5_brightLevel;
+  message[9] = lit;
+  message[10] = (a5_FadeStage >= 0);
+  message[11] = crc;
+  message[12] = crc >> 8;
+  SerialReply(message, a5_COMM_MSG_LEN);
+
+  if (op == 'F')
+    SerialReply(frame, a5_VIDEO_KEY_LEN);
+}
+
+
+void SerialBurstMark (void)
+{ // Called from loop() when bytes are waiting.  At the start of a burst, work back from how many have
+  // arrived to when the first did: to the middle of its byte time, since available() counts whole bytes.
+  if (serialBurst)
+    return;
+  unsigned long now = micros();
+  byte waiting = Serial.available();
+
+  serialBurst = 1;
+  serialBurstStart = now - (((2 * waiting) - 1) * (unsigned long) SerialByteUs) / 2;
+  serialBurstMessages = 0;
+}
+
+unsigned long SerialMessageArrival (void)
+{ // The micros() at which the last byte of the 13-byte message just parsed arrived.  For the first
+  // message of a burst, from the burst's start, plus the wire time of the bytes after its first, so
+  // that however late loop() gets round to it, that isn't counted; for any other, the time it is
+  // parsed (it waited behind another message, whose bytes may have had gaps between them).
+  if (serialBurstMessages == 1)
+    return serialBurstStart + ((a5_COMM_MSG_LEN - 1) * (unsigned long) SerialByteUs);
+  return micros();
+}
+
+void DiscardSerial (unsigned int count)
+{ // Drop the next count bytes, the data of a message whose header was rejected (see processSerialMessage()).
+  serialDiscard = count;
+  framePendingTime = millis();
+}
+
+void ExpireSerialMessage (void)
+{ // Called from loop().  If the data of a message stop short (bytes were lost), drop whatever part of
+  // them has arrived, once FramePendingTimeout has passed, and resynchronize on the next header.
+  if ((framePendingType || serialDiscard) && ((millis() - framePendingTime) > FramePendingTimeout))
+  {
+    while (Serial.available())
+      Serial.read();
+    framePendingType = 0;
+    serialDiscard = 0;
+  }
+}
+
+void processSerialMessage() {
+
+  char c,c2;
+  byte i, temp, temp2;
+  int8_t paramNo, valueNo;
+  char OutputCache[13]; 
+
+
+  while (serialDiscard && Serial.available())
+  { // Drop the data of a rejected message, so that none of it is taken for a header.
+    Serial.read();
+    serialDiscard--;
+  }
+  if (serialDiscard)
+    return;
+
+  if (framePendingType)
+  { // Finish a video frame, store load or bank upload, once all of its data have arrived.
+    if (Serial.available() < framePendingLength)
+      return;   // (See ExpireSerialMessage().)
+    else if (framePendingType == 'L')
+      processStoreLoad();
+    else if (framePendingType == 'U')
+      processBankUpload();
+    else
+      processVideoFrame();
+  }
+
+  // if time sync available from serial port, update time and return true
+  while(Serial.available() >=  a5_COMM_MSG_LEN ){  // time message consists of a header and ten ascii digits
+
+    if( Serial.read() == a5_COMM_HEADER) { 
+      if (serialBurstMessages < 255)
+        serialBurstMessages++;
+
+      c = Serial.read() ; 
+      c2 = Serial.read();
+      TraceParsed(c);
+
+      if( c == 'V' )
+      { // COMMAND: V<n>, SEGMENT VIDEO FRAME
+        c = Serial.read();  
+        if (c == 'K')
+          framePendingLength = a5_VIDEO_KEY_LEN;
+        else if (c == 'D')
+          framePendingLength = Serial.read(); 
+        else
+        { // Unknown frame type: drop the rest of a minimal, 13-byte message.
+          DiscardSerial(a5_COMM_MSG_LEN - 4);
+          return;
+        }
+
+        if (framePendingLength > 56)
+        {
+          DiscardSerial(framePendingLength);
+          return;
+        }
+
+        framePendingType = c;
+        framePendingUnit = c2;
+        framePendingTime = millis();
+
+        if (Serial.available() < framePendingLength)
+          return;   // Wait for the rest of the frame.
+        processVideoFrame();
+      }
+      else if( c == 'F' )
+      { // COMMAND: F<n>, FLASH STORE
+        c = Serial.read();
+        if (c != 'L')
+        {
+          processStoreMessage(c, c2);
+          continue;
+        }
+        storeLoadOffset = Serial.read();
+        storeLoadLength = Serial.read();
+        if ((storeLoadLength > 56) || ((storeLoadOffset | storeLoadLength) & 1))
+        {
+          DiscardSerial((storeLoadLength < 7) ? 7 : storeLoadLength);
+          return;
+        }
+
+        framePendingLength = (storeLoadLength < 7) ? 7 : storeLoadLength;
+        framePendingType = c;
+        framePendingUnit = c2;
+        framePendingTime = millis();
+
+        if (Serial.available() < framePendingLength)
+          return;   // Wait for the rest of the message.
+        processStoreLoad();
+      }
+      else if( c == 'C' )
+      { // COMMAND: C<n>, GLYPH BANK
+        c = Serial.read();
+        if (c != 'U')
+        {
+          processBankMessage(c, c2);
+          continue;
+        }
+        bankUploadFirst = Serial.read();
+        bankUploadCount = Serial.read();
+        if (bankUploadCount > UserBankChars)
+        {
+          DiscardSerial(3 * bankUploadCount);
+          return;
+        }
+
+        framePendingLength = (bankUploadCount < 3) ? 7 : (3 * bankUploadCount);
+        framePendingType = c;
+        framePendingUnit = c2;
+        framePendingTime = millis();
+
+        if (Serial.available() < framePendingLength)
+          return;   // Wait for the rest of the message.
+        processBankUpload();
+      }
+      else if( c == 'S' )
+      {
+        if (c2 == 'T')
+        {  // COMMAND: ST, SET TIME     
+          time_t pctime = 0;
+          for( i=0; i < 10; i++){   
+            c = Serial.read();          
+            if( c >= '0' && c <= '9'){   
+              pctime = (10 * pctime) + (c - '0') ; // convert digits to a number    
+            }
+          }   
+          setTime(pctime);   // Sync Arduino clock to the time received on the serial port
+          timeSynced = 1;
+          UpdateClockTime();
+          DisplayWord ("SYNCD", 900);
+          DisplayWordDP("____2"); 
+          TelemetryPrint(PSTR("PC Time Sync Signal Received."));
+          TelemetryPrintTime();
+          if (UseRTC)  
+            RTCSet(now());
+          EndVCRmode(); 
+        } 
+      }
+      else if( c == 'B' )
+      {
+        if ((c2 == '0') || (c2 == 0)) // B0, with either ASCII or Binary 0.
+        { // COMMAND: B0, Set Parameters 
+
+          c = Serial.read();   // B0 command: Which setting to adjust
+          c2 = Serial.read();  // Read first char of additional data
+
+          if (c == '2')
+          {
+            // edit font character  
+            // c2 : Idicates which ASCII character location to edit 
+            // Read in 8 more ASCII chars:
+            // [___][_][___] <- "A", "B", "C" values, ASCII text
 
             i = 100 * (Serial.read() - '0');
             i += 10 * (Serial.read() - '0');
@@ -1305,6 +3582,12 @@ void processSerialMessage() {
               a5loadAltNumbers(c2 - '0'); 
               Serial.read();  // Empty input buffer, char 3 of 10
             }
+            if (c == '3')
+            {// Select transition effect, a5_TRANSITION_FADE etc.
+              if ((byte)(c2 - '0') < a5_TRANSITIONS)
+                a5setTransition(c2 - '0'); 
+              Serial.read();  // Empty input buffer, char 3 of 10
+            }
 
             for( i=3; i < 10; i++){   
               Serial.read();  // Empty input buffer
@@ -1343,14 +3626,50 @@ void processSerialMessage() {
               dpCache[i - 5] = c;  
           }             
           modeShowText = 3;   
+          modeShowVideo = 0;
+          modeShowWatch = 0;
           RedrawNow = 1; 
           EndVCRmode();
         }
-        else { // Daisy chaining: With Ax, where x is less than 48 or x is less than 10:
+        else { // Daisy chaining: With Ax, where x is less than 48 or x is less than 10:
+          if (c2 <= '9') 
+          { // if we're here, c2 is <= '9', c2 != 0, and c2 != '0'.   
+
+            OutputCache[0] = 'A';
+            OutputCache[1] = c2 - 1;
+
+            for( i=2; i < 12; i++){   
+              OutputCache[i] = Serial.read();  
+            }   
+            SerialSendDataDaisyChain (OutputCache);            
+          }
+        }
+      }
+
+      else if( (c == 'G') || (c == 'P') )
+      {
+        if ((c2 == '0') || (c2 == 0)) 
+        { // COMMAND: G0, GET SETTINGS; P0, PUT SETTINGS
+          // G0: the rest of the message is ignored.  P0: [9 settings] [checksum], as sent by G0.
+          // Both reply with the settings now in effect, as [0xFF] ['g' or 'p'] ['0'] [9 settings] [checksum].
+          byte settings[a5_SETTINGS_LEN];
+
+          for( i=0; i < a5_SETTINGS_LEN; i++){   
+            settings[i] = Serial.read();  
+          }   
+          temp = Serial.read();
+
+          if (c == 'P')
+          {
+            SettingsRestore(settings, temp);
+            EndVCRmode();
+          }
+          SerialSendSettings(c + ('a' - 'A'));
+        }
+        else { // Daisy chaining, as with Ax.  The reply comes back upstream; see loop().
           if (c2 <= '9') 
-          { // if we're here, c2 is <= '9', c2 != 0, and c2 != '0'.   
-
-            OutputCache[0] = 'A';
+          {
+            OutputCache[0] = c;
             OutputCache[1] = c2 - 1;
 
             for( i=2; i < 12; i++){   
@@ -1361,6 +3680,68 @@ void processSerialMessage() {
         }
       }
 
+      else if( c == 'L' )
+      { // COMMAND: L<n>, READ OR WRITE AN ALARM
+        processAlarmMessage(c2);
+      }
+
+      else if( c == 'O' )
+      { // COMMAND: O<n>, READ OR SET A MENU SETTING
+        processMenuMessage(c2);
+      }
+
+      else if( c == 'W' )
+      { // COMMAND: W<n>, STOPWATCH AND COUNTDOWN
+        processWatchMessage(c2);
+      }
+
+      else if( c == 'T' )
+      { // COMMAND: T<n>, SUB-SECOND TIME SYNC
+        processTimeSync(c2);
+      }
+
+      else if( c == 'D' )
+      { // COMMAND: D, DAISY-CHAIN DISCOVERY
+        processDiscovery(c2);
+      }
+
+      else if( c == 'Q' )
+      { // COMMAND: Q<n>, DUMP LATENCY TRACE
+        if ((c2 == '0') || (c2 == 0)) 
+          SerialSendTrace();
+        else if (c2 <= '9')
+        { // Daisy chaining, as with Ax.  The reply comes back upstream; see RelayUpstream().
+          OutputCache[0] = c;
+          OutputCache[1] = c2 - 1;
+          for( i=2; i < 12; i++){   
+            OutputCache[i] = Serial.read();  
+          }   
+          SerialSendDataDaisyChain (OutputCache);            
+        }
+      }
+
+      else if( c == 'R' )
+      { // COMMAND: R<n>, READ BACK THE SCREEN
+        if ((c2 == '0') || (c2 == 0)) 
+        {
+          c = Serial.read();
+          for( i=3; i < 12; i++){   
+            Serial.read();  // Empty input buffer
+          }   
+          if ((c == 'C') || (c == 'F'))
+            SerialSendScreen(c);
+        }
+        else if (c2 <= '9')
+        { // Daisy chaining, as with Ax.  The reply comes back upstream; see RelayUpstream().
+          OutputCache[0] = c;
+          OutputCache[1] = c2 - 1;
+          for( i=2; i < 12; i++){   
+            OutputCache[i] = Serial.read();  
+          }   
+          SerialSendDataDaisyChain (OutputCache);            
+        }
+      }
+
       else if( c == 'M' )  // Mode setting commands
       {// Eventually, it would be nice to have all settings and functions
         // accessible through the remote interface.
@@ -1371,11 +3752,16 @@ void processSerialMessage() {
           modeShowText = 0;
           modeLEDTest = 0;
 
+          if (modeShowVideo)
+            EndVideoMode();
+          if (modeShowWatch)
+            EndWatchMode();
           EndVCRmode();
         }
       }
 
-
+      if (modeShowWatch)
+        return;   // One message per pass through loop() while the watch is shown; see UpdateWatch().
     }
   }
 }
@@ -1436,6 +3822,16 @@ void UpdateDisplay (byte forceUpdate) {
 
   byte temp, remainder;
 
+  if (modeShowVideo)  // Segment video: a5_OSB belongs to the V<n> frames.
+    return;
+
+  if (modeShowWatch)  // Likewise, to UpdateWatch().
+  {
+    if (forceUpdate)
+      watchRedraw = 1;
+    return;
+  }
+
   if (modeShowText)  //Text Display
   { 
     if ((milliTemp >= DisplayWordEndTime) && (modeShowText == 1))
@@ -1486,7 +3882,7 @@ void UpdateDisplay (byte forceUpdate) {
       };  
 
       a5clearOSB();   
-      a5_OSB[18 * temp + map[remainder]] = a5_brightLevel; 
+      a5setOSB(18 * temp + map[remainder], a5_brightLevel); 
       a5BeginFadeToOSB();  
       RedrawNow = 1;
     }  
@@ -1495,230 +3891,7 @@ void UpdateDisplay (byte forceUpdate) {
 
   else if (modeShowMenu)
   {
-
-    DisplayWordDP("_____");
-    byte ExtendTextDisplay = 0; 
-
-    if (menuItem == AMPM24HRMenuItem)  // Hour mode: 12Hr / 24 Hr
-    {   
-      if (optionValue != 0)
-      {
-        if (HourMode24)
-          HourMode24 = 0;
-        else
-          HourMode24 = 1;
-        optionValue = 0;
-      }
-
-      if (HourMode24) 
-        DisplayWord ("24 HR", 500);
-      else
-        DisplayWord ("AM/PM", 500);  
-
-      ExtendTextDisplay = 1;
-    }
-    else if (menuItem == NightLightMenuItem)  // Night Light
-    {  
-      NightLightType += optionValue;
-
-      if (NightLightType < 0)
-        NightLightType = 4;
-      if (NightLightType > 4)
-        NightLightType = 0;
-
-      if (optionValue != 0){
-        if  (NightLightType == 4) 
-        {
-          NightLightStep = 0;
-          NightLightSign = 1;  
-        }
-        updateNightLight();
-      }
-      optionValue = 0;
-
-      if (NightLightType == 0) 
-        DisplayWord (" NONE", 500);
-      else if (NightLightType == 1) 
-        DisplayWord (" LOW ", 500);  
-      else if (NightLightType == 2) 
-        DisplayWord (" MED ", 500);  
-      else if (NightLightType == 3) 
-        DisplayWord (" HIGH", 500);  
-      else  // (NightLightType == 4) 
-      DisplayWord ("SLEEP", 500);  
-      ExtendTextDisplay = 1;
-    }    
-    else if (menuItem == AlarmToneMenuItem)  // Alarm Tone: 2
-    {  
-      AlarmTone += optionValue;
-      optionValue = 0;
-      if (AlarmTone < 0)
-        AlarmTone = 5;
-      if (AlarmTone > 5)
-        AlarmTone = 0;
-
-      if (AlarmTone == 0) 
-        DisplayWord ("X LOW", 500);
-      else if (AlarmTone == 1) 
-        DisplayWord (" LOW ", 500);  
-      else if (AlarmTone == 2) 
-        DisplayWord (" MED ", 500);  
-      else if (AlarmTone == 3) 
-        DisplayWord (" HIGH", 500);   
-      else if (AlarmTone == 4) 
-        DisplayWord ("SIREN", 500);   
-      else 
-        DisplayWord (" TINK", 500);   
-      ExtendTextDisplay = 1;
-    }   
-    else if (menuItem == SoundTestMenuItem)  // Alarm Test: 3
-    {   
-      DisplayWord (" +/- ", 500);   
-      if (optionValue != 0)
-      { 
-        if (alarmNow == 0)
-          alarmNow = 1;
-        else        
-          TurnOffAlarm();
-        optionValue = 0;
-      }
-      ExtendTextDisplay = 1;
-    }   
-
-    else if (menuItem == numberCharSetMenuItem)  
-    {
-      numberCharSet += optionValue;
-      if (optionValue != 0){
-        optionValue = 0;
-        if (numberCharSet < 0)
-          numberCharSet = 9;
-        if (numberCharSet > 9)
-          numberCharSet = 0;
-        a5loadAltNumbers(numberCharSet);
-      }
-
-      DisplayWord ("01237", 500); // Sample font display
-      ExtendTextDisplay = 1;
-    }   
-
-    else if (menuItem == DisplayStyleMenuItem) 
-    {  
-      temp = (DisplayMode & 3U);
-
-      if (optionValue != 0){ 
-        if (optionValue == 1) 
-          temp = (temp + 1) & 3U;  
-        else if (temp == 0) 
-          temp = 3; 
-        else
-          temp--;
-
-        DisplayMode = (DisplayMode & 12U) | (temp);
-        optionValue = 0;
-        forceUpdate = 1;
-      }   
-      TimeDisplay(DisplayMode & 3, forceUpdate); // Show clock time, in appropriate style
-    }
-    else if (menuItem == AltModeMenuItem)  // Alternate with seconds or date:
-    {  
-      // if (TimeDisplay & 4): Alternate date with time
-      // if (TimeDisplay & 8): Alternate date with seconds
-      // if (TimeDisplay & 16): Alternate date with words
-
-      if (optionValue != 0)
-      {
-        temp = 1;
-        if ( DisplayMode & 4)
-          temp = 2;
-        if ( DisplayMode & 8)
-          temp = 3;
-        if ( DisplayMode & 16)
-          temp = 4;    
-
-        temp += optionValue;
-
-        if (temp == 0) 
-          temp = 4; // Wrap around (low side)
-        else if (temp == 5)
-          temp = 0;  // wrap around (high side) 
-
-        DisplayMode &= 3U;
-
-        if (temp > 1)
-          DisplayMode |= (1 << temp);
-        // if temp is 0 or 1, display time only.
-
-        DisplayModePhaseCount = 0;  
-        optionValue = 0; 
-
-      }
-
-      if (DisplayMode & 4U)
-        DisplayWord ("DATE ", 500);
-      else if (DisplayMode & 8U){
-        DisplayWord ("SECS ", 500);
-        DisplayWordDP("___1_"); 
-      }
-      else if (DisplayMode & 16U){
-        DisplayWord ("WORDS", 500);
-      }     
-      else
-        DisplayWord (" NONE", 500);
-
-      ExtendTextDisplay = 1;
-
-    } 
-    else if (menuItem == SetYearMenuItem) 
-    {  
-      if (optionValue != 0){
-        AdjDayMonthYear(0,0,optionValue); // Day, Month, Year
-        optionValue = 0;
-        forceUpdate = 1; 
-      }    
-      TimeDisplay(35, forceUpdate); // Show clock time, in appropriate style
-    }
-
-    else if (menuItem == SetMonthMenuItem) 
-    {  
-      if (optionValue != 0){  
-        AdjDayMonthYear(0,optionValue,0); // Day, Month, Year
-        optionValue = 0;
-        forceUpdate = 1;
-      }   
-      TimeDisplay(33, forceUpdate); // Show clock time, in appropriate style
-    } 
-    else if (menuItem == SetDayMenuItem) 
-    {  
-      if (optionValue != 0){ 
-        AdjDayMonthYear(optionValue,0,0); // Day, Month, Year
-        optionValue = 0;
-        forceUpdate = 1;
-      }   
-      TimeDisplay(33, forceUpdate); // Show clock time, in appropriate style
-    }   
-
-    else if (menuItem == SetSecondsMenuItem) 
-    {  
-      if (optionValue != 0){ 
-        adjustTime(optionValue); // Adjust by +/- 1 second
-        if (UseRTC)  
-          RTC.set(now()); 
-        optionValue = 0;
-        forceUpdate = 1;
-      }   
-      TimeDisplay(32, forceUpdate); // Show clock time, seconds
-    }    
-
-    if(forceUpdate && ExtendTextDisplay)
-    {  
-      if (menuItem != DisplayStyleMenuItem) 
-      {   
-        a5clearOSB();    
-        a5loadOSB_Ascii(wordCache,a5_brightLevel);
-        a5loadOSB_DP(dpCache,a5_brightLevel);
-        a5BeginFadeToOSB();   
-      }
-    }
+    UpdateMenu(forceUpdate);
   }
   else if (modeShowDateViaButtons) 
   { 
@@ -1789,45 +3962,213 @@ void UpdateDisplay (byte forceUpdate) {
  
 
 
+// From Time library: API starts months from 1, this array starts from 0
+const uint8_t monthDays[]={31,28,31,30,31,30,31,31,30,31,30,31};
+
+
+byte ToBCD (byte value)
+{ // Convert 0-99 to packed BCD
+  byte tens = U8DIVBY10(value);     //i.e.,  tens = value / 10;
+  return (tens << 4) | (value - 10 * tens);
+}
+
+byte FromBCD (byte value)
+{
+  return (10 * (value >> 4)) + (value & 15);
+}
+
+byte IncrementBCD (byte value)
+{ // Add one to a packed BCD value.  (Caller handles rollover at the top of the range.)
+  value++;
+  if ((value & 15) > 9)
+    value += 6;   // Carry into the tens digit
+  return value;
+}
+
+byte DaysInMonth (byte monthIn, unsigned int yearIn)
+{ // Gregorian leap years, as in the Time library
+  if ((monthIn == 2) && ((yearIn & 3) == 0) && ((yearIn % 100) || ((yearIn % 400) == 0)))
+    return 29;
+  return monthDays[monthIn - 1];
+}
+
+
+void SetClockHourBCD (void)
+{ // Refresh the BCD hour fields, after a change to TimeNow.Hour.
+  byte temp = TimeNow.Hour;
+
+  TimeNow.HourBCD = ToBCD(temp);
+
+  if (temp > 12)
+    temp -= 12;
+  if (temp == 0)  // Represent 00:00 as 12:00
+    temp = 12;
+  TimeNow.Hour12BCD = ToBCD(temp);
+}
+
+
+void SetClockYearBCD (void)
+{ // Refresh the BCD year field, after a change to TimeNow.Year.
+  unsigned int yeartemp = TimeNow.Year;
+  unsigned int divtemp = U16DIVBY10(yeartemp);    //i.e.,  divtemp = yeartemp / 10;
+  unsigned int result = yeartemp - 10 * divtemp;
+
+  yeartemp = U16DIVBY10(divtemp);
+  result |= (divtemp - 10 * yeartemp) << 4;
+  divtemp = U16DIVBY10(yeartemp);
+  result |= (yeartemp - 10 * divtemp) << 8;
+  yeartemp = U16DIVBY10(divtemp);
+  result |= (divtemp - 10 * yeartemp) << 12;
+
+  TimeNow.YearBCD = result;
+}
+
+
+void SetClockTime (time_t timeIn)
+{ // Full (slow) conversion from time_t into TimeNow. Used at startup and whenever the time is changed.
+  tmElements_t tm;
+  breakTime(timeIn, tm);
+
+  TimeNowStamp = timeIn;
+  TimeNow.Second = tm.Second;
+  TimeNow.Minute = tm.Minute;
+  TimeNow.Hour = tm.Hour;
+  TimeNow.Day = tm.Day;
+  TimeNow.Month = tm.Month;
+  TimeNow.Wday = tm.Wday;
+  TimeNow.Year = tmYearToCalendar(tm.Year);
+
+  TimeNow.SecondBCD = ToBCD(tm.Second);
+  TimeNow.MinuteBCD = ToBCD(tm.Minute);
+  TimeNow.DayBCD = ToBCD(tm.Day);
+  SetClockHourBCD();
+  SetClockYearBCD();
+}
+
+
+void AdvanceClockTime (void)
+{ // Advance TimeNow by exactly one second, carrying into minutes, hours, days, months and years.
+
+  TimeNowStamp++;
+
+  if (TimeNow.Second < 59) {
+    TimeNow.Second++;
+    TimeNow.SecondBCD = IncrementBCD(TimeNow.SecondBCD);
+    return;
+  }
+  TimeNow.Second = 0;
+  TimeNow.SecondBCD = 0;
+
+  if (TimeNow.Minute < 59) {
+    TimeNow.Minute++;
+    TimeNow.MinuteBCD = IncrementBCD(TimeNow.MinuteBCD);
+    return;
+  }
+  TimeNow.Minute = 0;
+  TimeNow.MinuteBCD = 0;
+
+  if (TimeNow.Hour < 23) {
+    TimeNow.Hour++;
+    SetClockHourBCD();
+    return;
+  }
+  TimeNow.Hour = 0;
+  SetClockHourBCD();
+
+  TimeNow.Wday++;
+  if (TimeNow.Wday > 7)
+    TimeNow.Wday = 1;
+
+  if (TimeNow.Day < DaysInMonth(TimeNow.Month, TimeNow.Year)) {
+    TimeNow.Day++;
+    TimeNow.DayBCD = IncrementBCD(TimeNow.DayBCD);
+    return;
+  }
+  TimeNow.Day = 1;
+  TimeNow.DayBCD = 1;
+
+  if (TimeNow.Month < 12) {
+    TimeNow.Month++;
+    return;
+  }
+  TimeNow.Month = 1;
+  TimeNow.Year++;
+  SetClockYearBCD();
+}
+
+
+void UpdateClockTime (void)
+{ // Bring TimeNow up to date. Cheap unless the second has changed.
+  // A step of exactly one second is handled incrementally; any other change
+  // (time set over serial, buttons, RTC resync) is handled by a full conversion.
+
+  time_t timeTemp = now();
+
+  if (timeTemp == TimeNowStamp)
+    return;
+
+  if (timeTemp == (TimeNowStamp + 1))
+    AdvanceClockTime();
+  else if ((timeTemp > TimeNowStamp) && (timeTemp <= (TimeNowStamp + SECS_PER_MIN)))
+    SetClockTime(timeTemp);   // A small step forward (e.g., an RTC resync): an alarm due within it still sounds.
+  else
+  {
+    SetClockTime(timeTemp);
+    ScheduleAlarms();
+  }
+}
+
+
 void AdjDayMonthYear (int8_t AdjDay, int8_t AdjMonth, int8_t AdjYear)
 {
-  // From Time library: API starts months from 1, this array starts from 0
-  const uint8_t monthDays[]={31,28,31,30,31,30,31,31,30,31,30,31}; 
+  UpdateClockTime();
 
-   time_t timeTemp = now();
-      
-  int yrTemp = year(timeTemp) + (int) AdjYear;  
-  
-  int moTemp = month(timeTemp) + AdjMonth;  // Avoid changing year, unless requested
+  int yrTemp = TimeNow.Year + (int) AdjYear;
+
+  int moTemp = TimeNow.Month + AdjMonth;  // Avoid changing year, unless requested
   if (moTemp < 1)
       moTemp = 12;
    if (moTemp > 12)
       moTemp = 1;
       
-  int dayTemp = day(timeTemp) + AdjDay;  // avoid changing month, unless requested
+  byte monthLength = DaysInMonth(moTemp, yrTemp);
+  int dayTemp = TimeNow.Day + AdjDay;  // avoid changing month, unless requested
   
   if (dayTemp < 1)
-     dayTemp = monthDays[moTemp - 1]; 
+     dayTemp = monthLength;
      
-  if (dayTemp > monthDays[moTemp - 1])
+  if (dayTemp > monthLength)
     if (AdjDay > 0)
       {  // Roll over day-of-month to 1, if explicitly requesting increase in date.  
          dayTemp = 1;
       }
       else
       { // Otherwise, we should "truncate" the date to last day of month.
-       dayTemp = monthDays[moTemp - 1];
+       dayTemp = monthLength;
       }
      
-  setTime(hour(timeTemp),minute(timeTemp),second(timeTemp),
+  setTime(TimeNow.Hour, TimeNow.Minute, TimeNow.Second,
       dayTemp, moTemp, yrTemp);
+  UpdateClockTime();
   if (UseRTC)  
-    RTC.set(now()); 
+    RTCSet(now()); 
 }
 
 
 
 
+void ComposeTimeLayers (char WordIn[], char DPin[])
+{ // Compose the clock face into the OSB: time (or date) on one layer, alarm indicator on another.
+  a5setLayerText(TimeLayer, WordIn, a5_brightLevel);
+  a5setLayerDP(TimeLayer, DPin);
+
+  a5setLayerText(IndicatorLayer, "     ", AlarmEnabled ? a5_brightLevel : 0);
+  a5setLayerDP(IndicatorLayer, "2____");
+
+  a5composeOSB();
+}
+
+
 void TimeDisplay (byte DisplayModeLocal, byte forceUpdateCopy)  {
   byte temp;
   char units;
@@ -1836,7 +4177,7 @@ void TimeDisplay (byte DisplayModeLocal, byte forceUpdateCopy)  {
   byte SecNowTens,  SecNowOnes;
   byte SecNow;
 
-  SecNow = second();
+  SecNow = TimeNow.Second;
 
   if (SecLast != SecNow){
     forceUpdateCopy = 1;
@@ -1855,47 +4196,41 @@ void TimeDisplay (byte DisplayModeLocal, byte forceUpdateCopy)  {
     byte HrNowTens,  HrNowOnes, MinNowTens,  MinNowOnes;
 
     if (DisplayModeLocal == 20)
-      temp = AlarmTimeHr;  
+    {  // Alarm time is not cached; convert it here.
+      temp = AlarmTimeHr;
+      if ((HourMode24 == 0) && (temp > 12))
+        temp -= 12;
+      if ((HourMode24 == 0) && (temp == 0))  // Represent 00:00 as 12:00
+        temp = 12;
+      HrNowTens = ToBCD(temp);
+      MinNowTens = ToBCD(AlarmTimeMin);
+      temp = AlarmTimeHr;
+    }
     else
-      temp = hour(); 
+    {  // Time of day: digits are ready in the time cache.
+      if (HourMode24)
+        HrNowTens = TimeNow.HourBCD;
+      else
+        HrNowTens = TimeNow.Hour12BCD;
+      MinNowTens = TimeNow.MinuteBCD;
+      temp = TimeNow.Hour;
+    }
 
     if (HourMode24) 
       units = 'H';  
+    else if (temp >= 12)
+      units = 'P';
     else
-    {  
-        units = 'A'; 
-       
-      if (temp >= 12){
-        units = 'P';   
-      }       
-      
-      if (temp > 12){ 
-        temp -= 12;   //
-      }
-       
-      if (temp == 0)  // Represent 00:00 as 12:00
-          temp += 12;
-    }
-
-    HrNowTens = U8DIVBY10(temp);    //i.e.,  HrNowTens = temp / 10;
-    HrNowOnes = temp - 10 * HrNowTens;
-
-    if (DisplayModeLocal == 20)
-      temp = AlarmTimeMin;
-    else
-      temp = minute(); 
+      units = 'A';
 
-    MinNowTens = U8DIVBY10(temp);      //i.e.,  MinNowTens = temp / 10;
-    MinNowOnes = temp - 10 * MinNowTens;
+    HrNowOnes = HrNowTens & 15;
+    HrNowTens >>= 4;
+    MinNowOnes = MinNowTens & 15;
+    MinNowTens >>= 4;
 
     if (MinNowOnesLast != MinNowOnes)
       forceUpdateCopy = 1;
 
-    SecNow = second();    
-
-    if (SecLast != SecNow)
-      forceUpdateCopy = 1;
-
     if (DisplayModeLocal & 1) // Seconds Spinner Mode
     {
 
@@ -1969,24 +4304,24 @@ void TimeDisplay (byte DisplayModeLocal, byte forceUpdateCopy)  {
 
     if(forceUpdateCopy)
     { 
-      a5clearOSB();  
-      a5loadOSB_Ascii(WordIn,a5_brightLevel);    
-
-      if (DisplayModeLocal & 1)
-      {
-        a5loadOSB_Segment (temp, a5_brightLevel);
-        if (units == 'P')
-          a5loadOSB_DP("___1_",a5_brightLevel);   // DP dot in DisplayMode 1.        
-      }
-
-      if (AlarmEnabled)
-        a5loadOSB_DP("2____",a5_brightLevel);     
+      char DPin[] = "_____";
 
       if ((DisplayModeLocal < 20) && (DisplayModeLocal & 2) && (SecNow & 1)){ 
         // no HOUR:MINUTE separators
       }
       else
-        a5loadOSB_DP("01200",a5_brightLevel);    
+      {
+        DPin[1] = '1';
+        DPin[2] = '2';
+      }
+
+      if ((DisplayModeLocal & 1) && (units == 'P'))
+        DPin[3] = '1';   // DP dot in DisplayMode 1.        
+
+      ComposeTimeLayers(WordIn, DPin);
+
+      if (DisplayModeLocal & 1)
+        a5loadOSB_Segment (temp, a5_brightLevel);   // Seconds spinner
 
       a5BeginFadeToOSB();  
     }  
@@ -1998,22 +4333,14 @@ void TimeDisplay (byte DisplayModeLocal, byte forceUpdateCopy)  {
   else if (DisplayModeLocal == 32)  //Seconds only
   { 
 
-    temp = SecNow;
-
-    SecNowTens = U8DIVBY10(temp);      //i.e.,  SecNowTens = temp / 10;
-    SecNowOnes = temp - 10 * SecNowTens;
+    SecNowTens = TimeNow.SecondBCD >> 4;
+    SecNowOnes = TimeNow.SecondBCD & 15;
 
     WordIn[2] =  SecNowTens + a5_integerOffset;
     WordIn[3] =  SecNowOnes + a5_integerOffset; 
     if(forceUpdateCopy)
     { 
-      a5clearOSB();  
-      a5loadOSB_Ascii(WordIn,a5_brightLevel);    
-
-      if (AlarmEnabled)
-        a5loadOSB_DP("21200",a5_brightLevel);     
-      else
-        a5loadOSB_DP("01200",a5_brightLevel);     
+      ComposeTimeLayers(WordIn, "01200");
 
       a5BeginFadeToOSB(); 
     } 
@@ -2025,27 +4352,17 @@ void TimeDisplay (byte DisplayModeLocal, byte forceUpdateCopy)  {
 
     if(forceUpdateCopy)
     {  
-      temp = day();  
-
-      byte monthTemp = 3 * ( month() - 1);  
+      byte monthTemp = 3 * ( TimeNow.Month - 1);  
       //Month name (short):
       //      char a5monthShortNames_P[] PROGMEM = "JANFEBMARAPRMAYJUNJULAUGSEPOCTNOVDEC";
       WordIn[0] = pgm_read_byte(&(a5_monthShortNames_P[monthTemp++]));  
       WordIn[1] = pgm_read_byte(&(a5_monthShortNames_P[monthTemp++]));
       WordIn[2] = pgm_read_byte(&(a5_monthShortNames_P[monthTemp]));
 
-      byte divtemp =  U8DIVBY10(temp);  //i.e.,  divtemp = day / 10;
-
-      WordIn[3] =   divtemp + a5_integerOffset;  
-      WordIn[4] =  ( temp - 10 * divtemp) + a5_integerOffset;   
-
-      a5clearOSB();  
-      a5loadOSB_Ascii(WordIn,a5_brightLevel);    
+      WordIn[3] =  (TimeNow.DayBCD >> 4) + a5_integerOffset;
+      WordIn[4] =  (TimeNow.DayBCD & 15) + a5_integerOffset;
 
-      if (AlarmEnabled)
-        a5loadOSB_DP("20100",a5_brightLevel);     
-      else
-        a5loadOSB_DP("00100",a5_brightLevel);     
+      ComposeTimeLayers(WordIn, "00100");
 
       a5BeginFadeToOSB(); 
     }  
@@ -2054,26 +4371,16 @@ void TimeDisplay (byte DisplayModeLocal, byte forceUpdateCopy)  {
   else if (DisplayModeLocal == 35)  //Year
   { 
 
-    unsigned int yeartemp = year();  
-    unsigned int divtemp =  U16DIVBY10(yeartemp);  //i.e.,  divtemp = yeartemp / 10;
+    unsigned int yeartemp = TimeNow.YearBCD;
 
-    WordIn[4] =   yeartemp - 10 * divtemp + a5_integerOffset;  
-    yeartemp = U16DIVBY10(divtemp); 
-    WordIn[3] =   divtemp - 10 * yeartemp + a5_integerOffset;  
-    divtemp =  U16DIVBY10(yeartemp); 
-    WordIn[2] =   yeartemp - 10 * divtemp + a5_integerOffset;  
-    yeartemp = U16DIVBY10(divtemp); 
-    WordIn[1] =   divtemp - 10 * yeartemp + a5_integerOffset;  
+    WordIn[4] =  (yeartemp & 15) + a5_integerOffset;
+    WordIn[3] =  ((yeartemp >> 4) & 15) + a5_integerOffset;
+    WordIn[2] =  ((yeartemp >> 8) & 15) + a5_integerOffset;
+    WordIn[1] =  (yeartemp >> 12) + a5_integerOffset;
 
     if(forceUpdateCopy)
     { 
-      a5clearOSB();  
-      a5loadOSB_Ascii(WordIn,a5_brightLevel);    
-
-      if (AlarmEnabled)
-        a5loadOSB_DP("20000",a5_brightLevel);     
-      else
-        a5loadOSB_DP("00000",a5_brightLevel);     
+      ComposeTimeLayers(WordIn, "00000");
 
       a5BeginFadeToOSB(); 
     }   
@@ -2120,13 +4427,7 @@ void TimeDisplay (byte DisplayModeLocal, byte forceUpdateCopy)  {
 
 
 
-      a5clearOSB(); 
-      a5loadOSB_Ascii(WordIn,a5_brightLevel);    
-
-      if (AlarmEnabled)
-        a5loadOSB_DP("20000",a5_brightLevel);     
-      else
-        a5loadOSB_DP("00000",a5_brightLevel);     
+      ComposeTimeLayers(WordIn, "00000");
 
       a5BeginFadeToOSB(); 
     }   
@@ -2138,36 +4439,6 @@ void TimeDisplay (byte DisplayModeLocal, byte forceUpdateCopy)  {
 }
 
 
-void SerialPrintTime(){
-  //   Print time over serial interface.   Adapted from Time library.
-
- time_t timeTmp = now();  
-
-  Serial.print(hour(timeTmp));
-  printDigits(minute(timeTmp));
-  printDigits(second(timeTmp));
-  Serial.print(" ");
-  Serial.print(dayStr(weekday(timeTmp)));
-  Serial.print(" ");
-  Serial.print(day(timeTmp));
-  Serial.print(" ");
-  Serial.print(monthShortStr(month(timeTmp)));
-  Serial.print(" ");
-  Serial.print(year(timeTmp)); 
-  Serial.println(); 
-
-}
-
-void printDigits(int digits){
-  // utility function for digital clock serial output: prints preceding colon and leading 0
-  // borrowed from Time library.
-  Serial.print(":");
-  if(digits < 10)
-    Serial.print('0');
-  Serial.print(digits);
-}
-
-
 void ApplyDefaults (void) {
   // VARIABLES THAT HAVE EEPROM STORAGE AND DEFAULTS...
 
@@ -2193,12 +4464,6 @@ void EEReadSettings (void) {
   else  
     Brightness = value - 100;   
 
-  value = EEPROM.read(1);
-  if (value > 1)
-    HourMode24 = a5HourMode24Default;
-  else  
-    HourMode24 = value;
-
   value = EEPROM.read(2);
   if (value > 1)
     AlarmEnabled = a5AlarmEnabledDefault;
@@ -2218,26 +4483,7 @@ void EEReadSettings (void) {
   else  
     AlarmTimeMin = value - 100;   
 
-  value = EEPROM.read(5);
-  if (value > 5)
-    AlarmTone = a5AlarmToneDefault;
-  else  
-    AlarmTone = value;   
-
-  value = EEPROM.read(6);
-  if (value > 4)
-    NightLightType = a5NightLightTypeDefault;  
-  else  
-    NightLightType = value;    
-
-
-  value = EEPROM.read(7);  
-  if (value > 9)   
-  {
-    numberCharSet = a5NumberCharSetDefault;
-  }
-  else
-    numberCharSet = value;       
+  MenuReadEEPROM();   // HourMode24, AlarmTone, NightLightType, numberCharSet: addresses 1, 5, 6, 7
 
   value = EEPROM.read(8);   
   if (value > 31) 
@@ -2247,79 +4493,108 @@ void EEReadSettings (void) {
   else  
     DisplayMode = value;       
 
+  value = EEPROM.read(9);
+  if (value > 127)
+    AlarmDays[0] = a5AlarmDaysDefault;
+  else
+    AlarmDays[0] = value;
 
+  for (byte n = 1; n < a5_ALARMS; n++)
+  { // Alarms 1 and up: three bytes each, [days] [hour + 100] [minute + 100]
+    byte address = a5_EE_MORE_ALARMS + 3 * (n - 1);
+    byte hourTemp = EEPROM.read(address + 1);
+    byte minTemp = EEPROM.read(address + 2);
 
+    value = EEPROM.read(address);
+    if ((value > 127) || (hourTemp > 123) || (hourTemp < 100) || (minTemp > 159) || (minTemp < 100))
+    {
+      AlarmDays[n] = 0;
+      AlarmMoreHr[n - 1] = a5AlarmHrDefault;
+      AlarmMoreMin[n - 1] = a5AlarmMinDefault;
+    }
+    else
+    {
+      AlarmDays[n] = value;
+      AlarmMoreHr[n - 1] = hourTemp - 100;
+      AlarmMoreMin[n - 1] = minTemp - 100;
+    }
+  }
 }
 
 
-void EESaveSettings (void){ 
+byte EEWriteSettings (void){ 
+  // Write any settings that differ from those in EEPROM.
+  // Returns 1 if a setting that should be indicated (by blinking the display) was written.
 
-  // If > 4 seconds since last button press, and
-  // we suspect that we need to change the stored settings:
+  // Careful if you use this function: EEPROM has a limited number of write
+  // cycles in its life.  Good for human-operated buttons, bad for automation.
+  // Also, no error checking is provided at this, the write EEPROM stage.
 
   byte value; 
   byte indicateEEPROMwritten = 0;
 
-  if (milliTemp >= (LastButtonPress + 4000))
+  value = EEPROM.read(0);  
+  if (Brightness != (value - 100))  {
+    a5writeEEPROM(0, Brightness + 100);  
+
+    //NOTE:  Do not blink LEDs off to indicate saving of this value
+  }
+  value = EEPROM.read(2);  
+  if (AlarmEnabled != value)  {
+    a5writeEEPROM(2, AlarmEnabled);  
+    //NOTE:  Do not blink LEDs off to indicate saving of this value
+  } 
+  value = EEPROM.read(3);  
+  if (AlarmTimeHr != (value - 100))  { 
+    a5writeEEPROM(3, AlarmTimeHr + 100); 
+    //NOTE:  Do not blink LEDs off to indicate saving of this value
+  }
+  value = EEPROM.read(4);  
+  if (AlarmTimeMin != (value - 100)){
+    a5writeEEPROM(4, AlarmTimeMin + 100); 
+    //NOTE:  Do not blink LEDs off to indicate saving of this value
+  }
+  if (MenuWriteEEPROM())   // Addresses 1, 5, 6, 7
+    indicateEEPROMwritten = 1;
+  value = EEPROM.read(8);  
+  if (DisplayMode != value){
+    a5writeEEPROM(8, DisplayMode);  
+    indicateEEPROMwritten = 1;
+  }      
+  value = EEPROM.read(9);  
+  if (AlarmDays[0] != value){
+    a5writeEEPROM(9, AlarmDays[0]);  
+    //NOTE:  Do not blink LEDs off to indicate saving of this value
+  }      
+
+  for (byte n = 1; n < a5_ALARMS; n++)
   {
+    byte address = a5_EE_MORE_ALARMS + 3 * (n - 1);
+    if (AlarmDays[n] != EEPROM.read(address))
+      a5writeEEPROM(address, AlarmDays[n]);
+    if (AlarmMoreHr[n - 1] != (EEPROM.read(address + 1) - 100))
+      a5writeEEPROM(address + 1, AlarmMoreHr[n - 1] + 100);
+    if (AlarmMoreMin[n - 1] != (EEPROM.read(address + 2) - 100))
+      a5writeEEPROM(address + 2, AlarmMoreMin[n - 1] + 100);
+  }
 
-    // Careful if you use this function: EEPROM has a limited number of write
-    // cycles in its life.  Good for human-operated buttons, bad for automation.
-    // Also, no error checking is provided at this, the write EEPROM stage.
+  return indicateEEPROMwritten;
+}
 
-    value = EEPROM.read(0);  
-    if (Brightness != (value - 100))  {
-      a5writeEEPROM(0, Brightness + 100);  
 
-      //NOTE:  Do not blink LEDs off to indicate saving of this value
-    }
-    value = EEPROM.read(1);  
-    if (HourMode24 != value)  { 
-      a5writeEEPROM(1, HourMode24); 
-      indicateEEPROMwritten = 1;
-    } 
-    value = EEPROM.read(2);  
-    if (AlarmEnabled != value)  {
-      a5writeEEPROM(2, AlarmEnabled);  
-      //NOTE:  Do not blink LEDs off to indicate saving of this value
-    } 
-    value = EEPROM.read(3);  
-    if (AlarmTimeHr != (value - 100))  { 
-      a5writeEEPROM(3, AlarmTimeHr + 100); 
-      //NOTE:  Do not blink LEDs off to indicate saving of this value
-    }
-    value = EEPROM.read(4);  
-    if (AlarmTimeMin != (value - 100)){
-      a5writeEEPROM(4, AlarmTimeMin + 100); 
-      //NOTE:  Do not blink LEDs off to indicate saving of this value
-    }
-    value = EEPROM.read(5);  
-    if (AlarmTone != value){ 
-      a5writeEEPROM(5, AlarmTone);
-      indicateEEPROMwritten = 1;
-    }
-    value = EEPROM.read(6);  
-    if (NightLightType != value){
-      a5writeEEPROM(6, NightLightType);  
-      indicateEEPROMwritten = 1;
-    }
-    value = EEPROM.read(7);  
-    if (numberCharSet != value){
-      a5writeEEPROM(7, numberCharSet);  
-      indicateEEPROMwritten = 1;
-    }
-    value = EEPROM.read(8);  
-    if (DisplayMode != value){
-      a5writeEEPROM(8, DisplayMode);  
-      indicateEEPROMwritten = 1;
-    }      
+void EESaveSettings (void){ 
+
+  // If > 4 seconds since last button press, and
+  // we suspect that we need to change the stored settings:
 
-    if (indicateEEPROMwritten) { // Blink LEDs off to indicate when we're writing to the EEPROM 
+  if (milliTemp >= (LastButtonPress + 4000))
+  {
+    if (EEWriteSettings()) { // Blink LEDs off to indicate when we're writing to the EEPROM 
       DisplayWord ("     ", 100);  
     }
 
     UpdateEE = 0;
     if (UseRTC)  
-      RTC.set(now());  // Update time at RTC, in case time was changed in settings menu
+      RTCSet(now());  // Update time at RTC, in case time was changed in settings menu
   }
 } 
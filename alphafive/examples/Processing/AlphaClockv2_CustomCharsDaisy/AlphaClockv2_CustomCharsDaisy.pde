@@ -10,6 +10,7 @@
  *
  *
  * Requires Alpha Clock Five firmware version 2.0 or newer
+ * (Alpha5UploadGlyphBank() needs firmware with glyph banks, the C<n> serial command.)
  * 
  *
  * Partly Based upon SetArduinoClock.pde, from the Arduino DateTime library
@@ -68,6 +69,26 @@ void Alpha5ReplaceFontChar(int relayCount, char theChar, int Aval, int Bval, int
 
 
 
+void Alpha5UploadGlyphBank(int relayCount, char firstChar, int[] glyphs)
+{
+  // Replace the glyphs of firstChar and the characters after it, up to 18, in one message.
+  // glyphs[] holds the segment data A, B, C (as in Alpha5ReplaceFontChar) of each, in turn.
+  int count = glyphs.length / 3;
+
+  myPort.write(0xff); // Send header byte
+  myPort.write('C');  // Glyph bank
+  myPort.write(nf(relayCount, 1)); // Upload to nth Alpha Clock in daisy chain
+  myPort.write('U');  // Upload, and use it
+  myPort.write(firstChar); // The first ASCII char that we are replacing
+  myPort.write(count); // How many, as a binary byte
+
+  for (int i = 0; i < 3 * count; i++)
+    myPort.write(glyphs[i]);  // Segment data, as binary bytes
+  for (int i = 3 * count; i < 7; i++)
+    myPort.write("_");  // Padding, so that the message is at least 13 bytes
+}
+
+
 
 void Alpha5AdjustBrightness(int relayCount, int bright)
 {
@@ -97,13 +118,16 @@ void mousePressed() {
   if (clockmode) {  
     clockmode =  false;
 
-    // Replace ASCII locations a, b, c, d, and e with custom characters:        
+    // Replace ASCII locations a, b, c, d, and e with custom characters, in one message:        
 
-    Alpha5ReplaceFontChar(distance, 'a', 16, 0, 156);
-    Alpha5ReplaceFontChar(distance, 'b', 0, 0, 64);
-    Alpha5ReplaceFontChar(distance, 'c', 32, 0, 0);
-    Alpha5ReplaceFontChar(distance, 'd', 0, 1, 0);
-    Alpha5ReplaceFontChar(distance, 'e', 16, 0, 0);
+    int[] customChars = {
+      16, 0, 156,   // a
+      0, 0, 64,     // b
+      32, 0, 0,     // c
+      0, 1, 0,      // d
+      16, 0, 0      // e
+    };
+    Alpha5UploadGlyphBank(distance, 'a', customChars);
 
 
     delay(100);  // Delay for input buffer to clear up.
@@ -48,11 +48,10 @@ alphademo2.ino
 
 
 
-// Required includes:  3 lines of code:
+// Required includes:  2 lines of code:
 
-#include "alphafive.h"      // Alpha Clock Five library   -- Line 1 of 3.
-#include <Wire.h>       // For optional RTC module    -- Line 2 of 3.
-#include <EEPROM.h>     // For saving settings  -- Line 3 of 3.
+#include "alphafive.h"      // Alpha Clock Five library   -- Line 1 of 2.
+#include <EEPROM.h>     // For saving settings  -- Line 2 of 2.
 
 
 unsigned long nextTime;
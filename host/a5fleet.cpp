@@ -0,0 +1,328 @@
+/*
+ a5fleet.cpp
+
+ Part of the Alpha Five host tools
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "a5fleet.h"
+#include "a5port.h"
+
+namespace a5 {
+
+// Printed by the clock once it has handled ST.
+static const char kTimeConfirmation[] = "Sync Signal Received";
+
+// Echo round trips per port; the shortest is the one least delayed by anything else.
+static const int kEchoSamples = 4;
+
+FleetJob::FleetJob()
+    : setTime(false), syncTime(false), chainUnits(1), putSettings(false), getSettings(false)
+{
+    memset(settings, 0, sizeof(settings));
+}
+
+
+Fleet::Fleet()
+    : epoll_(epoll_create1(EPOLL_CLOEXEC)), active_(0)
+{
+}
+
+Fleet::~Fleet()
+{
+    close();
+    if (epoll_ >= 0)
+        ::close(epoll_);
+}
+
+bool Fleet::add(const std::string &path, int baud)
+{
+    Link link;
+    link.path = path;
+    link.fd = openSerial(path, baud, link.openError);
+    link.step = kStepDone;
+    link.active = false;
+    link.written = 0;
+    link.sequence = 0;
+    links_.push_back(link);
+
+    if (link.fd < 0)
+        return false;
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u32 = links_.size() - 1;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, link.fd, &event) != 0) {
+        links_.back().openError = std::string("epoll: ") + strerror(errno);
+        ::close(link.fd);
+        links_.back().fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void Fleet::close()
+{
+    for (size_t i = 0; i < links_.size(); i++)
+        if (links_[i].fd >= 0)
+            ::close(links_[i].fd);     // Also removes it from the epoll set
+    links_.clear();
+}
+
+void Fleet::watch(Link &link, bool output)
+{
+    struct epoll_event event;
+    event.events = EPOLLIN | (output ? (uint32_t) EPOLLOUT : 0);
+    event.data.u32 = &link - &links_[0];
+    epoll_ctl(epoll_, EPOLL_CTL_MOD, link.fd, &event);
+}
+
+void Fleet::finish(Link &link, const std::string &error)
+{
+    if (!link.active)
+        return;
+    link.active = false;
+    link.step = kStepDone;
+    link.result.ok = error.empty();
+    link.result.error = error;
+    active_--;
+}
+
+void Fleet::drop(Link &link, const std::string &error)
+{   // The port is gone (e.g., unplugged): close it, so that it doesn't keep waking epoll.
+    link.openError = error;
+    ::close(link.fd);
+    link.fd = -1;
+    finish(link, error);
+}
+
+void Fleet::startStep(Link &link, const FleetJob &job)
+{   // Begin the first step, at or after link.step, that the job asks for.
+    while (link.step != kStepDone) {
+        if ((link.step == kStepTime) && job.setTime)
+            break;
+        if (((link.step == kStepEcho) || (link.step == kStepSync)) && job.syncTime)
+            break;
+        if ((link.step == kStepPut) && job.putSettings)
+            break;
+        if ((link.step == kStepGet) && job.getSettings)
+            break;
+        link.step = (Step) (link.step + 1);
+    }
+    if (link.step == kStepDone) {
+        finish(link, "");
+        return;
+    }
+
+    link.out.clear();
+    link.written = 0;
+    link.in.clear();
+    link.sequence++;
+    if (link.step == kStepTime)
+        appendSetTime(link.out, localTimeNow());
+    else if (link.step == kStepEcho)
+        appendEcho(link.out, 0, link.sequence);
+    else if (link.step == kStepSync)    // Stamped with the time at which it should arrive
+        appendTimeSync(link.out, localTimeNowUs() + (uint64_t) (500 * link.result.rttMs), link.sequence);
+    else if (link.step == kStepPut)
+        appendPutSettings(link.out, 0, job.settings);
+    else
+        appendGetSettings(link.out, 0);
+
+    link.stepStart = Clock::now();
+    writeSome(link);
+}
+
+void Fleet::writeSome(Link &link)
+{
+    while (link.written < link.out.size()) {
+        ssize_t count = ::write(link.fd, &link.out[link.written], link.out.size() - link.written);
+        if (count > 0) {
+            link.written += count;
+            continue;
+        }
+        if ((count < 0) && (errno == EINTR))
+            continue;
+        if ((count < 0) && (errno == EAGAIN)) {
+            watch(link, true);      // Finish when the port has room
+            return;
+        }
+        finish(link, std::string("write: ") + strerror(errno));
+        return;
+    }
+    watch(link, false);
+}
+
+void Fleet::readSome(Link &link, const FleetJob &job)
+{
+    uint8_t buffer[512];
+
+    for (;;) {
+        ssize_t count = ::read(link.fd, buffer, sizeof(buffer));
+        if (count > 0) {
+            if (link.active)
+                link.in.insert(link.in.end(), buffer, buffer + count);
+            continue;
+        }
+        if ((count < 0) && (errno == EINTR))
+            continue;
+        if ((count == 0) || (errno == EAGAIN))
+            break;      // (A raw tty with VMIN = 0 returns 0, not EAGAIN, when there is nothing to read.)
+        drop(link, std::string("read: ") + strerror(errno));
+        return;
+    }
+
+    if (!link.active || (link.written < link.out.size()))
+        return;
+
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - link.stepStart).count();
+
+    if ((link.step == kStepEcho) || (link.step == kStepSync)) {
+        if (!readTimeReplies(link, job, ms))
+            return;
+    }
+    else if (link.step == kStepTime) {
+        const char *end = kTimeConfirmation + strlen(kTimeConfirmation);
+        if (std::search(link.in.begin(), link.in.end(), kTimeConfirmation, end) == link.in.end())
+            return;
+        link.result.timeMs = ms;
+    }
+    else {
+        char type = (link.step == kStepPut) ? 'p' : 'g';
+        if (!link.in.size() || !parseSettingsReply(&link.in[0], link.in.size(), type, link.result.settings))
+            return;
+        link.result.settingsMs = ms;
+        if ((link.step == kStepPut) && memcmp(link.result.settings, job.settings, kSettingsLength)) {
+            finish(link, "settings not accepted");
+            return;
+        }
+    }
+
+    link.step = (Step) (link.step + 1);
+    startStep(link, job);
+}
+
+bool Fleet::readTimeReplies(Link &link, const FleetJob &job, double ms)
+{   // Returns true once the step is complete.
+    TimeReply reply;
+    size_t used;
+
+    while (link.in.size() && ((used = parseTimeReply(&link.in[0], link.in.size(), reply)) > 0)) {
+        link.in.erase(link.in.begin(), link.in.begin() + used);
+        if (reply.sequence != link.sequence)
+            continue;       // A late reply to an earlier message
+
+        if ((link.step == kStepEcho) && (reply.type == 'E')) {
+            if ((link.result.rttMs < 0) || (ms < link.result.rttMs))
+                link.result.rttMs = ms;
+            if (++link.echoes < kEchoSamples) {
+                startStep(link, job);   // Again
+                return false;
+            }
+            return true;
+        }
+        if ((link.step == kStepSync) && (reply.type == 'S') && (reply.hops < job.chainUnits)) {
+            link.acked |= (uint64_t) 1 << reply.hops;
+            if (link.acked == (((uint64_t) 1 << job.chainUnits) - 1)) {
+                link.result.syncMs = ms;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<FleetResult> Fleet::run(const FleetJob &job, int timeoutMs)
+{
+    static const char *const stepNames[] = { "time sync", "echo", "sub-second sync", "put settings", "get settings" };
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    active_ = 0;
+    for (size_t i = 0; i < links_.size(); i++) {
+        Link &link = links_[i];
+        link.result.path = link.path;
+        link.result.ok = false;
+        link.result.error = link.openError;
+        link.result.timeMs = -1;
+        link.result.rttMs = -1;
+        link.result.syncMs = -1;
+        link.result.settingsMs = -1;
+        memset(link.result.settings, 0, sizeof(link.result.settings));
+        link.step = kStepDone;
+        if (link.fd < 0)
+            continue;
+
+        tcflush(link.fd, TCIFLUSH);    // Anything the clock said before now isn't a reply
+        link.step = kStepTime;
+        link.echoes = 0;
+        link.acked = 0;
+        link.active = true;
+        active_++;
+    }
+
+    // Start every port before waiting on any of them.
+    for (size_t i = 0; i < links_.size(); i++)
+        if (links_[i].active)
+            startStep(links_[i], job);
+
+    std::vector<struct epoll_event> events(std::max<size_t>(links_.size(), 1));
+
+    while (active_ > 0) {
+        int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (remaining <= 0)
+            break;
+
+        int ready = epoll_wait(epoll_, &events[0], events.size(), remaining);
+        if ((ready < 0) && (errno == EINTR))
+            continue;
+        if (ready < 0)
+            break;
+
+        for (int i = 0; i < ready; i++) {
+            Link &link = links_[events[i].data.u32];
+            if (link.fd < 0)
+                continue;
+            if ((events[i].events & EPOLLOUT) && link.active)
+                writeSome(link);
+            if ((link.fd >= 0) && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                readSome(link, job);
+            if ((link.fd >= 0) && (events[i].events & (EPOLLHUP | EPOLLERR)))
+                drop(link, "port closed");
+        }
+    }
+
+    std::vector<FleetResult> results;
+    for (size_t i = 0; i < links_.size(); i++) {
+        Link &link = links_[i];
+        if (link.active)
+            finish(link, std::string("timed out: ") + stepNames[link.step]);
+        results.push_back(link.result);
+    }
+    return results;
+}
+
+}  // namespace a5
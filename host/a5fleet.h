@@ -0,0 +1,116 @@
+/*
+ a5fleet.h
+
+ Part of the Alpha Five host tools
+
+ Many clocks, each on its own serial port (e.g., a room of clocks on a USB hub),
+ handled concurrently: one thread, one epoll set, every port at once.  Each port
+ runs the same job -- set the time, write or read the settings -- one step at a
+ time, waiting for the clock's confirmation of each step before the next.  The
+ time taken by each step is reported for each port.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef a5fleet_h
+#define a5fleet_h
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "a5proto.h"
+
+namespace a5 {
+
+// What to do on every port, in this order.  All commands go to unit 0 of each port.
+struct FleetJob {
+    bool setTime;                       // ST, with this computer's local time as each message is sent;
+                                        //   confirmed by the clock's "Sync Signal Received" message.
+    bool syncTime;                      // T0: measure the round trip with echoes, then a sub-second
+                                        //   sync, confirmed by an ack from each of chainUnits units.
+    int chainUnits;                     // Units daisy-chained on each port, for syncTime (default 1)
+    bool putSettings;                   // P0 "settings", confirmed by a matching reply
+    bool getSettings;                   // G0
+    uint8_t settings[kSettingsLength];
+
+    FleetJob();
+};
+
+struct FleetResult {
+    std::string path;
+    bool ok;
+    std::string error;                  // Why not, if not ok
+    double timeMs;                      // ST sent until confirmed, or -1 if not done
+    double rttMs;                       // Shortest echo round trip, or -1 if not done
+    double syncMs;                      // Sync sent until the last unit's ack, or -1 if not done
+    double settingsMs;                  // P0 or G0 sent until the reply, or -1 if not done
+    uint8_t settings[kSettingsLength];  // As reported by the clock
+};
+
+class Fleet {
+public:
+    Fleet();
+    ~Fleet();
+
+    // Open a port.  A port that can't be opened is kept, and reported as failed by run().
+    bool add(const std::string &path, int baud = kDefaultBaud);
+    void close();
+    size_t size() const { return links_.size(); }
+
+    // Run the job on every port at once, until all are done or timeoutMs has passed.
+    // Returns one result per port, in the order the ports were added.
+    std::vector<FleetResult> run(const FleetJob &job, int timeoutMs = 3000);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    enum Step { kStepTime, kStepEcho, kStepSync, kStepPut, kStepGet, kStepDone };
+
+    struct Link {
+        std::string path;
+        int fd;
+        std::string openError;
+        bool active;                    // Still working on the job
+        Step step;
+        Bytes out;                      // Message for the present step
+        size_t written;
+        Bytes in;                       // Received since the present step began
+        Clock::time_point stepStart;
+        uint8_t sequence;               // Of the present T0 message
+        int echoes;                     // Echo round trips measured so far
+        uint64_t acked;                 // Sync: bit per unit (hops) that has acked
+        FleetResult result;
+    };
+
+    void startStep(Link &link, const FleetJob &job);
+    void writeSome(Link &link);
+    void readSome(Link &link, const FleetJob &job);
+    bool readTimeReplies(Link &link, const FleetJob &job, double ms);
+    void watch(Link &link, bool output);
+    void finish(Link &link, const std::string &error);
+    void drop(Link &link, const std::string &error);
+
+    int epoll_;
+    std::vector<Link> links_;
+    size_t active_;                     // Ports still working on the job
+};
+
+}  // namespace a5
+
+#endif
@@ -0,0 +1,300 @@
+/*
+ a5port.cpp
+
+ Part of the Alpha Five host tools
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+
+#include "a5port.h"
+
+namespace a5 {
+
+static speed_t baudConstant(int baud)
+{
+    switch (baud) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 115200: return B115200;
+    default:     return 0;
+    }
+}
+
+
+int openSerial(const std::string &path, int baud, std::string &error)
+{
+    speed_t speed = baudConstant(baud);
+    if (speed == 0) {
+        error = "unsupported baud rate";
+        return -1;
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        error = path + ": " + strerror(errno);
+        return -1;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+#ifdef __linux__
+    // USB serial adapters otherwise hold back short replies for up to 16 ms (the FTDI
+    // latency timer), which would skew round-trip measurements.  Not every port has this.
+    struct serial_struct serial;
+    if (ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &serial);
+    }
+#endif
+    return fd;
+}
+
+
+Port::Port()
+    : fd_(-1), baud_(kDefaultBaud), pacing_(true), queueLimit_(4 * kMessageLength),
+      queuedBytes_(0), writing_(false), closing_(false),
+      bytesWritten_(0), messagesWritten_(0)
+{
+}
+
+Port::~Port()
+{
+    close();
+}
+
+bool Port::open(const std::string &path, int baud)
+{
+    close();
+
+    int fd = openSerial(path, baud, error_);
+    if (fd < 0)
+        return false;
+
+    fd_ = fd;
+    baud_ = baud;
+    closing_ = false;
+    queue_.clear();
+    queuedBytes_ = 0;
+    writer_ = std::thread(&Port::writerLoop, this);
+    return true;
+}
+
+void Port::close()
+{
+    if (fd_ < 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    wake_.notify_all();
+    space_.notify_all();
+    if (writer_.joinable())
+        writer_.join();
+
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void Port::setPacing(bool pacing)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    pacing_ = pacing;
+}
+
+void Port::setQueueLimit(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    queueLimit_ = bytes;
+    space_.notify_all();
+}
+
+bool Port::send(const Bytes &data, int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // A chunk larger than the limit is still accepted, once the queue is empty.
+    auto hasRoom = [this, &data] {
+        return closing_ || (queuedBytes_ == 0) || (queuedBytes_ + data.size() <= queueLimit_);
+    };
+
+    if (timeoutMs < 0)
+        space_.wait(lock, hasRoom);
+    else if (!space_.wait_for(lock, std::chrono::milliseconds(timeoutMs), hasRoom))
+        return false;
+
+    if (closing_ || (fd_ < 0))
+        return false;
+
+    queue_.push_back(data);
+    queuedBytes_ += data.size();
+    wake_.notify_one();
+    return true;
+}
+
+size_t Port::queued() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queuedBytes_;
+}
+
+bool Port::drain(int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto empty = [this] { return closing_ || ((queuedBytes_ == 0) && !writing_); };
+
+    if (timeoutMs < 0) {
+        space_.wait(lock, empty);
+        return true;
+    }
+    return space_.wait_for(lock, std::chrono::milliseconds(timeoutMs), empty);
+}
+
+ssize_t Port::read(uint8_t *buffer, size_t length, int timeoutMs)
+{
+    if (fd_ < 0)
+        return -1;
+
+    struct pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int ready = poll(&pfd, 1, timeoutMs);
+    if (ready <= 0)
+        return ready;
+
+    ssize_t count = ::read(fd_, buffer, length);
+    if ((count < 0) && ((errno == EAGAIN) || (errno == EINTR)))
+        return 0;
+    return count;
+}
+
+std::string Port::error() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+}
+
+uint64_t Port::bytesWritten() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytesWritten_;
+}
+
+uint64_t Port::messagesWritten() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return messagesWritten_;
+}
+
+bool Port::writeAll(const Bytes &data)
+{
+    size_t done = 0;
+
+    while (done < data.size()) {
+        ssize_t count = ::write(fd_, &data[done], data.size() - done);
+        if (count > 0) {
+            done += count;
+            continue;
+        }
+        if ((count < 0) && (errno != EAGAIN) && (errno != EINTR))
+            return false;
+
+        struct pollfd pfd;
+        pfd.fd = fd_;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        poll(&pfd, 1, 100);
+    }
+    return true;
+}
+
+void Port::writerLoop()
+{
+    Clock::time_point lineFree = Clock::now();   // When the line will have sent everything so far
+
+    for (;;) {
+        Bytes chunk;
+        bool pacing;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return closing_ || !queue_.empty(); });
+            if (closing_)
+                return;
+
+            chunk.swap(queue_.front());
+            queue_.pop_front();
+            writing_ = true;
+            pacing = pacing_;
+        }
+
+        if (pacing) {
+            // Hand the chunk over only once the line has finished sending the previous one.
+            Clock::time_point now = Clock::now();
+            if (lineFree > now)
+                std::this_thread::sleep_until(lineFree);
+            else
+                lineFree = now;
+            lineFree += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(wireSeconds(chunk.size(), baud_)));
+        }
+
+        bool ok = writeAll(chunk);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            writing_ = false;
+            queuedBytes_ -= chunk.size();
+            if (ok) {
+                bytesWritten_ += chunk.size();
+                messagesWritten_++;
+            }
+            else {
+                error_ = std::string("write: ") + strerror(errno);
+            }
+        }
+        space_.notify_all();
+    }
+}
+
+}  // namespace a5
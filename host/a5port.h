@@ -0,0 +1,114 @@
+/*
+ a5port.h
+
+ Part of the Alpha Five host tools
+
+ Serial transport for Alpha Clock Five (Linux).
+
+ Opens the clock's serial port (or a pseudo-terminal, for testing), and writes
+ queued messages from a background thread.  The writer paces itself to the line
+ rate, so that the queue -- not the kernel's tty buffer or the clock's 64-byte
+ receive buffer -- is where a backlog builds up.  send() blocks while the queue
+ is over its limit (backpressure); trySend() returns false instead.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef a5port_h
+#define a5port_h
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "a5proto.h"
+
+namespace a5 {
+
+// Open a serial device or pty slave, raw 8N1 at "baud", nonblocking.
+// Returns the file descriptor, or -1 (with "error" set).
+int openSerial(const std::string &path, int baud, std::string &error);
+
+class Port {
+public:
+    Port();
+    ~Port();
+
+    // Open a serial device (e.g., /dev/ttyUSB0) or pty slave, raw 8N1 at "baud".
+    bool open(const std::string &path, int baud = kDefaultBaud);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+    int baud() const { return baud_; }
+    std::string error() const;   // A copy: the writer thread may set it
+
+    // With pacing on (the default), data leaves no faster than the line rate.
+    // Turn it off only for links that aren't really serial lines.
+    void setPacing(bool pacing);
+
+    // Backpressure threshold: send() waits while at least this many bytes are queued.
+    void setQueueLimit(size_t bytes);
+
+    // Queue data (normally one or more whole messages) for the writer thread.
+    // timeoutMs < 0 waits indefinitely.  Returns false on timeout or if the port is closed.
+    bool send(const Bytes &data, int timeoutMs = -1);
+    bool trySend(const Bytes &data) { return send(data, 0); }
+
+    size_t queued() const;              // Bytes not yet handed to the OS
+    bool drain(int timeoutMs = -1);     // Wait for the queue to empty
+
+    // Read whatever the clock has sent, waiting up to timeoutMs for the first byte.
+    // Returns the number of bytes read, 0 on timeout, -1 on error.
+    ssize_t read(uint8_t *buffer, size_t length, int timeoutMs);
+
+    // Statistics
+    uint64_t bytesWritten() const;
+    uint64_t messagesWritten() const;   // One per send()
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void writerLoop();
+    bool writeAll(const Bytes &data);
+
+    int fd_;
+    int baud_;
+    bool pacing_;
+    size_t queueLimit_;
+    std::string error_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;       // Writer: data queued, or closing
+    std::condition_variable space_;      // Senders: queue has room, or drained
+    std::deque<Bytes> queue_;
+    size_t queuedBytes_;
+    bool writing_;                       // Writer holds a chunk outside the queue
+    bool closing_;
+    uint64_t bytesWritten_;
+    uint64_t messagesWritten_;
+    std::thread writer_;
+};
+
+}  // namespace a5
+
+#endif
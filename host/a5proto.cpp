@@ -0,0 +1,931 @@
+/*
+ a5proto.cpp
+
+ Part of the Alpha Five host tools
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "a5proto.h"
+
+namespace a5 {
+
+int unitAddress(int unit)
+{
+    if ((unit < 0) || (unit >= kMaxChainUnits))
+        return -1;
+    if (unit < 10)
+        return '0' + unit;
+    return unit;
+}
+
+double wireSeconds(size_t byteCount, int baud)
+{
+    return (10.0 * byteCount) / baud;   // Start bit + 8 data bits + stop bit
+}
+
+uint32_t localTimeNow()
+{
+    time_t t = time(NULL);
+    struct tm local;
+    localtime_r(&t, &local);
+    return (uint32_t) (t + local.tm_gmtoff);
+}
+
+uint64_t localTimeNowUs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    struct tm local;
+    localtime_r(&now.tv_sec, &local);
+    return (uint64_t) (now.tv_sec + local.tm_gmtoff) * 1000000 + now.tv_nsec / 1000;
+}
+
+bool appendText(Bytes &out, int unit, const char text[5], const char dp[5])
+{
+    int address = unitAddress(unit);
+    if (address < 0)
+        return false;
+
+    out.push_back(kHeader);
+    out.push_back('A');
+    out.push_back((uint8_t) address);
+    for (int i = 0; i < 5; i++)
+        out.push_back((uint8_t) text[i]);
+    for (int i = 0; i < 5; i++)
+        out.push_back((uint8_t) dp[i]);
+    return true;
+}
+
+static void appendPadding(Bytes &out, size_t messageStart)
+{   // Fill out the fixed-length message; the clock ignores these bytes.
+    while (out.size() < messageStart + kMessageLength)
+        out.push_back('_');
+}
+
+static void appendDigits(Bytes &out, unsigned int value, int digits)
+{
+    char buffer[12];
+    snprintf(buffer, sizeof(buffer), "%0*u", digits, value);
+    for (int i = 0; i < digits; i++)
+        out.push_back((uint8_t) buffer[i]);
+}
+
+static bool appendSettingHeader(Bytes &out, int unit, char setting)
+{
+    int address = unitAddress(unit);
+    if (address < 0)
+        return false;
+
+    out.push_back(kHeader);
+    out.push_back('B');
+    out.push_back((uint8_t) address);
+    out.push_back((uint8_t) setting);
+    return true;
+}
+
+void appendSetTime(Bytes &out, uint32_t localTime)
+{
+    out.push_back(kHeader);
+    out.push_back('S');
+    out.push_back('T');
+    appendDigits(out, localTime, 10);
+}
+
+bool appendBrightness(Bytes &out, int unit, int brightness)
+{
+    size_t start = out.size();
+    if ((brightness < 0) || (brightness > 11) || !appendSettingHeader(out, unit, '0'))
+        return false;
+    appendDigits(out, brightness, 2);
+    appendPadding(out, start);
+    return true;
+}
+
+bool appendNumberSet(Bytes &out, int unit, int charset)
+{
+    size_t start = out.size();
+    if ((charset < 0) || (charset > 9) || !appendSettingHeader(out, unit, '1'))
+        return false;
+    appendDigits(out, charset, 1);
+    appendPadding(out, start);
+    return true;
+}
+
+bool appendFontChar(Bytes &out, int unit, char asciiChar, int A, int B, int C)
+{
+    size_t start = out.size();
+    if ((A < 0) || (A > 255) || (B < 0) || (B > 3) || (C < 0) || (C > 255))
+        return false;
+    if (!appendSettingHeader(out, unit, '2'))
+        return false;
+    out.push_back((uint8_t) asciiChar);
+    appendDigits(out, A, 3);
+    appendDigits(out, B, 1);
+    appendDigits(out, C, 3);
+    appendPadding(out, start);
+    return true;
+}
+
+const char *const kTransitionNames[kTransitions] = { "fade", "wipe", "stagger", "draw" };
+
+bool appendTransition(Bytes &out, int unit, int effect)
+{
+    size_t start = out.size();
+    if ((effect < 0) || (effect >= kTransitions) || !appendSettingHeader(out, unit, '3'))
+        return false;
+    appendDigits(out, effect, 1);
+    appendPadding(out, start);
+    return true;
+}
+
+const char *const kSettingNames[kSettingsLength] = {
+    "brightness", "hour24", "alarm", "alarmhour", "alarmminute",
+    "alarmtone", "nightlight", "numbers", "display"
+};
+
+const uint8_t kSettingMax[kSettingsLength] = { 11, 1, 1, 23, 59, 5, 4, 9, 31 };
+
+uint8_t settingsChecksum(const uint8_t settings[kSettingsLength])
+{
+    unsigned int sum = 0;
+    for (int i = 0; i < kSettingsLength; i++)
+        sum += settings[i];
+    return sum & 127;
+}
+
+bool appendGetSettings(Bytes &out, int unit)
+{
+    size_t start = out.size();
+    int address = unitAddress(unit);
+    if (address < 0)
+        return false;
+
+    out.push_back(kHeader);
+    out.push_back('G');
+    out.push_back((uint8_t) address);
+    appendPadding(out, start);
+    return true;
+}
+
+bool appendPutSettings(Bytes &out, int unit, const uint8_t settings[kSettingsLength])
+{
+    int address = unitAddress(unit);
+    if (address < 0)
+        return false;
+    for (int i = 0; i < kSettingsLength; i++)
+        if (settings[i] > kSettingMax[i])
+            return false;
+
+    out.push_back(kHeader);
+    out.push_back('P');
+    out.push_back((uint8_t) address);
+    out.insert(out.end(), settings, settings + kSettingsLength);
+    out.push_back(settingsChecksum(settings));
+    return true;
+}
+
+std::string formatSettings(const uint8_t settings[kSettingsLength])
+{
+    std::string text;
+    char field[32];
+    for (int i = 0; i < kSettingsLength; i++) {
+        snprintf(field, sizeof(field), "%s%s=%d", i ? " " : "", kSettingNames[i], settings[i]);
+        text += field;
+    }
+    return text;
+}
+
+bool parseSettings(const std::vector<std::string> &fields, uint8_t settings[kSettingsLength])
+{
+    bool seen[kSettingsLength] = { false };
+
+    for (size_t i = 0; i < fields.size(); i++) {
+        size_t equals = fields[i].find('=');
+        if (equals == std::string::npos)
+            return false;
+        std::string name = fields[i].substr(0, equals);
+        int j = 0;
+        while ((j < kSettingsLength) && (name != kSettingNames[j]))
+            j++;
+        if ((j == kSettingsLength) || seen[j])
+            return false;
+        seen[j] = true;
+        settings[j] = (uint8_t) atoi(fields[i].c_str() + equals + 1);
+    }
+    for (int j = 0; j < kSettingsLength; j++)
+        if (!seen[j])
+            return false;
+    return true;
+}
+
+size_t parseSettingsReply(const uint8_t *data, size_t length, char type,
+                          uint8_t settings[kSettingsLength])
+{
+    for (size_t i = 0; i + kMessageLength <= length; i++) {
+        const uint8_t *reply = &data[i];
+        if ((reply[0] != kHeader) || (reply[1] != (uint8_t) type) || (reply[2] != '0'))
+            continue;
+        if (settingsChecksum(&reply[3]) != reply[3 + kSettingsLength])
+            continue;
+        for (int j = 0; j < kSettingsLength; j++)
+            settings[j] = reply[3 + j];
+        return i + kMessageLength;
+    }
+    return 0;
+}
+
+static const char *const kDayNames[7] = { "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+static const uint8_t kWeekdays = 0x3E;
+static const uint8_t kWeekends = 0x41;
+
+static bool appendAlarmMessage(Bytes &out, int unit, char action, int alarm)
+{
+    int address = unitAddress(unit);
+    if ((address < 0) || (alarm < 0) || (alarm > 255))
+        return false;
+
+    out.push_back(kHeader);
+    out.push_back('L');
+    out.push_back((uint8_t) address);
+    out.push_back((uint8_t) action);
+    out.push_back((uint8_t) alarm);
+    return true;
+}
+
+bool appendGetAlarm(Bytes &out, int unit, int alarm)
+{
+    size_t start = out.size();
+    if (!appendAlarmMessage(out, unit, '?', alarm))
+        return false;
+    appendPadding(out, start);
+    return true;
+}
+
+bool appendSetAlarm(Bytes &out, int unit, int alarm, uint8_t days, int hour, int minute)
+{
+    size_t start = out.size();
+    if ((days > kAlarmEveryDay) || (hour < 0) || (hour > 23) || (minute < 0) || (minute > 59))
+        return false;
+    if (!appendAlarmMessage(out, unit, '=', alarm))
+        return false;
+    out.push_back(days);
+    out.push_back((uint8_t) hour);
+    out.push_back((uint8_t) minute);
+    appendPadding(out, start);
+    return true;
+}
+
+std::string formatAlarmDays(uint8_t days)
+{
+    days &= kAlarmEveryDay;
+    if (days == kAlarmEveryDay)
+        return "daily";
+    if (days == kWeekdays)
+        return "weekdays";
+    if (days == kWeekends)
+        return "weekends";
+    if (days == 0)
+        return "never";
+
+    std::string text;
+    for (int i = 0; i < 7; i++) {
+        if (days & (1 << i)) {
+            if (!text.empty())
+                text += ",";
+            text += kDayNames[i];
+        }
+    }
+    return text;
+}
+
+bool parseAlarmDays(const std::string &text, uint8_t &days)
+{
+    if (text == "daily")
+        days = kAlarmEveryDay;
+    else if (text == "weekdays")
+        days = kWeekdays;
+    else if (text == "weekends")
+        days = kWeekends;
+    else if ((text == "never") || (text == "off"))
+        days = 0;
+    else {
+        days = 0;
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t comma = text.find(',', start);
+            if (comma == std::string::npos)
+                comma = text.size();
+            std::string name = text.substr(start, comma - start);
+            int i = 0;
+            while ((i < 7) && (name != kDayNames[i]))
+                i++;
+            if (i == 7)
+                return false;
+            days |= 1 << i;
+            start = comma + 1;
+        }
+    }
+    return true;
+}
+
+size_t parseAlarmReply(const uint8_t *data, size_t length, AlarmReply &reply)
+{
+    for (size_t i = 0; i + kMessageLength <= length; i++) {
+        const uint8_t *r = &data[i];
+        if ((r[0] != kHeader) || (r[1] != 'l') || (r[2] != '0'))
+            continue;
+        reply.alarm = r[3];
+        reply.count = r[4];
+        reply.days = r[5];
+        reply.hour = r[6];
+        reply.minute = r[7];
+        reply.nextTime = r[8] | (r[9] << 8) | (r[10] << 16) | ((uint32_t) r[11] << 24);
+        return i + kMessageLength;
+    }
+    return 0;
+}
+
+static bool appendMenuMessage(Bytes &out, int unit, char action, int item, int value)
+{
+    int address = unitAddress(unit);
+    if ((address < 0) || (item < 0) || (item > 255) || (value < 0) || (value > 255))
+        return false;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('O');
+    out.push_back((uint8_t) address);
+    out.push_back((uint8_t) action);
+    out.push_back((uint8_t) item);
+    out.push_back((uint8_t) value);
+    appendPadding(out, start);
+    return true;
+}
+
+bool appendGetMenuItem(Bytes &out, int unit, int item)
+{
+    return appendMenuMessage(out, unit, '?', item, 0);
+}
+
+bool appendSetMenuItem(Bytes &out, int unit, int item, int value)
+{
+    return appendMenuMessage(out, unit, '=', item, value);
+}
+
+size_t parseMenuReply(const uint8_t *data, size_t length, MenuReply &reply)
+{
+    for (size_t i = 0; i + kMessageLength <= length; i++) {
+        const uint8_t *r = &data[i];
+        if ((r[0] != kHeader) || (r[1] != 'o') || (r[2] != '0'))
+            continue;
+        reply.item = r[3];
+        reply.count = r[4];
+        reply.value = r[5];
+        reply.maximum = r[6];
+        reply.label.assign((const char *) &r[7], 5);
+        return i + kMessageLength;
+    }
+    return 0;
+}
+
+bool appendWatch(Bytes &out, int unit, char action, uint32_t hundredths)
+{
+    int address = unitAddress(unit);
+    if ((address < 0) || ((action == 'C') && ((hundredths == 0) || (hundredths > kWatchMax))))
+        return false;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('W');
+    out.push_back((uint8_t) address);
+    out.push_back((uint8_t) action);
+    for (int i = 0; i < 4; i++)
+        out.push_back((uint8_t) (hundredths >> (8 * i)));
+    appendPadding(out, start);
+    return true;
+}
+
+size_t parseWatchReply(const uint8_t *data, size_t length, WatchReply &reply)
+{
+    for (size_t i = 0; i + kMessageLength <= length; i++) {
+        const uint8_t *r = &data[i];
+        if ((r[0] != kHeader) || (r[1] != 'w') || (r[2] != '0'))
+            continue;
+        reply.mode = r[3];
+        reply.reading = r[4] | (r[5] << 8) | ((uint32_t) r[6] << 16);
+        reply.longestUs = r[7] | (r[8] << 8);
+        reply.frames = r[9] | (r[10] << 8);
+        reply.missed = r[11] | (r[12] << 8);
+        return i + kMessageLength;
+    }
+    return 0;
+}
+
+void appendModeTime(Bytes &out)
+{
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('M');
+    out.push_back('T');
+    appendPadding(out, start);
+}
+
+bool appendEcho(Bytes &out, int unit, uint8_t sequence)
+{
+    int address = unitAddress(unit);
+    if (address < 0)
+        return false;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('T');
+    out.push_back((uint8_t) address);
+    out.push_back('E');
+    out.push_back(sequence);
+    appendPadding(out, start);
+    return true;
+}
+
+void appendTimeSync(Bytes &out, uint64_t localTimeUs, uint8_t sequence)
+{
+    uint32_t seconds = (uint32_t) (localTimeUs / 1000000);
+    uint32_t us = localTimeUs % 1000000;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('T');
+    out.push_back(0);
+    out.push_back('S');
+    out.push_back(sequence);
+    for (int i = 0; i < 4; i++)
+        out.push_back((uint8_t) (seconds >> (8 * i)));
+    for (int i = 0; i < 3; i++)
+        out.push_back((uint8_t) (us >> (8 * i)));
+    appendPadding(out, start);
+}
+
+size_t parseTimeReply(const uint8_t *data, size_t length, TimeReply &reply)
+{
+    for (size_t i = 0; i + kMessageLength <= length; i++) {
+        const uint8_t *r = &data[i];
+        if ((r[0] != kHeader) || (r[1] != 't') || ((r[3] != 'E') && (r[3] != 'S')))
+            continue;
+        reply.type = r[3];
+        reply.hops = r[2];
+        reply.sequence = r[4];
+        uint32_t seconds = r[5] | (r[6] << 8) | (r[7] << 16) | ((uint32_t) r[8] << 24);
+        reply.timeUs = (uint64_t) seconds * 1000000 + (r[9] | (r[10] << 8) | (r[11] << 16));
+        return i + kMessageLength;
+    }
+    return 0;
+}
+
+void appendDiscover(Bytes &out, uint8_t sequence)
+{
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('D');
+    out.push_back(0);
+    out.push_back('?');
+    out.push_back(sequence);
+    appendPadding(out, start);
+}
+
+size_t parseDiscoveryReport(const uint8_t *data, size_t length, DiscoveryReport &report)
+{
+    for (size_t i = 0; i + kMessageLength <= length; i++) {
+        const uint8_t *r = &data[i];
+        if ((r[0] != kHeader) || (r[1] != 'd') || ((r[3] != 'U') && (r[3] != 'H')))
+            continue;
+        report.index = r[2];
+        report.type = r[3];
+        report.sequence = r[4];
+        report.version[0] = report.version[1] = report.version[2] = 0;
+        report.residenceUs = 0;
+        report.bootMs = 0;
+        report.rtc = 0;
+        report.hopUs = 0;
+        if (report.type == 'U') {
+            report.version[0] = r[5];
+            report.version[1] = r[6];
+            report.version[2] = r[7];
+            report.residenceUs = r[8] | (r[9] << 8);
+            report.bootMs = r[10] | (r[11] << 8);
+            report.rtc = r[12];
+        }
+        else {
+            report.hopUs = r[5] | (r[6] << 8) | (r[7] << 16);
+        }
+        return i + kMessageLength;
+    }
+    return 0;
+}
+
+bool addDiscoveryReport(std::vector<ChainUnit> &chain, const DiscoveryReport &report)
+{
+    if ((size_t) report.index >= chain.size()) {
+        ChainUnit unknown = { false, { 0, 0, 0 }, 0, 0, 0, -1, 0 };
+        chain.resize(report.index + 1, unknown);
+    }
+
+    ChainUnit &unit = chain[report.index];
+    if (report.type == 'U') {
+        unit.reported = true;
+        for (int i = 0; i < 3; i++)
+            unit.version[i] = report.version[i];
+        unit.residenceUs = report.residenceUs;
+        unit.bootMs = report.bootMs;
+        unit.rtc = report.rtc;
+    }
+    else {
+        unit.hopUs = report.hopUs;
+    }
+
+    double delayMs = 0;
+    for (size_t i = 0; i < chain.size(); i++) {
+        if (!chain[i].reported || (chain[i].hopUs < 0))
+            return false;
+        chain[i].delayMs = delayMs;
+        if (chain[i].hopUs == 0)
+            return i + 1 == chain.size();
+        delayMs += (chain[i].residenceUs + chain[i].hopUs / 2.0) / 1000;
+    }
+    return false;
+}
+
+size_t frameIndex(int column, int segment)
+{
+    return kSegmentsPerChar * (4 - column) + segment;
+}
+
+static void appendNibbles(Bytes &out, const uint8_t *levels, size_t count)
+{
+    for (size_t i = 0; i < count; i += 2) {
+        uint8_t packed = levels[i] & 15;
+        if (i + 1 < count)
+            packed |= (levels[i + 1] & 15) << 4;
+        out.push_back(packed);
+    }
+}
+
+bool appendKeyFrame(Bytes &out, int unit, const uint8_t frame[kFrameSegments])
+{
+    int address = unitAddress(unit);
+    if (address < 0)
+        return false;
+
+    out.push_back(kHeader);
+    out.push_back('V');
+    out.push_back((uint8_t) address);
+    out.push_back('K');
+    appendNibbles(out, frame, kFrameSegments);
+    return true;
+}
+
+struct Run {
+    size_t first, count;
+    size_t bytes() const { return 2 + (count + 1) / 2; }
+};
+
+int appendDeltaFrame(Bytes &out, int unit, const uint8_t from[kFrameSegments],
+                     const uint8_t to[kFrameSegments])
+{
+    int address = unitAddress(unit);
+    if (address < 0)
+        return -1;
+
+    // Runs of changed segments.  Unchanged gaps of up to three segments are sent
+    // along with their neighbours: that costs no more than the two-byte run header.
+    std::vector<Run> runs;
+    size_t total = 0;
+    for (size_t i = 0; i < kFrameSegments; i++) {
+        if ((from[i] & 15) == (to[i] & 15))
+            continue;
+        if (!runs.empty() && (i - (runs.back().first + runs.back().count) <= 3)) {
+            total -= runs.back().bytes();
+            runs.back().count = i + 1 - runs.back().first;
+        }
+        else {
+            Run run = { i, 1 };
+            runs.push_back(run);
+        }
+        total += runs.back().bytes();
+    }
+
+    if (runs.empty())
+        return 0;
+    if (total + 5 >= kKeyFrameLength)
+        return appendKeyFrame(out, unit, to) ? 1 : -1;
+
+    // A delta never needs more than kMaxDeltaData bytes: past that, a key frame is shorter.
+    size_t padding = (total < kMessageLength - 5) ? (kMessageLength - 5 - total + 1) / 2 : 0;
+
+    out.push_back(kHeader);
+    out.push_back('V');
+    out.push_back((uint8_t) address);
+    out.push_back('D');
+    out.push_back((uint8_t) (total + 2 * padding));
+    for (size_t r = 0; r < runs.size(); r++) {
+        out.push_back((uint8_t) runs[r].first);
+        out.push_back((uint8_t) runs[r].count);
+        appendNibbles(out, &to[runs[r].first], runs[r].count);
+    }
+    for (size_t i = 0; i < padding; i++) {   // Empty runs, up to the 13-byte minimum
+        out.push_back(0);
+        out.push_back(0);
+    }
+    return 1;
+}
+
+uint16_t storeCRC(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t x = data[i] ^ (crc & 0xFF);
+        x ^= x << 4;
+        crc = ((((uint16_t) x << 8) | (crc >> 8)) ^ (uint8_t) (x >> 4) ^ ((uint16_t) x << 3));
+    }
+    return crc;
+}
+
+bool appendStoreRecord(Bytes &image, uint8_t type, const Bytes &data)
+{
+    if (data.size() > 255)
+        return false;
+    image.push_back(type);
+    image.push_back((uint8_t) data.size());
+    image.insert(image.end(), data.begin(), data.end());
+    return true;
+}
+
+bool appendSequenceWord(Bytes &data, const char word[5], double seconds)
+{
+    long tenths = lround(seconds * 10);
+    if ((tenths < 1) || (tenths > 255))
+        return false;
+    data.insert(data.end(), word, word + 5);
+    data.push_back((uint8_t) tenths);
+    return true;
+}
+
+Bytes storePage(const Bytes &image, int page, size_t pageSize)
+{
+    Bytes data(pageSize, kStoreEnd);
+    for (size_t i = 0; i < pageSize; i++)
+        if (page * pageSize + i < image.size())
+            data[i] = image[page * pageSize + i];
+    return data;
+}
+
+bool appendStorePage(Bytes &out, int unit, int page, const Bytes &image, size_t pageSize)
+{
+    int address = unitAddress(unit);
+    if ((address < 0) || (page < 0) || (page > 255) || !pageSize || (pageSize > 256) ||
+        (pageSize % kStoreLoadLength))
+        return false;
+
+    Bytes data = storePage(image, page, pageSize);
+    for (size_t offset = 0; offset < pageSize; offset += kStoreLoadLength) {
+        out.push_back(kHeader);
+        out.push_back('F');
+        out.push_back((uint8_t) address);
+        out.push_back('L');
+        out.push_back((uint8_t) offset);
+        out.push_back((uint8_t) kStoreLoadLength);
+        out.insert(out.end(), data.begin() + offset, data.begin() + offset + kStoreLoadLength);
+    }
+
+    uint16_t crc = storeCRC(&data[0], pageSize);
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('F');
+    out.push_back((uint8_t) address);
+    out.push_back('W');
+    out.push_back((uint8_t) page);
+    out.push_back((uint8_t) crc);
+    out.push_back((uint8_t) (crc >> 8));
+    appendPadding(out, start);
+    return true;
+}
+
+bool appendGetStorePage(Bytes &out, int unit, int page)
+{
+    int address = unitAddress(unit);
+    if ((address < 0) || (page < 0) || (page > 255))
+        return false;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('F');
+    out.push_back((uint8_t) address);
+    out.push_back('?');
+    out.push_back((uint8_t) page);
+    appendPadding(out, start);
+    return true;
+}
+
+bool appendShowStored(Bytes &out, int unit, uint8_t type, int index)
+{
+    int address = unitAddress(unit);
+    if ((address < 0) || (index < 0) || (index > 255))
+        return false;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('F');
+    out.push_back((uint8_t) address);
+    out.push_back('S');
+    out.push_back(type);
+    out.push_back((uint8_t) index);
+    appendPadding(out, start);
+    return true;
+}
+
+size_t parseStoreReply(const uint8_t *data, size_t length, StoreReply &reply)
+{
+    for (size_t i = 0; i + kMessageLength <= length; i++) {
+        const uint8_t *r = &data[i];
+        if ((r[0] != kHeader) || (r[1] != 'f') || (r[2] != '0'))
+            continue;
+        reply.op = r[3];
+        reply.page = r[4];
+        reply.status = r[5];
+        reply.loaded = r[6] | (r[7] << 8);
+        reply.crc = r[8] | (r[9] << 8);
+        reply.pages = r[10];
+        reply.pageSize = r[11] | (r[12] << 8);
+        return i + kMessageLength;
+    }
+    return 0;
+}
+
+
+bool parseGlyph(const char *text, Glyph &glyph)
+{
+    unsigned a, b, c;
+    char extra;
+    if ((sscanf(text, "%u,%u,%u%c", &a, &b, &c, &extra) != 3) || (a > 255) || (b > 3) || (c > 255))
+        return false;
+    glyph.a = a;
+    glyph.b = b;
+    glyph.c = c;
+    return true;
+}
+
+Bytes glyphBankRecord(char first, const std::vector<Glyph> &glyphs)
+{
+    Bytes data(1, (uint8_t) first);
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        data.push_back(glyphs[i].a);
+        data.push_back(glyphs[i].b);
+        data.push_back(glyphs[i].c);
+    }
+    return data;
+}
+
+bool appendGlyphBank(Bytes &out, int unit, char first, const std::vector<Glyph> &glyphs)
+{
+    int address = unitAddress(unit);
+    if ((address < 0) || (glyphs.size() > (size_t) kBankGlyphs))
+        return false;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('C');
+    out.push_back((uint8_t) address);
+    out.push_back('U');
+    out.push_back((uint8_t) first);
+    out.push_back((uint8_t) glyphs.size());
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        out.push_back(glyphs[i].a);
+        out.push_back(glyphs[i].b);
+        out.push_back(glyphs[i].c);
+    }
+    appendPadding(out, start);
+    return true;
+}
+
+bool appendStoredBank(Bytes &out, int unit, int index)
+{
+    int address = unitAddress(unit);
+    if ((address < 0) || (index < 0) || (index > 255))
+        return false;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('C');
+    out.push_back((uint8_t) address);
+    out.push_back('G');
+    out.push_back((uint8_t) index);
+    appendPadding(out, start);
+    return true;
+}
+
+bool appendGetBank(Bytes &out, int unit)
+{
+    int address = unitAddress(unit);
+    if (address < 0)
+        return false;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('C');
+    out.push_back((uint8_t) address);
+    out.push_back('?');
+    appendPadding(out, start);
+    return true;
+}
+
+size_t parseBankReply(const uint8_t *data, size_t length, BankReply &reply)
+{
+    for (size_t i = 0; i + kMessageLength <= length; i++) {
+        const uint8_t *r = &data[i];
+        if ((r[0] != kHeader) || (r[1] != 'c') || (r[2] != '0'))
+            continue;
+        reply.op = r[3];
+        reply.source = r[4];
+        reply.index = r[5];
+        reply.first = (char) r[6];
+        reply.count = r[7];
+        return i + kMessageLength;
+    }
+    return 0;
+}
+
+bool sameOnScreen(uint8_t a, uint8_t b)
+{   // 8 and 9, 11 and 12, and 13 and 14 share a brightness level.
+    static const uint8_t shown[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 8, 10, 11, 11, 13, 13, 15 };
+    return shown[a & 15] == shown[b & 15];
+}
+
+bool appendGetScreen(Bytes &out, int unit, bool frame)
+{
+    int address = unitAddress(unit);
+    if (address < 0)
+        return false;
+
+    size_t start = out.size();
+    out.push_back(kHeader);
+    out.push_back('R');
+    out.push_back((uint8_t) address);
+    out.push_back(frame ? 'F' : 'C');
+    appendPadding(out, start);
+    return true;
+}
+
+size_t parseScreenReply(const uint8_t *data, size_t length, ScreenReply &reply)
+{
+    const size_t frameBytes = kFrameSegments / 2;
+
+    for (size_t i = 0; i + kMessageLength <= length; i++) {
+        const uint8_t *r = &data[i];
+        if ((r[0] != kHeader) || (r[1] != 'r') || (r[2] != '0'))
+            continue;
+        size_t end = i + kMessageLength + ((r[3] == 'F') ? frameBytes : 0);
+        if (end > length)
+            return 0;   // The frame is still on its way
+        reply.op = r[3];
+        reply.mode = r[4];
+        reply.display = r[5];
+        reply.brightness = r[6];
+        reply.brightMode = r[7];
+        reply.level = r[8];
+        reply.lit = r[9];
+        reply.fading = (r[10] != 0);
+        reply.crc = r[11] | (r[12] << 8);
+        reply.frameOk = false;
+        memset(reply.frame, 0, sizeof(reply.frame));
+        if (reply.op == 'F') {
+            const uint8_t *packed = &r[kMessageLength];
+            for (size_t j = 0; j < kFrameSegments; j++)
+                reply.frame[j] = (j & 1) ? (packed[j / 2] >> 4) : (packed[j / 2] & 15);
+            reply.frameOk = (storeCRC(packed, frameBytes) == reply.crc);
+        }
+        return end;
+    }
+    return 0;
+}
+
+}  // namespace a5
@@ -0,0 +1,437 @@
+/*
+ a5proto.h
+
+ Part of the Alpha Five host tools
+
+ Framing for the Alpha Clock Five serial protocol, as spoken by the
+ AlphaClock firmware (see processSerialMessage() in AlphaClock.ino).
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef a5proto_h
+#define a5proto_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace a5 {
+
+// Every command is a header byte followed by 12 bytes:
+//   [0xFF] [command] [unit] [10 bytes of data]
+// "unit" is the number of times the message is relayed along the daisy chain
+// (Serial1) before it is acted upon; 0 means the clock on the host's port.
+const uint8_t kHeader = 255;
+const size_t kMessageLength = 13;
+
+const int kDefaultBaud = 19200;
+
+// Units 0-9 are addressed with ASCII digits, which every firmware version understands.
+// Units 10-47 use a binary relay count, which the firmware decrements once per hop.
+// (Values 48-57 are the ASCII digits again, so they cannot be used as binary counts.)
+const int kMaxChainUnits = 48;
+
+// Highest character in the clock's font table: printable ASCII through '~', then the extra
+// glyphs 127-130 (degree sign, all segments, up and down arrows).  Firmware before this
+// version stops at 'e', with 'a'-'e' blank unless defined with the B<n>2 command.
+const uint8_t kLastFontChar = 130;
+
+typedef std::vector<uint8_t> Bytes;
+
+// Encode the relay count for the given unit, or -1 if the unit can't be addressed.
+int unitAddress(int unit);
+
+// Seconds needed to send "byteCount" bytes at the given baud rate, 8N1.
+double wireSeconds(size_t byteCount, int baud = kDefaultBaud);
+
+// This computer's local time, as seconds since 1970: the clock keeps local time, as the
+// Processing sketch AlphaClock_SetTime does.
+uint32_t localTimeNow();
+
+// The same, in microseconds.
+uint64_t localTimeNowUs();
+
+// A0 / Ax: display five characters, with a five-character decimal point string.
+// DP characters: '1' lower DP, '2' upper DP, '3' both; anything else: neither.
+// Returns false (and appends nothing) if the unit can't be addressed.
+bool appendText(Bytes &out, int unit, const char text[5], const char dp[5]);
+
+// ST: set the time, as seconds since 1970 in the clock's local time zone.
+// (Not relayed along the daisy chain; acts on unit 0 only.)
+void appendSetTime(Bytes &out, uint32_t localTime);
+
+// B<n>0: set brightness, 0-11, as with the + and - buttons.
+bool appendBrightness(Bytes &out, int unit, int brightness);
+
+// B<n>1: select alternate number style, 0-9.
+bool appendNumberSet(Bytes &out, int unit, int charset);
+
+// B<n>2: redefine a font character. A: 0-255, B: 0-3, C: 0-255, as for a5editFontChar().
+bool appendFontChar(Bytes &out, int unit, char asciiChar, int A, int B, int C);
+
+// B<n>3: select the transition used when the display changes, by index into kTransitionNames.
+// Not saved; the clock starts with the uniform fade.
+const int kTransitions = 4;
+extern const char *const kTransitionNames[kTransitions];   // "fade", "wipe", "stagger", "draw"
+bool appendTransition(Bytes &out, int unit, int effect);
+
+// MT: return to time display.  (Acts on unit 0 only.)
+void appendModeTime(Bytes &out);
+
+// Settings snapshot (G<n>, P<n>): the clock's stored settings, as nine raw values, in this order.
+enum SettingIndex {
+    kSettingBrightness,     // 0-11
+    kSettingHourMode24,     // 0-1
+    kSettingAlarmEnabled,   // 0-1
+    kSettingAlarmHour,      // 0-23
+    kSettingAlarmMinute,    // 0-59
+    kSettingAlarmTone,      // 0-5
+    kSettingNightLight,     // 0-4
+    kSettingNumberSet,      // 0-9
+    kSettingDisplayMode,    // 0-31
+    kSettingsLength
+};
+
+extern const char *const kSettingNames[kSettingsLength];
+extern const uint8_t kSettingMax[kSettingsLength];
+
+// G<n>: ask for a unit's settings.  It replies, upstream through the chain, with
+//   [0xFF] ['g'] ['0'] [9 settings] [checksum]
+bool appendGetSettings(Bytes &out, int unit);
+
+// P<n>: apply and save a complete set of settings.  The unit applies all of them or, if any
+// is out of range, none; either way, it replies as for G<n>, but with 'p'.
+// Returns false if the unit can't be addressed or a value is out of range.
+bool appendPutSettings(Bytes &out, int unit, const uint8_t settings[kSettingsLength]);
+
+// The reply's checksum: the sum of the settings, modulo 128, so that it is never a header byte.
+uint8_t settingsChecksum(const uint8_t settings[kSettingsLength]);
+
+// Settings as text: "brightness=9 hour24=0 ...", one NAME=VALUE per setting.
+// parseSettings() requires every setting, exactly once.
+std::string formatSettings(const uint8_t settings[kSettingsLength]);
+bool parseSettings(const std::vector<std::string> &fields, uint8_t settings[kSettingsLength]);
+
+// Find a settings reply ('g' or 'p') with a valid checksum in data received from the clock.
+// Returns the number of bytes consumed through the end of the reply, or 0 if none was found.
+size_t parseSettingsReply(const uint8_t *data, size_t length, char type,
+                          uint8_t settings[kSettingsLength]);
+
+// Alarms (L<n>).  Each alarm has a time of day and a set of days on which it sounds;
+// AlarmEnabled (above) turns all of them on or off.  Alarm 0 is the one set with the buttons,
+// and is the same as kSettingAlarmHour and kSettingAlarmMinute.
+//   Read:   [0xFF] ['L'] [unit] ['?'] [alarm] [8 bytes]
+//   Write:  [0xFF] ['L'] [unit] ['='] [alarm] [days] [hour] [minute] [5 bytes]
+// Either way the unit replies, upstream through the chain, with
+//   [0xFF] ['l'] ['0'] [alarm] [number of alarms] [days] [hour] [minute] [next: 4 bytes] [0]
+// A write with a value out of range is ignored.  (Firmware before this version ignores L<n>.)
+const uint8_t kAlarmEveryDay = 0x7F;    // Days: bit 0 for Sunday, through bit 6 for Saturday
+
+struct AlarmReply {
+    int alarm;
+    int count;              // Number of alarms that the unit has
+    uint8_t days;           // 0: never sounds
+    int hour;               // 0-23
+    int minute;             // 0-59
+    uint32_t nextTime;      // When it will next sound, in the clock's local time (as for ST); 0: never
+};
+
+// Returns false if the unit can't be addressed or (for a write) a value is out of range.
+bool appendGetAlarm(Bytes &out, int unit, int alarm);
+bool appendSetAlarm(Bytes &out, int unit, int alarm, uint8_t days, int hour, int minute);
+
+// Days as text: "daily", "weekdays", "weekends", "never", or a list such as "mon,wed,fri".
+// parseAlarmDays() also takes "off" for "never".
+std::string formatAlarmDays(uint8_t days);
+bool parseAlarmDays(const std::string &text, uint8_t &days);
+
+// Find an alarm reply in data received from the clock.  Returns the number of bytes consumed
+// through the end of the reply, or 0 if none was found.
+size_t parseAlarmReply(const uint8_t *data, size_t length, AlarmReply &reply);
+
+// Menu settings (O<n>), through the clock's own settings-menu table.
+//   Read:   [0xFF] ['O'] [unit] ['?'] [item] [8 bytes]
+//   Write:  [0xFF] ['O'] [unit] ['='] [item] [value] [7 bytes]
+// Either way the unit replies, upstream through the chain, with
+//   [0xFF] ['o'] ['0'] [item] [number of items] [value] [maximum] [label: 5 bytes] [0]
+// A write takes effect as if made with + and -, and is saved a few seconds later.  Items with a
+// maximum of 0 (actions such as SET YEAR) can't be set this way.  (Older firmware ignores O<n>.)
+struct MenuReply {
+    int item;
+    int count;              // Number of items in the unit's menu
+    int value;
+    int maximum;            // Values run 0 to maximum; 0: not settable
+    std::string label;      // As the clock shows the value, e.g. "24 HR"; or the item's title
+};
+
+// Returns false if the unit can't be addressed or the item or value is out of range (0-255).
+bool appendGetMenuItem(Bytes &out, int unit, int item);
+bool appendSetMenuItem(Bytes &out, int unit, int item, int value);
+
+// Find a menu reply in data received from the clock.  Returns the number of bytes consumed
+// through the end of the reply, or 0 if none was found.
+size_t parseMenuReply(const uint8_t *data, size_t length, MenuReply &reply);
+
+// Stopwatch and countdown (W<n>).
+//   [0xFF] ['W'] [unit] [action] [hundredths: 4 bytes] [5 bytes]
+// Actions: 'S' start the stopwatch from zero, 'C' start a countdown from "hundredths",
+// 'G' go, 'H' hold, 'R' reset, 'X' return to the clock, '?' report only.  The unit replies
+//   [0xFF] ['w'] ['0'] [mode] [reading: 3 bytes] [longest frame, us: 2 bytes] [frames: 2 bytes]
+//   [missed hundredths: 2 bytes]
+// The watch is redrawn as each hundredth begins; a frame is timed from then until the new
+// reading is in the display's video buffer.  (Firmware before this version ignores W<n>.)
+const uint32_t kWatchMax = 599999;      // 99:59.99, in hundredths
+
+struct WatchReply {
+    uint8_t mode;           // 0: clock; 'S' or 'C': stopwatch or countdown, running; 's' or 'c': stopped
+    uint32_t reading;       // Hundredths shown
+    unsigned longestUs;     // Longest frame since the watch was started
+    unsigned frames;
+    unsigned missed;        // Hundredths never shown while the watch was running
+};
+
+// Returns false if the unit can't be addressed or the countdown is out of range.
+bool appendWatch(Bytes &out, int unit, char action, uint32_t hundredths = 0);
+
+// Find a watch reply in data received from the clock.  Returns the number of bytes consumed
+// through the end of the reply, or 0 if none was found.
+size_t parseWatchReply(const uint8_t *data, size_t length, WatchReply &reply);
+
+// Sub-second time sync (T<n>).  Binary fields are least significant byte first.
+//
+// Echo: [0xFF] ['T'] [unit] ['E'] [sequence] [8 bytes]
+//   The unit replies at once with [0xFF] ['t'] ['0'] ['E'] [sequence] [the same 8 bytes].
+//   Half the round trip is the host's estimate of a message's one-way delay.
+//
+// Sync: [0xFF] ['T'] [hops] ['S'] [sequence] [seconds: 4 bytes] [microseconds: 3 bytes] [1 byte]
+//   Local time (as for ST) as of the arrival of the message at unit 0; "hops" is 0 from the host.
+//   Every unit in the chain sets its clock at its next second rollover, acks upstream with
+//   [0xFF] ['t'] [hops] ['S'] [sequence] [the time it received], and passes the message on with
+//   hops + 1 and the time moved on by its own delay and the time on the wire to the next unit.
+//   (Firmware before this version ignores T<n>.)
+struct TimeReply {
+    uint8_t type;           // 'E' or 'S'
+    int hops;               // S: the unit's place in the chain, 0 for the unit on the host's port
+    uint8_t sequence;
+    uint64_t timeUs;        // S: the time the unit received, as for localTimeNowUs()
+};
+
+// Returns false if the unit can't be addressed.
+bool appendEcho(Bytes &out, int unit, uint8_t sequence);
+void appendTimeSync(Bytes &out, uint64_t localTimeUs, uint8_t sequence);
+
+// Find a T<n> reply in data received from the clock.  Returns the number of bytes consumed
+// through the end of the reply, or 0 if none was found.
+size_t parseTimeReply(const uint8_t *data, size_t length, TimeReply &reply);
+
+// Daisy-chain discovery (D).  The request goes down the whole chain:
+//   [0xFF] ['D'] [0] ['?'] [sequence] [8 bytes]
+// and every unit sends back two reports, [0xFF] ['d'] [index] [type] [sequence] [8 bytes]:
+//   'U'  at once: firmware version, how long the unit took to pass the request on, how long
+//        it took from start-up to its first frame, and whether it found its RTC module.
+//   'H'  once the next unit has answered: the round trip over that hop, from passing the
+//        request on to the first byte of the next unit's 'U' report; 0 for the last unit.
+// (Firmware before this version ignores D.)
+struct DiscoveryReport {
+    int index;              // Unit number: 0 for the unit on the host's port
+    uint8_t type;           // 'U' or 'H'
+    uint8_t sequence;
+    uint8_t version[3];     // U: major, minor, patch
+    unsigned residenceUs;   // U
+    unsigned bootMs;        // U: start-up to first frame; 0 from older firmware
+    uint8_t rtc;            // U: 'R' in use, 'N' no answer, 'B' bus fault, 'S' not set;
+                            //    0 while the unit is still probing, or from older firmware
+    unsigned hopUs;         // H: 0 if there is no unit below this one
+};
+
+void appendDiscover(Bytes &out, uint8_t sequence);
+
+// Find a discovery report in data received from the clock.  Returns the number of bytes
+// consumed through the end of the report, or 0 if none was found.
+size_t parseDiscoveryReport(const uint8_t *data, size_t length, DiscoveryReport &report);
+
+// A chain map, built up from discovery reports: one entry per unit, in chain order.
+struct ChainUnit {
+    bool reported;          // 'U' received
+    uint8_t version[3];
+    unsigned residenceUs;
+    unsigned bootMs;
+    uint8_t rtc;
+    long hopUs;             // Round trip to the next unit; 0 for the last unit, -1 until reported
+    double delayMs;         // Estimated one-way delay from unit 0: half of each hop above
+                            //   this unit, plus the time each unit above took to pass it on
+};
+
+// Add a report to the map.  Returns true once the map is complete: the last unit, and every
+// unit above it, have sent both reports (delayMs is filled in then).
+bool addDiscoveryReport(std::vector<ChainUnit> &chain, const DiscoveryReport &report);
+
+// Segment video (V<n>).  A frame is one 4-bit intensity (0-15) per segment, in the
+// clock's a5_OSB order: 18 segments per character, rightmost character first.  The clock
+// shows 13 distinct levels: 8 and 9, 11 and 12, and 13 and 14 each share a brightness level.
+// Video messages are variable in length, 13 to 61 bytes:
+//   [0xFF] ['V'] [unit] ['K'] [45 bytes: two segments per byte, low nibble first]
+//   [0xFF] ['V'] [unit] ['D'] [length] [runs: first, count, packed data]
+const size_t kSegmentsPerChar = 18;
+const size_t kFrameSegments = 5 * kSegmentsPerChar;
+const size_t kKeyFrameLength = 4 + kFrameSegments / 2;
+const size_t kMaxDeltaData = 56;
+
+// Frame index of a segment.  "column" is 0-4, left to right; "segment" is 0-17, in the
+// order of the font table bits: A bits 0-7, B bits 0-1, then C bits 0-7.
+size_t frameIndex(int column, int segment);
+
+// Vx K: a complete frame.  Returns false if the unit can't be addressed.
+bool appendKeyFrame(Bytes &out, int unit, const uint8_t frame[kFrameSegments]);
+
+// Vx D: the runs of segments that differ between two frames, or a key frame if that
+// is shorter.  Returns the number of messages appended: 1, or 0 if the frames are
+// the same; -1 if the unit can't be addressed.
+int appendDeltaFrame(Bytes &out, int unit, const uint8_t from[kFrameSegments],
+                     const uint8_t to[kFrameSegments]);
+
+// Flash store (F<n>): pages of the clock's program memory that hold uploaded messages and word
+// sequences (see a5_STORE_PAGES in alphafive.h).  It needs a bootloader that can write flash
+// (MightyCore's Optiboot), and is emptied whenever new firmware is uploaded.  A page is sent in
+// loads, in order, then written; the unit checks it against the CRC before writing:
+//   [0xFF] ['F'] [unit] ['L'] [offset] [length] [data: length bytes, padded to at least 7]
+//   [0xFF] ['F'] [unit] ['W'] [page] [CRC: 2 bytes] [7 bytes]
+//   [0xFF] ['F'] [unit] ['?'] [page] [8 bytes]
+//   [0xFF] ['F'] [unit] ['S'] [type] [index] [7 bytes]      Show a stored message or sequence
+// W and ? reply, upstream through the chain, with
+//   [0xFF] ['f'] ['0'] [W or ?] [page] [status] [bytes loaded: 2] [CRC of the page in flash: 2]
+//   [pages] [page size: 2]
+// The store holds records, [type] [length] [data], ended by a type of 0xFF.  (Older firmware
+// ignores F<n>.)
+const uint8_t kStoreEnd = 0xFF;
+const uint8_t kStoreMessage = 'M';      // Text, scrolled across the display
+const uint8_t kStoreSequence = 'S';     // Words: [5 characters] [tenths of a second], repeated
+const uint8_t kStoreGlyphs = 'G';       // Glyph bank: [first character] [A, B, C], repeated
+const size_t kStoreLoadLength = 32;     // Data per L message; small enough to leave the clock's
+                                        // 64-byte receive buffer room for the next one
+
+enum StoreStatus { kStoreOk = 0, kStoreNone = 1, kStoreNoPage = 2, kStoreBadPage = 3 };
+
+struct StoreReply {
+    uint8_t op;             // 'W' or '?'
+    int page;
+    int status;             // StoreStatus
+    unsigned loaded;        // Bytes loaded into the page buffer (before a write)
+    uint16_t crc;           // Of the page, as now in flash
+    int pages;
+    unsigned pageSize;
+};
+
+// CRC-16/CCITT, as avr-libc's _crc_ccitt_update(), starting from 0xFFFF.
+uint16_t storeCRC(const uint8_t *data, size_t length);
+
+// Add a record to a store image.  Returns false if the data are too long (over 255 bytes).
+bool appendStoreRecord(Bytes &image, uint8_t type, const Bytes &data);
+
+// Add a word to the data of a sequence record.  Returns false if it can't be shown for that long.
+bool appendSequenceWord(Bytes &data, const char word[5], double seconds);
+
+// One page of a store image, padded with kStoreEnd.
+Bytes storePage(const Bytes &image, int page, size_t pageSize);
+
+// L messages for one page of a store image, then W.  Returns false if the unit can't be
+// addressed, or the page size isn't a multiple of kStoreLoadLength.
+bool appendStorePage(Bytes &out, int unit, int page, const Bytes &image, size_t pageSize);
+bool appendGetStorePage(Bytes &out, int unit, int page);
+bool appendShowStored(Bytes &out, int unit, uint8_t type, int index);
+
+// Find a store reply in data received from the clock.  Returns the number of bytes consumed
+// through the end of the reply, or 0 if none was found.
+size_t parseStoreReply(const uint8_t *data, size_t length, StoreReply &reply);
+
+// Glyph banks (C<n>): glyphs (A, B, C, as appendFontChar()) for a run of characters, which
+// replace them in the font until changed.  One message uploads a whole bank:
+//   [0xFF] ['C'] [unit] ['U'] [first] [count] [glyphs: 3 x count bytes, padded to at least 7]
+//   [0xFF] ['C'] [unit] ['G'] [index] [8 bytes]     Use a glyph bank record of the flash store
+//   [0xFF] ['C'] [unit] ['?'] [9 bytes]
+// A count of 0 returns to the built-in font.  Each replies, upstream through the chain, with
+//   [0xFF] ['c'] ['0'] [U, G or ?] [source: 0, 'U' or 'G'] [index] [first] [count] [5 bytes]
+// (Older firmware ignores C<n>.)
+const int kBankGlyphs = 18;             // Most glyphs in an upload
+
+struct Glyph {
+    uint8_t a, b, c;
+};
+
+struct BankReply {
+    uint8_t op;             // 'U', 'G' or '?'
+    uint8_t source;         // 0 (none), 'U' (uploaded) or 'G' (from the store)
+    int index;              // The store record, for 'G'
+    char first;
+    int count;
+};
+
+// Parse a glyph as "A,B,C", e.g. "15,2,79".  Returns false if it isn't one.
+bool parseGlyph(const char *text, Glyph &glyph);
+
+// The data of a glyph bank record of the flash store (kStoreGlyphs).
+Bytes glyphBankRecord(char first, const std::vector<Glyph> &glyphs);
+
+// Returns false if the unit can't be addressed, or there are more than kBankGlyphs glyphs.
+bool appendGlyphBank(Bytes &out, int unit, char first, const std::vector<Glyph> &glyphs);
+bool appendStoredBank(Bytes &out, int unit, int index);
+bool appendGetBank(Bytes &out, int unit);
+
+// Find a glyph bank reply in data received from the clock.  Returns the number of bytes
+// consumed through the end of the reply, or 0 if none was found.
+size_t parseBankReply(const uint8_t *data, size_t length, BankReply &reply);
+
+// Screen readback (R<n>): what a unit is showing, for monitoring from afar.
+//   [0xFF] ['R'] [unit] [op] [9 bytes]     op 'C': summary only; 'F': summary and frame
+// The unit replies, upstream through the chain, with
+//   [0xFF] ['r'] ['0'] [op] [mode] [display setting] [brightness] [brightness mode] [level]
+//   [lit segments] [fading] [CRC: 2 bytes]
+// followed, for 'F', by the frame that it shows, as in a Vx K message.  The CRC is of that
+// frame (as storeCRC()), so a poll with 'C' tells whether the display has changed, in 13 bytes.
+// A frame sent with V<n> reads back as sent, except that 9, 12 and 14 read as 8, 11 and 13,
+// which look the same (see sameOnScreen()).  (Older firmware ignores R<n>.)
+struct ScreenReply {
+    uint8_t op;             // 'C' or 'F'
+    uint8_t mode;           // What the display belongs to: 'C' clock, 'D' date, 'L' alarm time, 'M' menu,
+                            //   'A' text, 'T' LED test, 'V' segment video or 'W' watch
+    int display;            // The display setting (as in get)
+    int brightness;         // The brightness setting, 0-11
+    int brightMode;         // 0-2: low, medium, high; 3: hybrid; 4: overdrive
+    int level;              // Brightness level of the display, 0-19
+    int lit;                // Segments lit
+    bool fading;
+    uint16_t crc;
+    bool frameOk;           // F: the frame arrived, and matches the CRC
+    uint8_t frame[kFrameSegments];  // F: 4-bit intensities, in frameIndex() order
+};
+
+// Whether two intensities of a V<n> frame look the same on the clock, and so read back alike.
+bool sameOnScreen(uint8_t a, uint8_t b);
+
+// Returns false if the unit can't be addressed.
+bool appendGetScreen(Bytes &out, int unit, bool frame);
+
+// Find a screen reply (with its frame, for 'F') in data received from the clock.  Returns the
+// number of bytes consumed through the end of the reply, or 0 if none was found.
+size_t parseScreenReply(const uint8_t *data, size_t length, ScreenReply &reply);
+
+}  // namespace a5
+
+#endif
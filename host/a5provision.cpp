@@ -0,0 +1,162 @@
+/*
+ a5provision.cpp
+
+ Part of the Alpha Five host tools
+
+ Set the time and settings of many clocks at once, each on its own serial port,
+ and report how long each one took to confirm.
+
+ Usage: a5provision [-b baud] [-w milliseconds] [-t | -T [-c units]] [-s SETTINGS] [-g] port ...
+
+   -t             Set the time (ST) to this computer's local time.
+   -T             Set the time to the millisecond (T0), so that the seconds of every clock
+                  roll over together.  Each port's round trip is measured first, with echoes.
+   -c units       Clocks daisy-chained on each port (default 1); -T waits for an ack from each.
+   -s SETTINGS    Apply and save all nine settings (P0), as printed by
+                  "a5send get", e.g. -s "$(a5send get)".
+   -g             Read back the settings (G0).
+   -w ms          Give up on ports that haven't finished after this long (default 3000).
+
+ Exits nonzero unless every port confirmed every step.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+#include "a5fleet.h"
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: a5provision [-b baud] [-w milliseconds] [-t | -T [-c units]] [-s SETTINGS] [-g] port ...\n"
+        "  -t           Set the time to this computer's local time\n"
+        "  -T           Set the time to the millisecond, on every clock in each chain\n"
+        "  -c units     Clocks daisy-chained on each port (default 1)\n"
+        "  -s SETTINGS  Apply and save settings, as printed by a5send get\n"
+        "  -g           Read back settings\n"
+        "  -w ms        Time limit for all ports (default 3000)\n");
+    exit(2);
+}
+
+static void printLatency(const char *name, std::vector<double> ms)
+{
+    if (ms.empty())
+        return;
+    std::sort(ms.begin(), ms.end());
+    printf("%-10s min %7.1f ms  median %7.1f ms  max %7.1f ms\n",
+           name, ms.front(), ms[ms.size() / 2], ms.back());
+}
+
+int main(int argc, char *argv[])
+{
+    a5::FleetJob job;
+    int baud = a5::kDefaultBaud;
+    int timeoutMs = 3000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:w:tTc:s:gh")) != -1) {
+        switch (opt) {
+        case 'b': baud = atoi(optarg); break;
+        case 'w': timeoutMs = atoi(optarg); break;
+        case 't': job.setTime = true; break;
+        case 'T': job.syncTime = true; break;
+        case 'c': job.chainUnits = atoi(optarg); break;
+        case 'g': job.getSettings = true; break;
+        case 's': {
+            std::istringstream text(optarg);
+            std::vector<std::string> fields;
+            std::string field;
+            while (text >> field)
+                fields.push_back(field);
+            if (!a5::parseSettings(fields, job.settings)) {
+                fprintf(stderr, "a5provision: -s needs all nine settings, as NAME=VALUE\n");
+                return 2;
+            }
+            for (int i = 0; i < a5::kSettingsLength; i++) {
+                if (job.settings[i] > a5::kSettingMax[i]) {
+                    fprintf(stderr, "a5provision: %s out of range\n", a5::kSettingNames[i]);
+                    return 2;
+                }
+            }
+            job.putSettings = true;
+            break;
+        }
+        default: usage();
+        }
+    }
+    if ((optind >= argc) || !(job.setTime || job.syncTime || job.putSettings || job.getSettings))
+        usage();
+    if ((job.chainUnits < 1) || (job.chainUnits > a5::kMaxChainUnits)) {
+        fprintf(stderr, "a5provision: -c must be 1-%d\n", a5::kMaxChainUnits);
+        return 2;
+    }
+
+    a5::Fleet fleet;
+    for (int i = optind; i < argc; i++)
+        fleet.add(argv[i], baud);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<a5::FleetResult> results = fleet.run(job, timeoutMs);
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> timeMs, rttMs, syncMs, settingsMs;
+    int failed = 0;
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const a5::FleetResult &r = results[i];
+        printf("%s: %s", r.path.c_str(), r.ok ? "ok" : "FAILED");
+        if (r.timeMs >= 0) {
+            printf("  time %.1f ms", r.timeMs);
+            timeMs.push_back(r.timeMs);
+        }
+        if (r.rttMs >= 0) {
+            printf("  round trip %.1f ms", r.rttMs);
+            rttMs.push_back(r.rttMs);
+        }
+        if (r.syncMs >= 0) {
+            printf("  sync %.1f ms", r.syncMs);
+            syncMs.push_back(r.syncMs);
+        }
+        if (r.settingsMs >= 0) {
+            printf("  settings %.1f ms", r.settingsMs);
+            settingsMs.push_back(r.settingsMs);
+        }
+        if (!r.ok) {
+            printf("  (%s)", r.error.c_str());
+            failed++;
+        }
+        else if (job.getSettings || job.putSettings) {
+            printf("  %s", a5::formatSettings(r.settings).c_str());
+        }
+        printf("\n");
+    }
+
+    printf("%d of %d ports ok, in %.1f ms\n", (int) results.size() - failed, (int) results.size(), totalMs);
+    printLatency("time", timeMs);
+    printLatency("round trip", rttMs);
+    printLatency("sync", syncMs);
+    printLatency("settings", settingsMs);
+    return failed ? 1 : 0;
+}
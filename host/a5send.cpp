@@ -0,0 +1,826 @@
+/*
+ a5send.cpp
+
+ Part of the Alpha Five host tools
+
+ Command-line control of Alpha Clock Five units over the serial interface.
+
+ Usage: a5send [-p port] [-b baud] [-u unit] command [arguments]
+
+   time [seconds]         Set the time (ST). Default: this computer's local time.
+   text TEXT [DP]         Show five characters (A<n>), with optional DP string.
+   bright N               Set brightness, 0-11 (B<n>0).
+   numbers N              Select number style, 0-9 (B<n>1).
+   font C A B C           Redefine font character C (B<n>2).
+   transition EFFECT      How the display changes (B<n>3): fade, wipe, stagger, draw.
+   clock                  Return to time display (MT).
+   get                    Print the unit's stored settings (G<n>), as name=value pairs.
+   put NAME=VALUE ...     Apply and save all nine settings at once (P<n>), e.g., as
+                          printed by "get"; exits nonzero unless the unit confirms them.
+   discover               List the units on the daisy chain (D): firmware version, time
+                          from start-up to first frame, RTC module, and the measured delay
+                          of each hop.  (-u is ignored.)
+   alarms                 List the unit's alarms (L<n>), and when each will next sound.
+   alarm N HH:MM DAYS     Set and save alarm N (0 is the one set with the buttons).
+                          DAYS: daily, weekdays, weekends, never, or a list such as
+                          mon,wed,fri.  Exits nonzero unless the unit confirms it.
+   menu                   List the settings menu (O<n>): each item's value, range and label.
+   menu N VALUE           Set menu item N, as with + and -; exits nonzero unless the unit
+                          confirms it.
+   watch [ACTION]         Stopwatch (W<n>).  ACTION: start, countdown SECONDS, go, hold,
+                          reset, exit; none to report only.  Prints the reading, and the
+                          longest time taken to draw a hundredth.
+   store [RECORD ...]     Replace the contents of the unit's flash store (F<n>) with these
+                          records, or with none to report its size.  RECORD:
+                            message:TEXT                 scrolled across the display
+                            sequence:WORD/SECONDS,...    words shown in turn
+                            glyphs:C:A,B,C/A,B,C/...     a glyph bank, from character C on
+                          Exits nonzero unless every page is written and checked.
+   show TYPE N            Show stored message or sequence N (0 is the first of each type).
+   bank [C A,B,C ...]     Replace the glyphs of character C and those after it (C<n> U), up
+                          to 18, in one message; e.g., "bank 0 15,2,79" for a slashed zero.
+                          "bank none" returns to the built-in font, "bank stored N" uses
+                          glyph bank N of the flash store, and "bank" reports only.
+                          Exits nonzero unless the unit confirms the bank.
+   screen [crc]           Read back what the unit is showing (R<n>): what the display
+                          belongs to, its brightness, the number of segments lit, and the
+                          CRC of its frame; then the frame itself, unless "crc" is given.
+   screen chain N         The same summary for units 0 to N-1 of the daisy chain, one line
+                          each (-u is ignored).  Exits nonzero if any unit doesn't reply,
+                          or has nothing lit.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "a5port.h"
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: a5send [-p port] [-b baud] [-u unit] command [arguments]\n"
+        "  time [seconds]      Set the time (default: local time now)\n"
+        "  text TEXT [DP]      Show five characters, with optional DP string\n"
+        "  bright N            Set brightness, 0-11\n"
+        "  numbers N           Select number style, 0-9\n"
+        "  font C A B C        Redefine font character C\n"
+        "  transition EFFECT   fade, wipe, stagger or draw\n"
+        "  clock               Return to time display\n"
+        "  get                 Print stored settings\n"
+        "  put NAME=VALUE ...  Apply and save all settings, as printed by get\n"
+        "  discover            List the units on the daisy chain, with hop delays\n"
+        "  alarms              List alarms\n"
+        "  alarm N HH:MM DAYS  Set alarm N; DAYS: daily, weekdays, weekends, never, or mon,wed,...\n"
+        "  menu [N VALUE]      List the settings menu, or set item N\n"
+        "  watch [ACTION]      Stopwatch: start, countdown SECONDS, go, hold, reset, exit\n"
+        "  store [RECORD ...]  Replace the flash store: message:, sequence:, glyphs: records\n"
+        "  show TYPE N         Show stored message or sequence N\n"
+        "  bank [C A,B,C ...]  Replace the glyphs from character C on; or none, or stored N\n"
+        "  screen [crc]        Read back what the unit is showing\n"
+        "  screen chain N      Summary of what units 0 to N-1 are showing\n");
+    exit(2);
+}
+
+static void fixedWidth(const char *in, char out[5], char fill)
+{
+    size_t length = strlen(in);
+    for (size_t i = 0; i < 5; i++)
+        out[i] = (i < length) ? in[i] : fill;
+}
+
+static bool readSettingsReply(a5::Port &port, char type, uint8_t settings[a5::kSettingsLength])
+{   // The reply may follow other output from the clock (e.g., startup messages).
+    a5::Bytes received;
+    uint8_t buffer[256];
+
+    for (;;) {
+        ssize_t count = port.read(buffer, sizeof(buffer), 2000);
+        if (count <= 0)
+            return false;
+        received.insert(received.end(), buffer, buffer + count);
+        if (a5::parseSettingsReply(&received[0], received.size(), type, settings))
+            return true;
+    }
+}
+
+static bool readAlarmReply(a5::Port &port, int alarm, a5::AlarmReply &reply)
+{
+    a5::Bytes received;
+    uint8_t buffer[256];
+
+    for (;;) {
+        ssize_t count = port.read(buffer, sizeof(buffer), 2000);
+        if (count <= 0)
+            return false;
+        received.insert(received.end(), buffer, buffer + count);
+
+        size_t used;
+        while ((used = a5::parseAlarmReply(&received[0], received.size(), reply)) > 0) {
+            received.erase(received.begin(), received.begin() + used);
+            if (reply.alarm == alarm)
+                return true;
+        }
+    }
+}
+
+static bool readMenuReply(a5::Port &port, int item, a5::MenuReply &reply)
+{
+    a5::Bytes received;
+    uint8_t buffer[256];
+
+    for (;;) {
+        ssize_t count = port.read(buffer, sizeof(buffer), 2000);
+        if (count <= 0)
+            return false;
+        received.insert(received.end(), buffer, buffer + count);
+
+        size_t used;
+        while ((used = a5::parseMenuReply(&received[0], received.size(), reply)) > 0) {
+            received.erase(received.begin(), received.begin() + used);
+            if (reply.item == item)
+                return true;
+        }
+    }
+}
+
+static void printMenuItem(const a5::MenuReply &reply)
+{
+    if (reply.maximum)
+        printf("menu %2d  %3d of 0-%-3d \"%s\"\n", reply.item, reply.value, reply.maximum, reply.label.c_str());
+    else
+        printf("menu %2d  (action)      \"%s\"\n", reply.item, reply.label.c_str());
+}
+
+static bool readStoreReply(a5::Port &port, int page, a5::StoreReply &reply)
+{   // A page write takes about 8 ms on top of the round trip.
+    a5::Bytes received;
+    uint8_t buffer[256];
+
+    for (;;) {
+        ssize_t count = port.read(buffer, sizeof(buffer), 2000);
+        if (count <= 0)
+            return false;
+        received.insert(received.end(), buffer, buffer + count);
+
+        size_t used;
+        while ((used = a5::parseStoreReply(&received[0], received.size(), reply)) > 0) {
+            received.erase(received.begin(), received.begin() + used);
+            if (reply.page == page)
+                return true;
+        }
+    }
+}
+
+static bool readBankReply(a5::Port &port, uint8_t op, a5::BankReply &reply)
+{
+    a5::Bytes received;
+    uint8_t buffer[256];
+
+    for (;;) {
+        ssize_t count = port.read(buffer, sizeof(buffer), 2000);
+        if (count <= 0)
+            return false;
+        received.insert(received.end(), buffer, buffer + count);
+
+        size_t used;
+        while ((used = a5::parseBankReply(&received[0], received.size(), reply)) > 0) {
+            received.erase(received.begin(), received.begin() + used);
+            if (reply.op == op)
+                return true;
+        }
+    }
+}
+
+static void printBank(const a5::BankReply &reply)
+{
+    if (reply.source == 0)
+        printf("bank: none (built-in font)\n");
+    else if (reply.count == 1)
+        printf("bank: %s, '%c'\n", (reply.source == 'G') ? "stored" : "uploaded", reply.first);
+    else
+        printf("bank: %s, '%c' to '%c'\n", (reply.source == 'G') ? "stored" : "uploaded",
+               reply.first, reply.first + reply.count - 1);
+    if (reply.source == 'G')
+        printf("  (store record %d)\n", reply.index);
+}
+
+static bool readScreenReply(a5::Port &port, a5::ScreenReply &reply)
+{
+    a5::Bytes received;
+    uint8_t buffer[256];
+
+    for (;;) {
+        ssize_t count = port.read(buffer, sizeof(buffer), 2000);
+        if (count <= 0)
+            return false;
+        received.insert(received.end(), buffer, buffer + count);
+        if (a5::parseScreenReply(&received[0], received.size(), reply))
+            return true;
+    }
+}
+
+static const char *screenModeName(uint8_t mode)
+{   // As reported by R<n>
+    switch (mode) {
+    case 'C': return "clock";
+    case 'D': return "date";
+    case 'L': return "alarm time";
+    case 'M': return "menu";
+    case 'A': return "text";
+    case 'T': return "LED test";
+    case 'V': return "video";
+    case 'W': return "watch";
+    default: return "?";
+    }
+}
+
+static void printScreen(int unit, const a5::ScreenReply &reply)
+{
+    printf("%4d  %-10s  %6d  %4d  %5d  %3d  %04x%s\n", unit, screenModeName(reply.mode), reply.brightness,
+           reply.brightMode, reply.level, reply.lit, reply.crc, reply.fading ? "  (fading)" : "");
+}
+
+static void printFrame(const a5::ScreenReply &reply)
+{   // One row per character, left to right; each segment's intensity in hex, in font bit order.
+    printf("char  A0-7     B0-1  C0-7\n");
+    for (int column = 0; column < 5; column++) {
+        printf("%4d  ", column);
+        for (int segment = 0; segment < (int) a5::kSegmentsPerChar; segment++) {
+            if ((segment == 8) || (segment == 10))
+                printf(" ");
+            printf("%x", reply.frame[a5::frameIndex(column, segment)]);
+        }
+        printf("\n");
+    }
+}
+
+static bool parseGlyphs(const std::string &text, char separator, std::vector<a5::Glyph> &glyphs)
+{   // A,B,C, then more, each after the separator.
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find(separator, start);
+        if (end == std::string::npos)
+            end = text.size();
+        a5::Glyph glyph;
+        if (!a5::parseGlyph(text.substr(start, end - start).c_str(), glyph))
+            return false;
+        glyphs.push_back(glyph);
+        start = end + 1;
+    }
+    return !glyphs.empty();
+}
+
+static bool parseStoreRecord(const char *text, a5::Bytes &image)
+{   // message:TEXT, sequence:WORD/SECONDS,WORD/SECONDS,... or glyphs:C:A,B,C/A,B,C/...
+    a5::Bytes data;
+
+    if (!strncmp(text, "message:", 8)) {
+        data.assign(text + 8, text + strlen(text));
+        return a5::appendStoreRecord(image, a5::kStoreMessage, data);
+    }
+    if (!strncmp(text, "glyphs:", 7)) {
+        std::vector<a5::Glyph> glyphs;
+        if ((strlen(text) < 10) || (text[8] != ':') || !parseGlyphs(text + 9, '/', glyphs))
+            return false;
+        return a5::appendStoreRecord(image, a5::kStoreGlyphs, a5::glyphBankRecord(text[7], glyphs));
+    }
+    if (strncmp(text, "sequence:", 9))
+        return false;
+
+    std::string words(text + 9);
+    size_t start = 0;
+    while (start < words.size()) {
+        size_t end = words.find(',', start);
+        if (end == std::string::npos)
+            end = words.size();
+        std::string item = words.substr(start, end - start);
+        size_t slash = item.rfind('/');
+        char word[5];
+        if (slash == std::string::npos)
+            return false;
+        fixedWidth(item.substr(0, slash).c_str(), word, ' ');
+        if (!a5::appendSequenceWord(data, word, atof(item.c_str() + slash + 1)))
+            return false;
+        start = end + 1;
+    }
+    return !data.empty() && a5::appendStoreRecord(image, a5::kStoreSequence, data);
+}
+
+static int writeStore(a5::Port &port, int unit, const a5::StoreReply &info, const a5::Bytes &image)
+{
+    size_t pages = (image.size() + info.pageSize - 1) / info.pageSize;
+    if (pages > (size_t) info.pages) {
+        fprintf(stderr, "a5send: %d bytes; unit %d stores only %d\n", (int) image.size(), unit,
+                info.pages * info.pageSize);
+        return 1;
+    }
+
+    for (size_t page = 0; page < pages; page++) {
+        a5::Bytes message;
+        a5::StoreReply written;
+        if (!a5::appendStorePage(message, unit, page, image, info.pageSize)) {
+            fprintf(stderr, "a5send: unit %d has an unexpected page size, %u\n", unit, info.pageSize);
+            return 1;
+        }
+        port.send(message);
+        if (!readStoreReply(port, page, written)) {
+            fprintf(stderr, "a5send: no reply from unit %d\n", unit);
+            return 1;
+        }
+        if (written.status != a5::kStoreOk) {
+            static const char *const problems[] = { "", "its bootloader can't write flash", "no such page",
+                                                    "the page arrived incomplete or damaged" };
+            fprintf(stderr, "a5send: unit %d did not write page %d: %s\n", unit, (int) page,
+                    (written.status <= a5::kStoreBadPage) ? problems[written.status] : "unknown error");
+            return 1;
+        }
+        a5::Bytes data = a5::storePage(image, page, info.pageSize);
+        if (written.crc != a5::storeCRC(&data[0], data.size())) {
+            fprintf(stderr, "a5send: unit %d: page %d doesn't read back as written\n", unit, (int) page);
+            return 1;
+        }
+    }
+    printf("%d bytes, %d of %d pages written\n", (int) image.size(), (int) pages, info.pages);
+    return 0;
+}
+
+static void printAlarm(const a5::AlarmReply &reply)
+{
+    printf("alarm %d  %02d:%02d  %-24s", reply.alarm, reply.hour, reply.minute,
+           a5::formatAlarmDays(reply.days).c_str());
+    if (reply.nextTime) {
+        time_t next = reply.nextTime;      // The clock's local time, so no time zone to apply
+        struct tm when;
+        char text[32];
+        gmtime_r(&next, &when);
+        strftime(text, sizeof(text), "%a %Y-%m-%d %H:%M", &when);
+        printf("  next %s", text);
+    }
+    printf("\n");
+}
+
+static bool readWatchReply(a5::Port &port, a5::WatchReply &reply)
+{
+    a5::Bytes received;
+    uint8_t buffer[256];
+
+    for (;;) {
+        ssize_t count = port.read(buffer, sizeof(buffer), 2000);
+        if (count <= 0)
+            return false;
+        received.insert(received.end(), buffer, buffer + count);
+        if (a5::parseWatchReply(&received[0], received.size(), reply))
+            return true;
+    }
+}
+
+static void printWatch(const a5::WatchReply &reply)
+{
+    if (reply.mode == 0) {
+        printf("clock");
+    }
+    else {
+        printf("%s %s  %u:%02u.%02u", (tolower(reply.mode) == 'c') ? "countdown" : "stopwatch",
+               isupper(reply.mode) ? "running" : "stopped", reply.reading / 6000,
+               (reply.reading / 100) % 60, reply.reading % 100);
+    }
+    printf("  frames %u  longest %u us  missed %u\n", reply.frames, reply.longestUs, reply.missed);
+}
+
+static bool readChainMap(a5::Port &port, std::vector<a5::ChainUnit> &chain)
+{   // Until every unit has reported, or the chain goes quiet.
+    a5::Bytes received;
+    uint8_t buffer[256];
+
+    for (;;) {
+        ssize_t count = port.read(buffer, sizeof(buffer), 2000);
+        if (count <= 0)
+            return false;
+        received.insert(received.end(), buffer, buffer + count);
+
+        a5::DiscoveryReport report;
+        size_t used;
+        while ((used = a5::parseDiscoveryReport(&received[0], received.size(), report)) > 0) {
+            received.erase(received.begin(), received.begin() + used);
+            if (a5::addDiscoveryReport(chain, report))
+                return true;
+        }
+    }
+}
+
+static const char *rtcNames(uint8_t rtc)
+{   // As reported by discovery
+    switch (rtc) {
+    case 'R': return "in use";
+    case 'N': return "none";
+    case 'B': return "bus!";
+    case 'S': return "not set";
+    default: return "?";
+    }
+}
+
+static int printChainMap(const std::vector<a5::ChainUnit> &chain, bool complete)
+{
+    printf("unit  firmware  pass-on   boot  RTC      hop round trip  delay from unit 0\n");
+    for (size_t i = 0; i < chain.size(); i++) {
+        const a5::ChainUnit &u = chain[i];
+        if (!u.reported) {
+            printf("%4d  (no report)\n", (int) i);
+            continue;
+        }
+        printf("%4d  %d.%d.%-4d  %5u us", (int) i, u.version[0], u.version[1], u.version[2], u.residenceUs);
+        if (u.bootMs)
+            printf("  %3u ms", u.bootMs);
+        else
+            printf("  %6s", "?");
+        printf("  %-7s", rtcNames(u.rtc));
+        if (u.hopUs > 0)
+            printf("  %9.2f ms", u.hopUs / 1000.0);
+        else
+            printf("  %12s", (u.hopUs == 0) ? "(last)" : "?");
+        if (complete)
+            printf("  %10.2f ms", u.delayMs);
+        printf("\n");
+    }
+    if (!complete) {
+        fprintf(stderr, "a5send: not every unit reported; units after the first gap may not have the D command\n");
+        return 1;
+    }
+    printf("%d units\n", (int) chain.size());
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string path = "/dev/ttyUSB0";
+    int baud = a5::kDefaultBaud;
+    int unit = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:b:u:h")) != -1) {
+        switch (opt) {
+        case 'p': path = optarg; break;
+        case 'b': baud = atoi(optarg); break;
+        case 'u': unit = atoi(optarg); break;
+        default: usage();
+        }
+    }
+    if (optind >= argc)
+        usage();
+
+    std::string command = argv[optind];
+    int nargs = argc - optind - 1;
+    char **args = argv + optind + 1;
+    a5::Bytes message;
+    uint8_t settings[a5::kSettingsLength];
+    a5::AlarmReply alarm;
+    a5::MenuReply menu;
+    a5::Bytes image;
+    std::vector<a5::Glyph> glyphs;
+    char reply = 0;
+    int chainUnits = 0;
+    bool ok = true;
+
+    if ((command == "time") && (nargs <= 1)) {
+        a5::appendSetTime(message, nargs ? (uint32_t) strtoul(args[0], NULL, 10) : a5::localTimeNow());
+    }
+    else if ((command == "text") && (nargs >= 1) && (nargs <= 2)) {
+        char text[5], dp[5];
+        fixedWidth(args[0], text, ' ');
+        fixedWidth(nargs > 1 ? args[1] : "", dp, ' ');
+        ok = a5::appendText(message, unit, text, dp);
+    }
+    else if ((command == "bright") && (nargs == 1)) {
+        ok = a5::appendBrightness(message, unit, atoi(args[0]));
+    }
+    else if ((command == "numbers") && (nargs == 1)) {
+        ok = a5::appendNumberSet(message, unit, atoi(args[0]));
+    }
+    else if ((command == "font") && (nargs == 4) && (strlen(args[0]) == 1)) {
+        ok = a5::appendFontChar(message, unit, args[0][0], atoi(args[1]), atoi(args[2]), atoi(args[3]));
+    }
+    else if ((command == "transition") && (nargs == 1)) {
+        int effect = 0;
+        while ((effect < a5::kTransitions) && strcmp(args[0], a5::kTransitionNames[effect]))
+            effect++;
+        ok = a5::appendTransition(message, unit, effect);
+    }
+    else if ((command == "clock") && (nargs == 0)) {
+        a5::appendModeTime(message);
+    }
+    else if ((command == "get") && (nargs == 0)) {
+        ok = a5::appendGetSettings(message, unit);
+        reply = 'g';
+    }
+    else if ((command == "discover") && (nargs == 0)) {
+        a5::appendDiscover(message, 1);
+        reply = 'd';
+    }
+    else if ((command == "alarms") && (nargs == 0)) {
+        alarm.alarm = 0;
+        ok = a5::appendGetAlarm(message, unit, 0);
+        reply = 'l';
+    }
+    else if ((command == "alarm") && (nargs == 3)) {
+        if ((sscanf(args[1], "%d:%d", &alarm.hour, &alarm.minute) != 2) || !a5::parseAlarmDays(args[2], alarm.days))
+            usage();
+        alarm.alarm = atoi(args[0]);
+        ok = a5::appendSetAlarm(message, unit, alarm.alarm, alarm.days, alarm.hour, alarm.minute);
+        reply = 'L';
+    }
+    else if ((command == "watch") && (nargs <= 2)) {
+        static const char *const actions[] = { "start", "countdown", "go", "hold", "reset", "exit" };
+        char action = '?';
+        uint32_t hundredths = 0;
+        if (nargs) {
+            size_t i = 0;
+            while ((i < 6) && strcmp(args[0], actions[i]))
+                i++;
+            if ((i == 6) || ((i == 1) != (nargs == 2)))
+                usage();
+            action = "SCGHRX"[i];
+            if (nargs == 2)
+                hundredths = (uint32_t) (100 * atof(args[1]) + 0.5);
+        }
+        ok = a5::appendWatch(message, unit, action, hundredths);
+        reply = 'w';
+    }
+    else if ((command == "menu") && (nargs == 0)) {
+        menu.item = 0;
+        ok = a5::appendGetMenuItem(message, unit, 0);
+        reply = 'o';
+    }
+    else if ((command == "menu") && (nargs == 2)) {
+        menu.item = atoi(args[0]);
+        menu.value = atoi(args[1]);
+        ok = a5::appendSetMenuItem(message, unit, menu.item, menu.value);
+        reply = 'O';
+    }
+    else if (command == "store") {
+        for (int i = 0; i < nargs; i++) {
+            if (!parseStoreRecord(args[i], image)) {
+                fprintf(stderr, "a5send: bad record \"%s\" (too long, or not message:TEXT, "
+                        "sequence:WORD/SECONDS,... or glyphs:C:A,B,C/...)\n", args[i]);
+                return 2;
+            }
+        }
+        image.push_back(a5::kStoreEnd);
+        ok = a5::appendGetStorePage(message, unit, 0);
+        reply = 'f';
+    }
+    else if ((command == "show") && (nargs == 2)) {
+        uint8_t type = !strcmp(args[0], "message") ? a5::kStoreMessage : a5::kStoreSequence;
+        if (strcmp(args[0], "message") && strcmp(args[0], "sequence"))
+            usage();
+        ok = a5::appendShowStored(message, unit, type, atoi(args[1]));
+    }
+    else if ((command == "bank") && (nargs == 0)) {
+        ok = a5::appendGetBank(message, unit);
+        reply = 'c';
+    }
+    else if ((command == "bank") && (nargs == 1) && !strcmp(args[0], "none")) {
+        ok = a5::appendGlyphBank(message, unit, ' ', glyphs);
+        reply = 'c';
+    }
+    else if ((command == "bank") && (nargs == 2) && !strcmp(args[0], "stored")) {
+        ok = a5::appendStoredBank(message, unit, atoi(args[1]));
+        reply = 'c';
+    }
+    else if ((command == "bank") && (strlen(args[0]) == 1)) {
+        for (int i = 1; i < nargs; i++) {
+            if (!parseGlyphs(args[i], ' ', glyphs)) {
+                fprintf(stderr, "a5send: bad glyph \"%s\" (not A,B,C)\n", args[i]);
+                return 2;
+            }
+        }
+        if (glyphs.empty())
+            usage();
+        ok = a5::appendGlyphBank(message, unit, args[0][0], glyphs);
+        reply = 'c';
+    }
+    else if ((command == "screen") && ((nargs == 0) || ((nargs == 1) && !strcmp(args[0], "crc")))) {
+        ok = a5::appendGetScreen(message, unit, nargs == 0);
+        reply = 'r';
+    }
+    else if ((command == "screen") && (nargs == 2) && !strcmp(args[0], "chain")) {
+        chainUnits = atoi(args[1]);
+        if ((chainUnits < 1) || (chainUnits > a5::kMaxChainUnits))
+            usage();
+        unit = 0;
+        ok = a5::appendGetScreen(message, unit, false);
+        reply = 'r';
+    }
+    else if (command == "put") {
+        if (!a5::parseSettings(std::vector<std::string>(args, args + nargs), settings))
+            usage();
+        ok = a5::appendPutSettings(message, unit, settings);
+        reply = 'p';
+    }
+    else {
+        usage();
+    }
+
+    if (!ok) {
+        fprintf(stderr, "a5send: value or unit out of range\n");
+        return 1;
+    }
+
+    a5::Port port;
+    if (!port.open(path, baud)) {
+        fprintf(stderr, "a5send: %s\n", port.error().c_str());
+        return 1;
+    }
+    port.send(message);
+    port.drain();
+    if (reply == 0)
+        return 0;
+
+    if (reply == 'd') {
+        std::vector<a5::ChainUnit> chain;
+        bool complete = readChainMap(port, chain);
+        if (chain.empty()) {
+            fprintf(stderr, "a5send: no reply from unit 0\n");
+            return 1;
+        }
+        return printChainMap(chain, complete);
+    }
+
+    if (reply == 'r') {
+        a5::ScreenReply screen;
+        int problems = 0;
+        printf("unit  mode        bright  mode  level  lit  CRC\n");
+        for (int i = 0; i < (chainUnits ? chainUnits : 1); i++) {
+            if (i > 0) {
+                unit = i;
+                message.clear();
+                a5::appendGetScreen(message, unit, false);
+                port.send(message);
+            }
+            if (!readScreenReply(port, screen)) {
+                printf("%4d  (no reply)\n", unit);
+                problems++;
+                continue;
+            }
+            printScreen(unit, screen);
+            if (chainUnits && (screen.lit == 0)) {
+                fprintf(stderr, "a5send: unit %d is blank\n", unit);
+                problems++;
+            }
+        }
+        if (chainUnits || (screen.op != 'F') || problems)
+            return problems ? 1 : 0;
+        if (!screen.frameOk) {
+            fprintf(stderr, "a5send: the frame from unit %d doesn't match its CRC\n", unit);
+            return 1;
+        }
+        printFrame(screen);
+        return 0;
+    }
+
+    if (reply == 'w') {
+        a5::WatchReply watch;
+        if (!readWatchReply(port, watch)) {
+            fprintf(stderr, "a5send: no reply from unit %d\n", unit);
+            return 1;
+        }
+        printWatch(watch);
+        return 0;
+    }
+
+    if ((reply == 'o') || (reply == 'O')) {
+        a5::MenuReply applied;
+        if (!readMenuReply(port, menu.item, applied)) {
+            fprintf(stderr, "a5send: no reply from unit %d\n", unit);
+            return 1;
+        }
+        if (applied.item >= applied.count) {
+            fprintf(stderr, "a5send: unit %d has only %d menu items\n", unit, applied.count);
+            return 1;
+        }
+        printMenuItem(applied);
+
+        if (reply == 'O') {
+            if ((applied.maximum == 0) || (applied.value != menu.value)) {
+                fprintf(stderr, "a5send: unit %d did not accept the setting\n", unit);
+                return 1;
+            }
+            return 0;
+        }
+        for (int i = 1; i < applied.count; i++) {
+            a5::MenuReply next;
+            message.clear();
+            a5::appendGetMenuItem(message, unit, i);
+            port.send(message);
+            if (!readMenuReply(port, i, next)) {
+                fprintf(stderr, "a5send: no reply from unit %d\n", unit);
+                return 1;
+            }
+            printMenuItem(next);
+        }
+        return 0;
+    }
+
+    if (reply == 'c') {
+        a5::BankReply bank;
+        if (!readBankReply(port, message[3], bank)) {
+            fprintf(stderr, "a5send: no reply from unit %d\n", unit);
+            return 1;
+        }
+        printBank(bank);
+        if ((message[3] == 'U') && (bank.count != (int) glyphs.size())) {
+            fprintf(stderr, "a5send: unit %d did not accept the bank\n", unit);
+            return 1;
+        }
+        if ((message[3] == 'G') && (bank.source != 'G')) {
+            fprintf(stderr, "a5send: unit %d has no glyph bank %s in its flash store\n", unit, args[1]);
+            return 1;
+        }
+        return 0;
+    }
+
+    if (reply == 'f') {
+        a5::StoreReply info;
+        if (!readStoreReply(port, 0, info)) {
+            fprintf(stderr, "a5send: no reply from unit %d\n", unit);
+            return 1;
+        }
+        if (info.status == a5::kStoreNone) {
+            fprintf(stderr, "a5send: unit %d has no flash store (built without a5_FLASH_STORE, or its bootloader can't write flash)\n", unit);
+            return 1;
+        }
+        if (nargs == 0) {
+            printf("%d pages of %u bytes\n", info.pages, info.pageSize);
+            return 0;
+        }
+        return writeStore(port, unit, info, image);
+    }
+
+    if ((reply == 'l') || (reply == 'L')) {
+        a5::AlarmReply applied;
+        if (!readAlarmReply(port, alarm.alarm, applied)) {
+            fprintf(stderr, "a5send: no reply from unit %d\n", unit);
+            return 1;
+        }
+        if (applied.alarm >= applied.count) {
+            fprintf(stderr, "a5send: unit %d has only %d alarms\n", unit, applied.count);
+            return 1;
+        }
+        printAlarm(applied);
+
+        if (reply == 'L') {
+            if ((applied.days != alarm.days) || (applied.hour != alarm.hour) || (applied.minute != alarm.minute)) {
+                fprintf(stderr, "a5send: unit %d did not accept the alarm\n", unit);
+                return 1;
+            }
+            return 0;
+        }
+        for (int i = 1; i < applied.count; i++) {
+            a5::AlarmReply next;
+            message.clear();
+            a5::appendGetAlarm(message, unit, i);
+            port.send(message);
+            if (!readAlarmReply(port, i, next)) {
+                fprintf(stderr, "a5send: no reply from unit %d\n", unit);
+                return 1;
+            }
+            printAlarm(next);
+        }
+        return 0;
+    }
+
+    uint8_t applied[a5::kSettingsLength];
+    if (!readSettingsReply(port, reply, applied)) {
+        fprintf(stderr, "a5send: no reply from unit %d\n", unit);
+        return 1;
+    }
+    printf("%s\n", a5::formatSettings(applied).c_str());
+
+    if ((reply == 'p') && (memcmp(settings, applied, sizeof(applied)) != 0)) {
+        fprintf(stderr, "a5send: unit %d did not accept the settings\n", unit);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""
+ a5trace.py
+
+ Part of the Alpha Five host tools
+
+ Serial-to-photon latency histograms, from the clock's latency trace (Q<n>).
+ The firmware must be built with a5_TRACE_LATENCY defined in alphafive.h.
+
+ Usage: a5trace.py [-b baud] [-u unit] [-n dumps] [-i seconds] port
+
+ Each dump returns (and clears) the stage times of the last 16 commands that the
+ clock received, and the worst stalls of its main loop since the last dump; run
+ your signage software alongside, and take as many dumps as needed for the
+ histograms to fill in.  The stages:
+
+   rx buffer   received -> parsed     Waiting in the serial receive buffer
+   render      parsed -> rendered     The command, UpdateDisplay() and the first load
+   fade        rendered -> faded      The rest of the fade
+   frame wait  faded -> latched       Until the refresh interrupt latches the new frame
+   total       received -> latched
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+"""
+
+import argparse
+import os
+import select
+import sys
+import termios
+import time
+
+HEADER = 255
+MESSAGE_LENGTH = 13
+TICK_MS = 0.016            # Stage times are in units of 16 us
+NOT_REACHED = 0xFFFF
+STALL_INDEX = 0xFF         # The index of the last message of a dump: the loop's worst stalls
+
+STAGES = [("rx buffer", None, 0), ("render", 0, 1), ("fade", 1, 2),
+          ("frame wait", 2, 3), ("total", None, 3)]
+
+BUCKETS_MS = [0.1, 0.2, 0.5, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000]
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = 0                                        # iflag: raw
+    attrs[1] = 0                                        # oflag
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attrs[3] = 0                                        # lflag
+    speed = getattr(termios, "B%d" % baud)
+    attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIFLUSH)
+    return fd
+
+
+def unit_address(unit):
+    # As a5::unitAddress(): ASCII digits for 0-9, binary relay counts for 10-47.
+    if 0 <= unit <= 9:
+        return ord('0') + unit
+    if 10 <= unit < 48:
+        return unit
+    raise ValueError("unit must be 0-47")
+
+
+def dump(fd, unit, timeout=2.0):
+    """Send Q<n>; return the list of (command, [4 stage times]) it reports, and
+    its stalls: (serial output ms, whole pass ms, telemetry lines dropped)."""
+    os.write(fd, bytes([HEADER, ord('Q'), unit_address(unit)]) + b"_" * 10)
+
+    received = b""
+    entries = {}
+    count = None
+    stalls = None
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        ready, _, _ = select.select([fd], [], [], max(0, deadline - time.time()))
+        if not ready:
+            break
+        received += os.read(fd, 512)
+
+        while True:
+            start = received.find(bytes([HEADER, ord('q')]))
+            if (start < 0) or (len(received) - start < MESSAGE_LENGTH):
+                break
+            m = received[start:start + MESSAGE_LENGTH]
+            received = received[start + MESSAGE_LENGTH:]
+            count = m[2]
+            if m[3] == STALL_INDEX:
+                stalls = ((m[5] | (m[6] << 8)) * TICK_MS, (m[7] | (m[8] << 8)) * TICK_MS, m[9])
+            elif count:
+                times = [m[5 + 2 * j] | (m[6 + 2 * j] << 8) for j in range(4)]
+                entries[m[3]] = (chr(m[4]) if 32 <= m[4] < 127 else "?", times)
+
+        if (stalls is not None) and (len(entries) >= count):
+            return [entries[i] for i in sorted(entries)], stalls
+    if count is None:
+        raise RuntimeError("no reply (is the firmware built with a5_TRACE_LATENCY?)")
+    return [entries[i] for i in sorted(entries)], stalls
+
+
+def stage_ms(times, first, last):
+    if times[last] == NOT_REACHED:
+        return None
+    if first is None:
+        return times[last] * TICK_MS
+    if times[first] == NOT_REACHED:
+        return None
+    return (times[last] - times[first]) * TICK_MS
+
+
+def histogram(name, values):
+    print("%s: %d commands" % (name, len(values)))
+    if not values:
+        return
+    values = sorted(values)
+    print("  min %.2f ms, median %.2f ms, 90%% %.2f ms, max %.2f ms" %
+          (values[0], values[len(values) // 2], values[(9 * len(values)) // 10], values[-1]))
+    counts = [0] * (len(BUCKETS_MS) + 1)
+    for v in values:
+        b = 0
+        while (b < len(BUCKETS_MS)) and (v >= BUCKETS_MS[b]):
+            b += 1
+        counts[b] += 1
+    widest = max(counts)
+    lower = 0
+    for b, c in enumerate(counts):
+        label = ("< %g ms" % BUCKETS_MS[b]) if b < len(BUCKETS_MS) else (">= %g ms" % lower)
+        if c:
+            print("  %-12s %5d  %s" % (label, c, "#" * max(1, (40 * c) // widest)))
+        if b < len(BUCKETS_MS):
+            lower = BUCKETS_MS[b]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serial-to-photon latency histograms (Q<n>).")
+    parser.add_argument("port")
+    parser.add_argument("-b", "--baud", type=int, default=19200)
+    parser.add_argument("-u", "--unit", type=int, default=0)
+    parser.add_argument("-n", "--dumps", type=int, default=1)
+    parser.add_argument("-i", "--interval", type=float, default=1.0, help="seconds between dumps")
+    args = parser.parse_args()
+
+    fd = open_port(args.port, args.baud)
+    entries = []
+    worst = [0, 0]
+    dropped = None
+    try:
+        for i in range(args.dumps):
+            if i:
+                time.sleep(args.interval)
+            traced, stalls = dump(fd, args.unit)
+            entries += [e for e in traced if e[0] != 'Q']
+            if stalls is not None:
+                worst = [max(worst[0], stalls[0]), max(worst[1], stalls[1])]
+                dropped = stalls[2]
+    except RuntimeError as error:
+        sys.exit("a5trace: %s" % error)
+    finally:
+        os.close(fd)
+
+    commands = {}
+    for command, _ in entries:
+        commands[command] = commands.get(command, 0) + 1
+    print("%d commands traced: %s" % (len(entries),
+          ", ".join("%s x%d" % (c, n) for c, n in sorted(commands.items()))))
+    for name, first, last in STAGES:
+        histogram(name, [v for v in (stage_ms(t, first, last) for _, t in entries) if v is not None])
+    if dropped is not None:
+        print("worst loop pass: %.2f ms, of which serial output %.2f ms; %d telemetry lines dropped" %
+              (worst[1], worst[0], dropped))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,212 @@
+/*
+ a5wall.cpp
+
+ Part of the Alpha Five host tools
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <string.h>
+
+#include "a5wall.h"
+
+namespace a5 {
+
+static char cleanChar(char c)
+{   // Stay inside the printable range of the clock's font table.
+    if (((uint8_t) c < ' ') || ((uint8_t) c > kLastFontChar))
+        return ' ';
+    return c;
+}
+
+static char cleanDP(char dp)
+{   // Normalize so that "no DP" compares equal however it was written.
+    if ((dp == '1') || (dp == '2') || (dp == '3'))
+        return dp;
+    return ' ';
+}
+
+
+Wall::Wall(int units)
+{
+    if (units < 1)
+        units = 1;
+    if (units > kMaxChainUnits)
+        units = kMaxChainUnits;
+    units_ = units;
+
+    text_.assign(width(), ' ');
+    dp_.assign(width(), ' ');
+    sentText_.assign(width(), ' ');
+    sentDp_.assign(width(), ' ');
+    known_.assign(units_, false);
+}
+
+void Wall::clear()
+{
+    text_.assign(width(), ' ');
+    dp_.assign(width(), ' ');
+}
+
+void Wall::setChar(int column, char c)
+{
+    if ((column >= 0) && (column < width()))
+        text_[column] = cleanChar(c);
+}
+
+void Wall::setDP(int column, char dp)
+{
+    if ((column >= 0) && (column < width()))
+        dp_[column] = cleanDP(dp);
+}
+
+void Wall::print(int column, const std::string &text)
+{
+    for (size_t i = 0; i < text.size(); i++)
+        setChar(column + (int) i, text[i]);
+}
+
+void Wall::printDP(int column, const std::string &dp)
+{
+    for (size_t i = 0; i < dp.size(); i++)
+        setDP(column + (int) i, dp[i]);
+}
+
+char Wall::charAt(int column) const
+{
+    if ((column >= 0) && (column < width()))
+        return text_[column];
+    return ' ';
+}
+
+char Wall::dpAt(int column) const
+{
+    if ((column >= 0) && (column < width()))
+        return dp_[column];
+    return ' ';
+}
+
+bool Wall::dirty(int unit) const
+{
+    if ((unit < 0) || (unit >= units_))
+        return false;
+    if (!known_[unit])
+        return true;
+
+    size_t first = 5 * unit;
+    return memcmp(&text_[first], &sentText_[first], 5) ||
+           memcmp(&dp_[first], &sentDp_[first], 5);
+}
+
+void Wall::invalidate()
+{
+    known_.assign(units_, false);
+}
+
+size_t Wall::flush(Bytes &out)
+{
+    size_t count = 0;
+
+    for (int unit = units_ - 1; unit >= 0; unit--) {
+        if (!dirty(unit))
+            continue;
+
+        size_t first = 5 * unit;
+        appendText(out, unit, &text_[first], &dp_[first]);
+        memcpy(&sentText_[first], &text_[first], 5);
+        memcpy(&sentDp_[first], &dp_[first], 5);
+        known_[unit] = true;
+        count++;
+    }
+    return count;
+}
+
+
+VideoWall::VideoWall(int units)
+{
+    if (units < 1)
+        units = 1;
+    if (units > kMaxChainUnits)
+        units = kMaxChainUnits;
+    units_ = units;
+
+    frames_.assign(kFrameSegments * units_, 0);
+    sent_.assign(kFrameSegments * units_, 0);
+    known_.assign(units_, false);
+}
+
+void VideoWall::clear()
+{
+    frames_.assign(kFrameSegments * units_, 0);
+}
+
+void VideoWall::setSegment(int column, int segment, int level)
+{
+    if ((column < 0) || (column >= width()) || (segment < 0) || (segment >= (int) kSegmentsPerChar))
+        return;
+    if (level < 0)
+        level = 0;
+    if (level > 15)
+        level = 15;
+    frames_[kFrameSegments * (column / 5) + frameIndex(column % 5, segment)] = (uint8_t) level;
+}
+
+int VideoWall::segmentAt(int column, int segment) const
+{
+    if ((column < 0) || (column >= width()) || (segment < 0) || (segment >= (int) kSegmentsPerChar))
+        return 0;
+    return frames_[kFrameSegments * (column / 5) + frameIndex(column % 5, segment)];
+}
+
+bool VideoWall::dirty(int unit) const
+{
+    if ((unit < 0) || (unit >= units_))
+        return false;
+    if (!known_[unit])
+        return true;
+
+    size_t first = kFrameSegments * unit;
+    return memcmp(&frames_[first], &sent_[first], kFrameSegments) != 0;
+}
+
+void VideoWall::invalidate()
+{
+    known_.assign(units_, false);
+}
+
+size_t VideoWall::flush(Bytes &out)
+{
+    size_t count = 0;
+
+    for (int unit = units_ - 1; unit >= 0; unit--) {
+        if (!dirty(unit))
+            continue;
+
+        size_t first = kFrameSegments * unit;
+        if (known_[unit])
+            appendDeltaFrame(out, unit, &sent_[first], &frames_[first]);
+        else
+            appendKeyFrame(out, unit, &frames_[first]);
+        memcpy(&sent_[first], &frames_[first], kFrameSegments);
+        known_[unit] = true;
+        count++;
+    }
+    return count;
+}
+
+}  // namespace a5
@@ -0,0 +1,115 @@
+/*
+ a5wall.h
+
+ Part of the Alpha Five host tools
+
+ A virtual framebuffer for a daisy chain of Alpha Clock Five units.
+
+ The chain is treated as one display, 5 * N characters wide, with unit 0 (the
+ clock on the host's serial port) on the left.  Draw into the wall, then call
+ flush() once per frame: only units whose contents have changed since the last
+ flush are re-sent, one A<n> message each.
+
+ At 19200 baud each 13-byte message takes about 6.8 ms on the wire, so a frame
+ in which only a few units change is many times faster than resending the chain.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef a5wall_h
+#define a5wall_h
+
+#include <string>
+#include <vector>
+
+#include "a5proto.h"
+
+namespace a5 {
+
+class Wall {
+public:
+    // "units" is clamped to the range 1 - kMaxChainUnits.
+    explicit Wall(int units);
+
+    int units() const { return units_; }
+    int width() const { return 5 * units_; }
+
+    // Drawing.  Columns outside the wall are silently clipped.
+    void clear();
+    void setChar(int column, char c);
+    void setDP(int column, char dp);       // '1' lower, '2' upper, '3' both, else none
+    void print(int column, const std::string &text);
+    void printDP(int column, const std::string &dp);
+
+    char charAt(int column) const;
+    char dpAt(int column) const;
+
+    // True if the unit differs from what was last sent to it.
+    bool dirty(int unit) const;
+
+    // Forget what the clocks are showing, e.g., after they have been reset or
+    // returned to time display; the next flush() resends every unit.
+    void invalidate();
+
+    // Append one A<n> message for each dirty unit, and mark them clean.
+    // Farthest units are sent first, since their messages take longest to
+    // propagate down the chain.  Returns the number of messages appended.
+    size_t flush(Bytes &out);
+
+private:
+    int units_;
+    std::vector<char> text_, dp_;            // What we want shown
+    std::vector<char> sentText_, sentDp_;    // What we last sent
+    std::vector<bool> known_;                // False until a unit has been sent a frame
+};
+
+
+// Segment-level framebuffer for the same daisy chain, sent as V<n> video frames.
+class VideoWall {
+public:
+    // "units" is clamped to the range 1 - kMaxChainUnits.
+    explicit VideoWall(int units);
+
+    int units() const { return units_; }
+    int width() const { return 5 * units_; }
+
+    // Drawing.  "segment" is 0-17, as for frameIndex(); levels are 0-15.
+    // Columns and segments outside the wall are silently clipped.
+    void clear();
+    void setSegment(int column, int segment, int level);
+    int segmentAt(int column, int segment) const;
+
+    // The frame (kFrameSegments levels) for one unit, for drawing directly.
+    uint8_t *frame(int unit) { return &frames_[kFrameSegments * unit]; }
+
+    bool dirty(int unit) const;
+    void invalidate();
+
+    // Append a key frame for each unit not yet sent one, and a delta frame for
+    // each other dirty unit, farthest first.  Returns the number of messages appended.
+    size_t flush(Bytes &out);
+
+private:
+    int units_;
+    std::vector<uint8_t> frames_, sent_;
+    std::vector<bool> known_;
+};
+
+}  // namespace a5
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ a5bufbench.cpp
+
+ Part of the Alpha Five host tools
+
+ Benchmark: the alphafive render pipeline, built with and without packed
+ off-screen buffers (a5_PACKED_BUFFERS).  The library is compiled for the
+ host against the stand-in headers in bench/avrshim; build it twice and
+ compare:
+
+   g++ -std=gnu++11 -O2 -Ibench/avrshim -I../alphafive -o a5bufbench \
+       bench/a5bufbench.cpp bench/avrshim/avrshim.cpp ../alphafive/alphafive.cpp
+   g++ -std=gnu++11 -O2 -Da5_PACKED_BUFFERS -Ibench/avrshim -I../alphafive -o a5bufbench-packed \
+       bench/a5bufbench.cpp bench/avrshim/avrshim.cpp ../alphafive/alphafive.cpp
+
+ Timings are host nanoseconds, so only the ratios between the two builds mean
+ anything; the AVR pays relatively more for the shifts in the packed accessors.
+ Each run also prints a checksum of everything displayed, which must be the
+ same for both builds.
+
+ Add -Da5_CHARS=4 (or 1-3) to time the library built for a smaller display.
+
+ The "ascii load" cases time font lookups: first from the built-in (flash)
+ table, then with every character used redefined by a5editFontChar().
+
+ Usage: a5bufbench [-n iterations]
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#include "alphafive.h"
+
+extern byte a5_vidBuf[];
+
+typedef std::chrono::steady_clock Clock;
+
+static uint32_t checksum;
+static long fadeStages;
+
+static void sumVidBuf(void)
+{
+    for (int i = 0; i < a5_VIDBUFLENGTH; i++)
+        checksum = (checksum * 31) + a5_vidBuf[i];
+}
+
+// One clock-face update: compose the new time, then run the whole fade to it.
+static void fadeFrame(int i)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%02d%02dA", (i / 60) % 24, i % 60);
+
+    a5setLayerText(0, text, a5_brightLevel);
+    a5setLayerDP(0, (char *) "01200");
+    a5composeOSB();
+    a5BeginFadeToOSB();
+    while (a5_FadeStage >= 0) {
+        a5LoadNextFadeStage();
+        a5loadVidBuf_fromOSB();
+        fadeStages++;
+    }
+    sumVidBuf();
+}
+
+static void composeOnly(int i)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%05d", i % 100000);
+    a5setLayerText(1, text, 7);
+    a5composeOSB();
+    a5loadVidBuf_fromOSB();
+}
+
+static void additive(int i)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%05d", i % 100000);
+    a5clearOSB();
+    a5loadOSB_Ascii(text, a5_brightLevel);
+    a5loadOSB_DP((char *) "_1_2_", a5_brightLevel);
+    a5loadVidBuf_fromOSB();
+}
+
+// Font lookups: five characters straight to the video buffer.
+static void asciiLoad(int i)
+{
+    static const char *words[4] = { "12:34", "ALARM", "Hello", "{~#@}" };
+    a5loadVidBuf_Ascii((char *) words[i & 3], a5_brightLevel);
+    if ((i & 1023) == 0)
+        sumVidBuf();
+}
+
+// Redefine every character used by asciiLoad(), so that each lookup goes to the RAM patch table.
+static void editWords(void)
+{
+    const char *edited = "12:34ALRMHelo{~#@}";
+    for (const char *c = edited; *c; c++)
+        a5editFontChar(*c, a5getFontChar(*c, 0) ^ 1, a5getFontChar(*c, 1), a5getFontChar(*c, 2));
+}
+
+static void run(const char *name, void (*step)(int), int iterations)
+{
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; i++)
+        step(i);
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    printf("%-26s %10.1f ns\n", name, ns / iterations);
+}
+
+// Whole fades with each transition effect; the cost per stage should be about the same for all.
+static void runFades(int iterations)
+{
+    static const char *const names[a5_TRANSITIONS] = {
+        "fade, uniform", "fade, wipe", "fade, stagger", "fade, draw" };
+
+    for (byte effect = 0; effect < a5_TRANSITIONS; effect++) {
+        a5setTransition(effect);
+        fadeStages = 0;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < iterations; i++)
+            fadeFrame(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        printf("%-26s %10.1f ns  (%ld stages, %.1f ns each)\n", names[effect], ns / iterations,
+               fadeStages / iterations, ns / fadeStages);
+    }
+    a5setTransition(a5_TRANSITION_FADE);
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = 200000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n': iterations = atoi(optarg); break;
+        default:
+            fprintf(stderr, "Usage: a5bufbench [-n iterations]\n");
+            return 2;
+        }
+    }
+
+#ifdef a5_PACKED_BUFFERS
+    printf("Layout: packed, ");
+#else
+    printf("Layout: unpacked, ");
+#endif
+    printf("%d bytes for a5_OSB, a5_LastOSB, a5_FadeFrom and a5_FadeTo\n", 4 * a5_OSBLENGTH);
+
+    a5_brightLevel = a5_MaxBright;
+    runFades(iterations / 20);
+    run("compose + load vidBuf", composeOnly, iterations);
+    run("clear + add + load vidBuf", additive, iterations);
+    run("ascii load, built-in font", asciiLoad, iterations);
+    editWords();
+    run("ascii load, edited font", asciiLoad, iterations);
+    printf("Checksum: %08x\n", checksum);
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ a5fleetbench.cpp
+
+ Part of the Alpha Five host tools
+
+ Benchmark: provisioning many clocks at once with a5::Fleet, against a room of
+ pty stand-in clocks (a5::SimClocks).  Each clock gets a time sync and a full
+ set of settings, which are then checked against what the stand-ins received.
+
+ Two cases are measured:
+   concurrent  One Fleet, every port at once (as a5provision does).
+   one-by-one  The same job, one port at a time, as with a5send or the
+               Processing sketches.
+
+ Usage: a5fleetbench [-n clocks] [-d reply delay, ms]
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "a5fleet.h"
+#include "a5simclock.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static void raiseFileLimit(void)
+{   // Three descriptors per stand-in: pty master and slave, and the fleet's own open of the slave.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static int check(const char *name, const std::vector<a5::FleetResult> &results,
+                 const a5::SimClocks &sims, const a5::FleetJob &job, double totalMs)
+{
+    std::vector<double> ms;
+    int failed = 0;
+
+    for (size_t i = 0; i < results.size(); i++) {
+        uint8_t settings[a5::kSettingsLength];
+        sims.settings(i, settings);
+        if (!results[i].ok || (sims.time(i) == 0) || memcmp(settings, job.settings, sizeof(settings)))
+            failed++;
+        else
+            ms.push_back(results[i].timeMs + results[i].settingsMs);
+    }
+    std::sort(ms.begin(), ms.end());
+
+    printf("%-11s %4d clocks  %9.1f ms total  %8.1f clocks/s", name, (int) results.size(),
+           totalMs, 1000.0 * results.size() / totalMs);
+    if (!ms.empty())
+        printf("  per clock: median %.2f ms, max %.2f ms", ms[ms.size() / 2], ms.back());
+    printf("  %s\n", failed ? "FAILED" : "ok");
+    return failed;
+}
+
+int main(int argc, char *argv[])
+{
+    int clocks = 200;
+    int delayMs = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:d:")) != -1) {
+        switch (opt) {
+        case 'n': clocks = atoi(optarg); break;
+        case 'd': delayMs = atoi(optarg); break;
+        default:
+            fprintf(stderr, "Usage: a5fleetbench [-n clocks] [-d reply delay, ms]\n");
+            return 2;
+        }
+    }
+
+    raiseFileLimit();
+
+    a5::FleetJob job;
+    const uint8_t settings[a5::kSettingsLength] = { 5, 1, 1, 6, 45, 3, 2, 4, 1 };
+    job.setTime = true;
+    job.putSettings = true;
+    memcpy(job.settings, settings, sizeof(settings));
+
+    int failed = 0;
+    {
+        a5::SimClocks sims;
+        if (!sims.start(clocks, delayMs)) {
+            fprintf(stderr, "a5fleetbench: %s\n", sims.error().c_str());
+            return 1;
+        }
+
+        a5::Fleet fleet;
+        for (size_t i = 0; i < sims.paths().size(); i++)
+            fleet.add(sims.paths()[i]);
+
+        Clock::time_point start = Clock::now();
+        std::vector<a5::FleetResult> results = fleet.run(job, 10000);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        failed += check("concurrent", results, sims, job, ms);
+    }
+    {
+        a5::SimClocks sims;
+        if (!sims.start(clocks, delayMs)) {
+            fprintf(stderr, "a5fleetbench: %s\n", sims.error().c_str());
+            return 1;
+        }
+
+        std::vector<a5::FleetResult> results;
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < sims.paths().size(); i++) {
+            a5::Fleet fleet;
+            fleet.add(sims.paths()[i]);
+            std::vector<a5::FleetResult> one = fleet.run(job, 10000);
+            results.push_back(one[0]);
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        failed += check("one-by-one", results, sims, job, ms);
+    }
+    return failed ? 1 : 0;
+}
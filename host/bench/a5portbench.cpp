@@ -0,0 +1,210 @@
+/*
+ a5portbench.cpp
+
+ Part of the Alpha Five host tools
+
+ Benchmark: sustained commands per second through a5::Port, over a
+ pseudo-terminal loopback.  A reader thread on the pty master stands in for
+ the clock: it reassembles 13-byte messages and checks that none are lost,
+ reordered or corrupted.
+
+ Three cases are measured:
+   per-field   Processing-sketch style: one write() per field, no queue.
+   pipelined   a5::Port, pacing off: how fast the library itself can go.
+   paced       a5::Port, paced to the line rate (the normal configuration).
+               On a pty this should settle at the 19200 baud ceiling,
+               1920 / 13 = 147.7 messages per second.
+
+ Usage: a5portbench [-n messages] [-b baud]
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "a5port.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct Loopback {
+    int master;
+    std::string slavePath;
+};
+
+static bool openLoopback(Loopback &loop)
+{
+    loop.master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((loop.master < 0) || (grantpt(loop.master) != 0) || (unlockpt(loop.master) != 0))
+        return false;
+
+    struct termios tio;
+    tcgetattr(loop.master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(loop.master, TCSANOW, &tio);
+
+    loop.slavePath = ptsname(loop.master);
+    return true;
+}
+
+// The stand-in clock: count complete, in-order messages until "expected" have arrived.
+static void receiver(int master, int expected, std::atomic<int> *received, std::atomic<int> *errors)
+{
+    uint8_t message[a5::kMessageLength];
+    size_t fill = 0;
+    int next = 0;
+
+    while (*received < expected) {
+        struct pollfd pfd = { master, POLLIN, 0 };
+        if (poll(&pfd, 1, 2000) <= 0)
+            break;
+
+        uint8_t buffer[4096];
+        ssize_t count = read(master, buffer, sizeof(buffer));
+        for (ssize_t i = 0; i < count; i++) {
+            if ((fill == 0) && (buffer[i] != a5::kHeader)) {
+                (*errors)++;    // Lost framing
+                continue;
+            }
+            message[fill++] = buffer[i];
+            if (fill < a5::kMessageLength)
+                continue;
+            fill = 0;
+
+            // Sequence number is carried in the five text characters.
+            int sequence = atoi(std::string((const char *) &message[3], 5).c_str());
+            if (sequence != (next % 100000))
+                (*errors)++;
+            next++;
+            (*received)++;
+        }
+    }
+}
+
+static a5::Bytes numberedMessage(int sequence)
+{
+    char text[6];
+    snprintf(text, sizeof(text), "%05d", sequence % 100000);
+    a5::Bytes message;
+    a5::appendText(message, 0, text, "     ");
+    return message;
+}
+
+static void report(const char *name, int messages, int received, int errors, double seconds)
+{
+    printf("%-10s %7d msgs  %8.3f s  %10.1f msgs/s  %s\n", name, received, seconds,
+           received / seconds, ((received == messages) && (errors == 0)) ? "ok" : "LOST/CORRUPT");
+}
+
+static void runPerField(int messages)
+{
+    Loopback loop;
+    if (!openLoopback(loop))
+        return;
+
+    int fd = open(loop.slavePath.c_str(), O_RDWR | O_NOCTTY);
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+
+    std::atomic<int> received(0), errors(0);
+    std::thread reader(receiver, loop.master, messages, &received, &errors);
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < messages; i++) {
+        // As the Processing sketches do it: header, command, unit, text, DPs.
+        a5::Bytes m = numberedMessage(i);
+        if ((write(fd, &m[0], 1) < 0) || (write(fd, &m[1], 1) < 0) || (write(fd, &m[2], 1) < 0) ||
+            (write(fd, &m[3], 5) < 0) || (write(fd, &m[8], 5) < 0))
+            break;
+    }
+    reader.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    report("per-field", messages, received, errors, seconds);
+    close(fd);
+    close(loop.master);
+}
+
+static void runPort(const char *name, int messages, int baud, bool pacing)
+{
+    Loopback loop;
+    if (!openLoopback(loop))
+        return;
+
+    a5::Port port;
+    if (!port.open(loop.slavePath, baud)) {
+        fprintf(stderr, "%s\n", port.error().c_str());
+        return;
+    }
+    port.setPacing(pacing);
+
+    std::atomic<int> received(0), errors(0);
+    std::thread reader(receiver, loop.master, messages, &received, &errors);
+
+    size_t maxQueued = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < messages; i++) {
+        port.send(numberedMessage(i));
+        size_t queued = port.queued();
+        if (queued > maxQueued)
+            maxQueued = queued;
+    }
+    port.drain();
+    reader.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    report(name, messages, received, errors, seconds);
+    printf("%-10s queue high-water mark: %zu bytes\n", "", maxQueued);
+    port.close();
+    close(loop.master);
+}
+
+int main(int argc, char *argv[])
+{
+    int messages = 20000;
+    int pacedMessages = 300;
+    int baud = a5::kDefaultBaud;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:p:b:")) != -1) {
+        switch (opt) {
+        case 'n': messages = atoi(optarg); break;
+        case 'p': pacedMessages = atoi(optarg); break;
+        case 'b': baud = atoi(optarg); break;
+        default:
+            fprintf(stderr, "Usage: a5portbench [-n messages] [-p paced messages] [-b baud]\n");
+            return 2;
+        }
+    }
+
+    printf("Line rate at %d baud: %.1f msgs/s\n", baud, 1.0 / a5::wireSeconds(a5::kMessageLength, baud));
+    runPerField(messages);
+    runPort("pipelined", messages, baud, false);
+    runPort("paced", pacedMessages, baud, true);
+    return 0;
+}
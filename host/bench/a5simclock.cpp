@@ -0,0 +1,409 @@
+/*
+ a5simclock.cpp
+
+ Part of the Alpha Five host tools
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <random>
+
+#include "a5simclock.h"
+
+namespace a5 {
+
+static const uint32_t kWakeEvent = 0xFFFFFFFF;
+static const uint32_t kTimerEvent = 0xFFFFFFFE;
+
+// The firmware's defaults, as after a reset to factory settings.
+static const uint8_t kDefaultSettings[kSettingsLength] = { 9, 0, 0, 7, 30, 2, 0, 2, 0 };
+
+SimClocks::SimClocks()
+    : replyDelayMs_(0), baud_(0), epoll_(-1), wake_(-1), timer_(-1)
+{
+}
+
+SimClocks::~SimClocks()
+{
+    stop();
+}
+
+bool SimClocks::start(int count, int replyDelayMs, int chainUnits, int baud)
+{
+    stop();
+    replyDelayMs_ = replyDelayMs;
+    baud_ = baud;
+    start_ = Clock::now();
+
+    epoll_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    timer_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if ((epoll_ < 0) || (wake_ < 0) || (timer_ < 0)) {
+        error_ = std::string("epoll: ") + strerror(errno);
+        return false;
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u32 = kWakeEvent;
+    epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_, &event);
+    event.data.u32 = kTimerEvent;
+    epoll_ctl(epoll_, EPOLL_CTL_ADD, timer_, &event);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> phase(0, 1000);
+
+    for (int i = 0; i < count; i++) {
+        Sim sim;
+        sim.master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if ((sim.master < 0) || (grantpt(sim.master) != 0) || (unlockpt(sim.master) != 0)) {
+            error_ = std::string("pty: ") + strerror(errno);
+            if (sim.master >= 0)
+                ::close(sim.master);
+            stop();
+            return false;
+        }
+
+        std::string path = ptsname(sim.master);
+        sim.slave = ::open(path.c_str(), O_RDWR | O_NOCTTY);
+        if (sim.slave < 0) {
+            error_ = path + ": " + strerror(errno);
+            ::close(sim.master);
+            stop();
+            return false;
+        }
+
+        struct termios tio;
+        tcgetattr(sim.slave, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(sim.slave, TCSANOW, &tio);
+
+        for (int j = 0; j < chainUnits; j++) {
+            Unit unit;
+            unit.phaseMs = phase(random);
+            unit.time = 0;
+            unit.second = 0;
+            unit.secondAt = 0;
+            memcpy(unit.settings, kDefaultSettings, sizeof(unit.settings));
+            sim.units.push_back(unit);
+        }
+        sims_.push_back(sim);
+        paths_.push_back(path);
+
+        event.events = EPOLLIN;
+        event.data.u32 = i;
+        epoll_ctl(epoll_, EPOLL_CTL_ADD, sim.master, &event);
+    }
+
+    server_ = std::thread(&SimClocks::serve, this);
+    return true;
+}
+
+void SimClocks::stop()
+{
+    if (server_.joinable()) {
+        uint64_t one = 1;
+        if (write(wake_, &one, sizeof(one)) < 0)
+            error_ = std::string("eventfd: ") + strerror(errno);
+        server_.join();
+    }
+
+    for (size_t i = 0; i < sims_.size(); i++) {
+        ::close(sims_[i].slave);
+        ::close(sims_[i].master);
+    }
+    sims_.clear();
+    paths_.clear();
+    while (!events_.empty())
+        events_.pop();
+
+    if (timer_ >= 0)
+        ::close(timer_);
+    if (wake_ >= 0)
+        ::close(wake_);
+    if (epoll_ >= 0)
+        ::close(epoll_);
+    timer_ = -1;
+    wake_ = -1;
+    epoll_ = -1;
+}
+
+uint32_t SimClocks::time(int clock, int unit) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sims_[clock].units[unit].time;
+}
+
+void SimClocks::settings(int clock, uint8_t out[kSettingsLength], int unit) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    memcpy(out, sims_[clock].units[unit].settings, kSettingsLength);
+}
+
+bool SimClocks::rollover(int clock, int unit, uint32_t &second, Clock::time_point &at) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Unit &u = sims_[clock].units[unit];
+    if (u.time == 0)
+        return false;
+    second = u.second;
+    at = start_ + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(u.secondAt));
+    return true;
+}
+
+double SimClocks::msSinceStart() const
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start_).count();
+}
+
+double SimClocks::wireMs(size_t byteCount) const
+{
+    return baud_ ? 1000 * wireSeconds(byteCount, baud_) : 0;
+}
+
+void SimClocks::reply(int clock, int unit, const Bytes &data, double at)
+{   // Upstream, through every unit between this one and the host.
+    Event event;
+    event.due = at + replyDelayMs_ + (unit + 1) * wireMs(data.size());
+    event.clock = clock;
+    event.unit = -1;
+    event.data = data;
+    events_.push(event);
+}
+
+void SimClocks::relay(Sim &sim, int clock, int unit, Bytes message, double at)
+{   // Downstream, to the next unit, if there is one.
+    if (unit + 1 >= (int) sim.units.size())
+        return;
+    Event event;
+    event.due = at + wireMs(kMessageLength);
+    event.clock = clock;
+    event.unit = unit + 1;
+    event.data = message;
+    events_.push(event);
+}
+
+void SimClocks::handle(Sim &sim, int clock, int unit, Bytes message, double at)
+{   // One complete 13-byte message, starting with the header, arriving at "at".
+    Unit &u = sim.units[unit];
+    char command = message[1];
+    char address = message[2];
+
+    if ((command == 'S') && (address == 'T')) {
+        uint32_t t = 0;
+        for (int i = 3; i < 13; i++)
+            if ((message[i] >= '0') && (message[i] <= '9'))
+                t = (10 * t) + (message[i] - '0');
+        u.time = t;
+        u.second = t;
+        u.secondAt = at;
+
+        const char text[] = "PC Time Sync Signal Received.\r\n";
+        reply(clock, unit, Bytes(text, text + strlen(text)), at);
+        return;
+    }
+
+    if ((command == 'T') && (message[3] == 'S')) {
+        // As processTimeSync(): every unit acts on it, and passes it on.
+        uint32_t seconds = message[5] | (message[6] << 8) | (message[7] << 16) | ((uint32_t) message[8] << 24);
+        uint32_t us = message[9] | (message[10] << 8) | (message[11] << 16);
+        if (us > 999999)
+            return;
+
+        // The second begins when micros() reaches arrival + (1000000 - us); the Time library
+        // counts from the millis() of that moment.
+        double syncAt = (at + u.phaseMs) + (1000000 - us) / 1000.0;
+        u.time = seconds + 1;
+        u.second = seconds + 1;
+        u.secondAt = floor(syncAt) - u.phaseMs;
+
+        message[1] = 't';
+        reply(clock, unit, message, at);
+
+        us += (uint32_t) (1000 * wireMs(kMessageLength) + 0.5);  // a5_SYNC_WIRE_US, for this baud rate
+        seconds += us / 1000000;
+        us %= 1000000;
+        message[1] = 'T';
+        message[2] = address + 1;
+        for (int i = 0; i < 4; i++)
+            message[5 + i] = (uint8_t) (seconds >> (8 * i));
+        for (int i = 0; i < 3; i++)
+            message[9 + i] = (uint8_t) (us >> (8 * i));
+        relay(sim, clock, unit, message, at);
+        return;
+    }
+
+    if ((command == 'D') && (message[3] == '?')) {
+        // As processDiscovery(): report, pass the request on, then time the hop below.
+        Bytes report(message);
+        report[1] = 'd';
+        report[3] = 'U';
+        report[5] = 2;
+        report[6] = 2;
+        report[7] = 0;
+        for (size_t i = 8; i < kMessageLength; i++)
+            report[i] = 0;
+        reply(clock, unit, report, at);
+
+        message[2] = address + 1;
+        relay(sim, clock, unit, message, at);
+
+        // The next unit gets the request one message later, and its report starts back after
+        // its reply delay and one byte; this unit passes that report on, then sends its own.
+        bool last = (unit + 1 >= (int) sim.units.size());
+        double hopMs = wireMs(kMessageLength) + replyDelayMs_ + wireMs(1);
+        double sendAt = last ? at + 100 : at + hopMs + wireMs(kMessageLength - 1);
+        uint32_t hopUs = last ? 0 : std::max<uint32_t>(1, (uint32_t) (1000 * hopMs + 0.5));
+        report[3] = 'H';
+        for (int i = 0; i < 3; i++)
+            report[5 + i] = (uint8_t) (hopUs >> (8 * i));
+        report[8] = report[9] = 0;
+        reply(clock, unit, report, sendAt - replyDelayMs_);     // (Not delayed: it isn't a reply.)
+        return;
+    }
+
+    if ((address != '0') && (address != 0)) {
+        // Daisy chaining, as with Ax.
+        if ((command != 'M') && (address <= '9')) {
+            message[2] = address - 1;
+            relay(sim, clock, unit, message, at);
+        }
+        return;
+    }
+
+    if (command == 'T') {
+        if (message[3] == 'E') {
+            message[1] = 't';
+            message[2] = '0';
+            reply(clock, unit, message, at);
+        }
+        return;
+    }
+
+    if ((command != 'G') && (command != 'P'))
+        return;     // Not a command that answers
+
+    if (command == 'P') {
+        const uint8_t *settings = &message[3];
+        bool valid = (settingsChecksum(settings) == message[3 + kSettingsLength]);
+        for (int i = 0; i < kSettingsLength; i++)
+            if (settings[i] > kSettingMax[i])
+                valid = false;
+        if (valid)
+            memcpy(u.settings, settings, kSettingsLength);
+    }
+
+    Bytes data;
+    data.push_back(kHeader);
+    data.push_back(command + ('a' - 'A'));
+    data.push_back('0');
+    data.insert(data.end(), u.settings, u.settings + kSettingsLength);
+    data.push_back(settingsChecksum(u.settings));
+    reply(clock, unit, data, at);
+}
+
+void SimClocks::serve()
+{
+    std::vector<struct epoll_event> events(sims_.size() + 2);
+
+    for (;;) {
+        {   // Sleep until input arrives, or the next event is due.
+            std::lock_guard<std::mutex> lock(mutex_);
+            struct itimerspec due;
+            memset(&due, 0, sizeof(due));
+            if (!events_.empty()) {
+                Clock::duration at = start_.time_since_epoch() + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::milli>(events_.top().due));
+                long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(at).count();
+                due.it_value.tv_sec = ns / 1000000000;
+                due.it_value.tv_nsec = ns % 1000000000;
+                if ((due.it_value.tv_sec == 0) && (due.it_value.tv_nsec == 0))
+                    due.it_value.tv_nsec = 1;
+            }
+            timerfd_settime(timer_, TFD_TIMER_ABSTIME, &due, NULL);
+        }
+
+        int ready = epoll_wait(epoll_, &events[0], events.size(), -1);
+        if ((ready < 0) && (errno != EINTR))
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.u32 == kWakeEvent)
+                return;
+            if (events[i].data.u32 == kTimerEvent) {
+                uint64_t expirations;
+                if ((read(timer_, &expirations, sizeof(expirations)) < 0) && (errno != EAGAIN))
+                    error_ = std::string("timerfd: ") + strerror(errno);
+                continue;
+            }
+
+            int clock = events[i].data.u32;
+            Sim &sim = sims_[clock];
+            uint8_t buffer[512];
+            ssize_t count;
+            while ((count = read(sim.master, buffer, sizeof(buffer))) > 0)
+                sim.in.insert(sim.in.end(), buffer, buffer + count);
+
+            double now = msSinceStart();
+            for (;;) {
+                size_t start = 0;
+                while ((start < sim.in.size()) && (sim.in[start] != kHeader))
+                    start++;        // Resynchronize on the next header, as the firmware does
+                sim.in.erase(sim.in.begin(), sim.in.begin() + start);
+                if (sim.in.size() < kMessageLength)
+                    break;
+
+                Event event;        // Arriving once its last byte is off the wire
+                event.due = now + wireMs(kMessageLength);
+                event.clock = clock;
+                event.unit = 0;
+                event.data.assign(sim.in.begin(), sim.in.begin() + kMessageLength);
+                events_.push(event);
+                sim.in.erase(sim.in.begin(), sim.in.begin() + kMessageLength);
+            }
+        }
+
+        double now = msSinceStart();
+        while (!events_.empty() && (events_.top().due <= now)) {
+            Event event = events_.top();
+            events_.pop();
+            Sim &sim = sims_[event.clock];
+            if (event.unit >= 0)
+                handle(sim, event.clock, event.unit, event.data, event.due);
+            else if (write(sim.master, &event.data[0], event.data.size()) < 0)
+                error_ = std::string("write: ") + strerror(errno);
+        }
+    }
+}
+
+}  // namespace a5
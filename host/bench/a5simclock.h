@@ -0,0 +1,127 @@
+/*
+ a5simclock.h
+
+ Part of the Alpha Five host tools
+
+ Stand-in clocks, for testing and benchmarking the host tools without hardware.
+ Each stand-in is a pseudo-terminal: open its slave path as you would a clock's
+ serial port.  One thread serves all of them, so hundreds may run at once.
+
+ The stand-ins understand the fixed-length 13-byte commands, and answer as the
+ firmware does: ST prints "PC Time Sync Signal Received.", G0 and P0 reply with
+ the settings, T0 echoes and syncs, and D reports.  A, B and MT are
+ accepted and ignored.  Replies can be delayed, to stand in for a slower clock
+ or link.
+
+ Each stand-in may be a daisy chain of units, relaying commands and replies as
+ the firmware does, and the serial line may be emulated at a given baud rate:
+ each message then takes as long to arrive, at each hop, as it would on the wire.
+ Every unit has a millisecond clock of its own, started at a random phase, so
+ that the second rollovers set by ST and T<n> can be checked against the host's.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef a5simclock_h
+#define a5simclock_h
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "a5proto.h"
+
+namespace a5 {
+
+class SimClocks {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    SimClocks();
+    ~SimClocks();
+
+    // Create "count" stand-ins, each a chain of "chainUnits" units, and start serving them.
+    // baud: emulate the serial line at this rate, or 0 for no delay.
+    bool start(int count, int replyDelayMs = 0, int chainUnits = 1, int baud = 0);
+    void stop();
+
+    const std::vector<std::string> &paths() const { return paths_; }
+    const std::string &error() const { return error_; }
+
+    // What each unit was last told: the time set by ST or T<n> (0 if none), and its settings.
+    uint32_t time(int clock, int unit = 0) const;
+    void settings(int clock, uint8_t out[kSettingsLength], int unit = 0) const;
+
+    // The second that the unit's clock last began as it was set, by ST or T<n>, and when.
+    // Returns false if it hasn't been set.
+    bool rollover(int clock, int unit, uint32_t &second, Clock::time_point &at) const;
+
+private:
+    struct Unit {
+        double phaseMs;                 // micros() / 1000 = now + phaseMs, in ms since start()
+        uint32_t time;
+        uint32_t second;                // See rollover()
+        double secondAt;
+        uint8_t settings[kSettingsLength];
+    };
+
+    struct Sim {
+        int master;
+        int slave;                      // Held open, so that the master never sees a hangup
+        Bytes in;
+        std::vector<Unit> units;
+    };
+
+    // A message arriving at a unit from upstream, or a reply arriving at the host.
+    struct Event {
+        double due;                     // ms since start()
+        int clock;
+        int unit;                       // Arriving at; -1 for the host
+        Bytes data;
+
+        bool operator>(const Event &other) const { return due > other.due; }
+    };
+
+    void serve();
+    void handle(Sim &sim, int clock, int unit, Bytes message, double at);
+    void reply(int clock, int unit, const Bytes &data, double at);
+    void relay(Sim &sim, int clock, int unit, Bytes message, double at);
+    double msSinceStart() const;
+    double wireMs(size_t byteCount) const;
+
+    std::vector<Sim> sims_;
+    std::vector<std::string> paths_;
+    std::string error_;
+    int replyDelayMs_;
+    int baud_;
+    Clock::time_point start_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event> > events_;
+    int epoll_;
+    int wake_;                          // eventfd: stop()
+    int timer_;                         // timerfd: the next event is due
+    mutable std::mutex mutex_;
+    std::thread server_;
+};
+
+}  // namespace a5
+
+#endif
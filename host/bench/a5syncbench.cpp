@@ -0,0 +1,157 @@
+/*
+ a5syncbench.cpp
+
+ Part of the Alpha Five host tools
+
+ Benchmark: how closely the second rollovers of a room of clocks line up with
+ this computer's, after a whole-second time sync (ST) and after a sub-second one
+ (T0, with round-trip measurement and per-hop compensation).  The clocks are
+ pty stand-ins (a5::SimClocks), each port a daisy chain, with the serial line
+ emulated at 19200 baud; each unit's millisecond clock starts at a random phase.
+
+ The error of a unit is the time at which its clock began the second it was set
+ to, less the time at which this computer's clock began the same second.
+
+ Usage: a5syncbench [-n ports] [-c units per chain] [-d reply delay, ms] [-l limit, ms]
+
+ Exits nonzero if any T0-synced unit is off by more than the limit (default 3 ms).
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "a5fleet.h"
+#include "a5simclock.h"
+
+typedef a5::SimClocks::Clock Clock;
+
+static void raiseFileLimit(void)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static double run(const char *name, const a5::FleetJob &job, int ports, int units, int delayMs)
+{   // Returns the largest error, in ms, or -1 if any port failed.
+    a5::SimClocks sims;
+    if (!sims.start(ports, delayMs, units, a5::kDefaultBaud)) {
+        fprintf(stderr, "a5syncbench: %s\n", sims.error().c_str());
+        exit(1);
+    }
+
+    a5::Fleet fleet;
+    for (size_t i = 0; i < sims.paths().size(); i++)
+        fleet.add(sims.paths()[i]);
+    std::vector<a5::FleetResult> results = fleet.run(job, 10000);
+
+    // This computer's local time, in ms, at the steady clock's epoch.
+    double localAtEpoch = a5::localTimeNowUs() / 1000.0 -
+        std::chrono::duration<double, std::milli>(Clock::now().time_since_epoch()).count();
+
+    std::vector<double> errors, rtt;
+    int failed = 0;
+    for (int i = 0; i < ports; i++) {
+        if (!results[i].ok) {
+            fprintf(stderr, "%s: %s\n", results[i].path.c_str(), results[i].error.c_str());
+            failed++;
+            continue;
+        }
+        if (results[i].rttMs >= 0)
+            rtt.push_back(results[i].rttMs);
+        for (int j = 0; j < (job.syncTime ? units : 1); j++) {
+            uint32_t second;
+            Clock::time_point at;
+            if (!sims.rollover(i, j, second, at)) {
+                failed++;
+                continue;
+            }
+            double local = localAtEpoch + std::chrono::duration<double, std::milli>(at.time_since_epoch()).count();
+            errors.push_back(local - 1000.0 * second);
+        }
+    }
+    if (failed || errors.empty()) {
+        printf("%-8s FAILED (%d)\n", name, failed);
+        return -1;
+    }
+
+    std::vector<double> magnitude(errors.size());
+    for (size_t i = 0; i < errors.size(); i++)
+        magnitude[i] = fabs(errors[i]);
+    std::sort(magnitude.begin(), magnitude.end());
+    std::sort(errors.begin(), errors.end());
+
+    printf("%-8s %4d units  error: median |%.2f| ms, max |%.2f| ms, range %+.2f to %+.2f ms",
+           name, (int) errors.size(), magnitude[magnitude.size() / 2], magnitude.back(),
+           errors.front(), errors.back());
+    if (!rtt.empty()) {
+        std::sort(rtt.begin(), rtt.end());
+        printf("  round trip median %.2f ms", rtt[rtt.size() / 2]);
+    }
+    printf("\n");
+    return magnitude.back();
+}
+
+int main(int argc, char *argv[])
+{
+    int ports = 20;
+    int units = 8;
+    int delayMs = 0;
+    double limitMs = 3;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:c:d:l:")) != -1) {
+        switch (opt) {
+        case 'n': ports = atoi(optarg); break;
+        case 'c': units = atoi(optarg); break;
+        case 'd': delayMs = atoi(optarg); break;
+        case 'l': limitMs = atof(optarg); break;
+        default:
+            fprintf(stderr, "Usage: a5syncbench [-n ports] [-c units per chain] [-d reply delay, ms] [-l limit, ms]\n");
+            return 2;
+        }
+    }
+    if ((units < 1) || (units > a5::kMaxChainUnits)) {
+        fprintf(stderr, "a5syncbench: -c must be 1-%d\n", a5::kMaxChainUnits);
+        return 2;
+    }
+
+    raiseFileLimit();
+
+    a5::FleetJob wholeSecond;
+    wholeSecond.setTime = true;
+
+    a5::FleetJob subSecond;
+    subSecond.syncTime = true;
+    subSecond.chainUnits = units;
+
+    // ST reaches unit 0 of each port only.
+    run("ST", wholeSecond, ports, units, delayMs);
+    double worst = run("T0", subSecond, ports, units, delayMs);
+    return ((worst < 0) || (worst > limitMs)) ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+/*
+ Arduino.h
+
+ Part of the Alpha Five host tools
+
+ Just enough of the Arduino and AVR environment to compile the alphafive
+ library on a host computer, for benchmarks.  Registers are plain variables;
+ interrupt service routines become ordinary functions that are never called.
+ Nothing here drives hardware.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef a5_avrshim_Arduino_h
+#define a5_avrshim_Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#define pgm_read_word(address) (*(const uint16_t *) (address))
+
+#define _BV(bit) (1 << (bit))
+#define bitWrite(value, bit, set) ((set) ? ((value) |= _BV(bit)) : ((value) &= ~_BV(bit)))
+#define ISR(vector) void vector(void)
+#define cli()
+#define sei()
+#define asm(instruction)
+#define loop_until_bit_is_set(reg, bit)
+
+extern volatile uint8_t PORTA, PORTB, PORTC, PORTD, DDRA, DDRB, DDRC, DDRD, PINA, PINB, PINC, PIND;
+extern volatile uint8_t SPDR, SPSR, SPCR, SREG;
+extern volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TCCR2A, TCCR2B, TIMSK2, OCR2A, OCR2B, TCNT2;
+extern volatile uint16_t OCR1A, TCNT1;
+extern volatile uint8_t TWBR, TWCR, TWSR, TWDR;
+
+// Bit positions, as on the ATmega644
+#define SPIF   7
+#define SPE    6
+#define MSTR   4
+#define COM1A0 6
+#define WGM12  3
+#define CS11   1
+#define WGM20  0
+#define WGM21  1
+#define COM2B1 5
+#define CS20   0
+#define CS21   1
+#define CS22   2
+#define TOIE2  0
+#define OCIE2A 1
+#define OCIE1A 1
+#define TWINT  7
+#define TWEA   6
+#define TWSTA  5
+#define TWSTO  4
+#define TWEN   2
+
+#define F_CPU 16000000UL
+
+#define FLASHEND     0xFFFF
+#define SPM_PAGESIZE 256
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void randomSeed(unsigned long seed);
+int analogRead(uint8_t pin);
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) { (void) baud; }
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t data) { (void) data; return 1; }
+};
+
+extern HardwareSerial Serial, Serial1;
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ EEPROM.h
+
+ Part of the Alpha Five host tools
+
+ Host stand-in for the Arduino EEPROM library: 4 KB of EEPROM, in RAM.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef a5_avrshim_EEPROM_h
+#define a5_avrshim_EEPROM_h
+
+#include <stdint.h>
+
+class EEPROMClass {
+public:
+    uint8_t read(int address) { return cells_[address & 4095]; }
+    void write(int address, uint8_t value) { cells_[address & 4095] = value; }
+    void update(int address, uint8_t value) { write(address, value); }
+
+private:
+    uint8_t cells_[4096];
+};
+
+extern EEPROMClass EEPROM;
+
+#define eeprom_busy_wait()      // (From avr/eeprom.h, which the real EEPROM.h includes.)
+
+#endif
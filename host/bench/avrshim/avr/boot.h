@@ -0,0 +1,36 @@
+/*
+ avr/boot.h
+
+ Part of the Alpha Five host tools
+
+ The self-programming (SPM) commands, for the alphafive flash store.  The
+ store is never written on a host computer.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef a5_avrshim_boot_h
+#define a5_avrshim_boot_h
+
+// SPMCSR values, as on the ATmega644
+#define __BOOT_PAGE_ERASE  0x03
+#define __BOOT_PAGE_WRITE  0x05
+#define __BOOT_PAGE_FILL   0x01
+#define __BOOT_RWW_ENABLE  0x11
+
+#endif
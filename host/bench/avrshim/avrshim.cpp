@@ -0,0 +1,76 @@
+/*
+ avrshim.cpp
+
+ Part of the Alpha Five host tools
+
+ Definitions for the host stand-ins in Arduino.h and EEPROM.h.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <chrono>
+
+#include "Arduino.h"
+#include "EEPROM.h"
+
+volatile uint8_t PORTA, PORTB, PORTC, PORTD, DDRA, DDRB, DDRC, DDRD, PINA, PINB, PINC, PIND;
+volatile uint8_t SPDR, SPSR, SPCR, SREG;
+volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TCCR2A, TCCR2B, TIMSK2, OCR2A, OCR2B, TCNT2;
+volatile uint16_t OCR1A, TCNT1;
+volatile uint8_t TWBR, TWCR, TWSR, TWDR;
+
+HardwareSerial Serial, Serial1;
+EEPROMClass EEPROM;
+
+static std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+unsigned long micros()
+{
+    return (unsigned long) std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long millis()
+{
+    return micros() / 1000;
+}
+
+void delay(unsigned long ms)
+{
+    unsigned long end = millis() + ms;
+    while (millis() < end)
+        ;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    unsigned long end = micros() + us;
+    while (micros() < end)
+        ;
+}
+
+void randomSeed(unsigned long seed)
+{
+    srand((unsigned int) seed);
+}
+
+int analogRead(uint8_t pin)
+{
+    (void) pin;
+    return 0;
+}
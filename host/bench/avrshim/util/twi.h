@@ -0,0 +1,38 @@
+/*
+ util/twi.h
+
+ Part of the Alpha Five host tools
+
+ The TWI status codes, for the alphafive I2C routines.  There is no I2C bus on a
+ host computer; a transfer there simply times out.
+
+ Copyright (c) 2019 Windell H. Oskay.  All right reserved.
+ http://www.evilmadscientist.com/
+
+ This library is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef a5_avrshim_twi_h
+#define a5_avrshim_twi_h
+
+#define TW_STATUS       (TWSR & 0xF8)
+#define TW_START        0x08
+#define TW_REP_START    0x10
+#define TW_MT_SLA_ACK   0x18
+#define TW_MT_DATA_ACK  0x28
+#define TW_MR_SLA_ACK   0x40
+#define TW_READ         1
+
+#endif